@@ -0,0 +1,98 @@
+#version 440
+/*
+ * Resolves the ambient occlusion at full resolution. Half resolution
+ * occlusion is upsampled with a bilateral filter, weighting the four nearest
+ * texels by how close their depth is to the pixel's. The result is blended
+ * with the reprojected history, which is rejected when the depth doesn't
+ * match (disocclusions).
+ */
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// The occlusion and view depth this frame, and the accumulated history.
+layout(binding = 0) uniform sampler2D rawAO;
+layout(binding = 1) uniform sampler2D historyAO;
+
+// Uniforms for the geometry buffer.
+layout(binding = 3) uniform sampler2D gPosition;
+layout(binding = 4) uniform sampler2D gNormal;
+
+// The accumulated occlusion and view depth.
+layout(rg32f, binding = 0) writeonly uniform image2D outputAO;
+
+layout(std430, binding = 2) readonly buffer AOParams
+{
+  mat4 view;
+  mat4 proj;
+  mat4 prevViewProj;
+  vec2 aoSize;
+  vec2 screenSize;
+  float radius;
+  float power;
+  float blend;
+  uint frameIndex;
+  uint downsample;
+  uint historyValid;
+  vec2 historyScale; // The part of the history texture rendered last frame.
+};
+
+void main()
+{
+  ivec2 invoke = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(invoke, ivec2(screenSize))))
+    return;
+
+  vec3 worldNormal = texelFetch(gNormal, invoke, 0).xyz;
+  if (dot(worldNormal, worldNormal) < 0.01)
+  {
+    imageStore(outputAO, invoke, vec4(1.0, 1e20, 0.0, 0.0));
+    return;
+  }
+
+  vec3 worldPos = texelFetch(gPosition, invoke, 0).xyz;
+  float depth = -(view * vec4(worldPos, 1.0)).z;
+
+  float ao;
+  if (downsample == 1u)
+    ao = texelFetch(rawAO, invoke, 0).r;
+  else
+  {
+    // The low resolution texels around the pixel, weighted bilinearly and by
+    // relative depth difference.
+    vec2 lowPos = (vec2(invoke) + 0.5) / float(downsample) - 0.5;
+    ivec2 base = ivec2(floor(lowPos));
+    vec2 f = lowPos - vec2(base);
+    float bilinear[4] = float[](
+      (1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y
+    );
+    ivec2 offsets[4] = ivec2[](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(1, 1));
+
+    float total = 0.0;
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+      ivec2 texel = clamp(base + offsets[i], ivec2(0), ivec2(aoSize) - ivec2(1));
+      vec2 texelAO = texelFetch(rawAO, texel, 0).rg;
+
+      float weight = bilinear[i] / (1e-3 + abs(depth - texelAO.g) / depth);
+      total += weight * texelAO.r;
+      totalWeight += weight;
+    }
+    ao = totalWeight > 0.0 ? total / totalWeight : 1.0;
+  }
+
+  // Reproject into the previous frame.
+  if (historyValid == 1u)
+  {
+    vec4 prevClip = prevViewProj * vec4(worldPos, 1.0);
+    vec2 prevUV = prevClip.xy / prevClip.w * 0.5 + 0.5;
+    if (all(greaterThanEqual(prevUV, vec2(0.0))) && all(lessThanEqual(prevUV, vec2(1.0))))
+    {
+      vec2 history = textureLod(historyAO, prevUV * historyScale, 0.0).rg;
+      if (abs(history.g - prevClip.w) < 0.05 * prevClip.w)
+        ao = mix(history.r, ao, blend);
+    }
+  }
+
+  imageStore(outputAO, invoke, vec4(ao, depth, 0.0, 0.0));
+}
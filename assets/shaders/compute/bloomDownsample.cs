@@ -0,0 +1,61 @@
+#version 440
+/*
+ * Downsamples a level of the bloom chain with the dual filter, the centre and
+ * four diagonal bilinear taps. The first level reads the scene and weights the
+ * taps by their inverse luminance, so single bright pixels don't flicker as
+ * they move.
+ */
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// The scene or the level above.
+layout(binding = 0) uniform sampler2D source;
+
+layout(rgba16f, binding = 0) writeonly uniform image2D outputLevel;
+
+layout(std430, binding = 2) readonly buffer BloomParams
+{
+  vec2 outputSize;
+  vec2 sourceTexel;
+  vec2 sourceScale; // The part of the source covered this frame.
+  float sourceLod;
+  uint firstLevel;
+};
+
+vec3 sampleSource(vec2 uv)
+{
+  // Stay inside the covered part of the source, the rest is stale.
+  uv = clamp(uv, 0.5 * sourceTexel, sourceScale - 0.5 * sourceTexel);
+  return textureLod(source, uv, sourceLod).rgb;
+}
+
+float tapWeight(vec3 colour)
+{
+  if (firstLevel == 0u)
+    return 1.0;
+  return 1.0 / (1.0 + dot(colour, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+void main()
+{
+  ivec2 invoke = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(invoke, ivec2(outputSize))))
+    return;
+
+  vec2 uv = (vec2(invoke) + 0.5) / outputSize * sourceScale;
+  vec2 offsets[4] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));
+
+  vec3 centre = sampleSource(uv);
+  float centreWeight = 4.0 * tapWeight(centre);
+  vec3 total = centre * centreWeight;
+  float totalWeight = centreWeight;
+  for (int i = 0; i < 4; i++)
+  {
+    vec3 tap = sampleSource(uv + offsets[i] * sourceTexel);
+    float weight = tapWeight(tap);
+    total += tap * weight;
+    totalWeight += weight;
+  }
+
+  imageStore(outputLevel, invoke, vec4(total / totalWeight, 1.0));
+}
@@ -0,0 +1,50 @@
+#version 440
+/*
+ * Upsamples a level of the bloom chain with the dual filter tent, four edge
+ * and four diagonal taps, and adds it to the level above.
+ */
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// The bloom chain, read at the level below the output.
+layout(binding = 0) uniform sampler2D source;
+
+layout(rgba16f, binding = 0) uniform image2D outputLevel;
+
+layout(std430, binding = 2) readonly buffer BloomParams
+{
+  vec2 outputSize;
+  vec2 sourceTexel;
+  vec2 sourceScale; // The part of the source covered this frame.
+  float sourceLod;
+  uint firstLevel;
+};
+
+vec3 sampleSource(vec2 uv)
+{
+  uv = clamp(uv, 0.5 * sourceTexel, sourceScale - 0.5 * sourceTexel);
+  return textureLod(source, uv, sourceLod).rgb;
+}
+
+void main()
+{
+  ivec2 invoke = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(invoke, ivec2(outputSize))))
+    return;
+
+  vec2 uv = (vec2(invoke) + 0.5) / outputSize * sourceScale;
+  vec2 h = 0.5 * sourceTexel;
+
+  vec3 up = sampleSource(uv + vec2(-2.0 * h.x, 0.0));
+  up += sampleSource(uv + vec2(2.0 * h.x, 0.0));
+  up += sampleSource(uv + vec2(0.0, -2.0 * h.y));
+  up += sampleSource(uv + vec2(0.0, 2.0 * h.y));
+  up += 2.0 * sampleSource(uv + vec2(-h.x, -h.y));
+  up += 2.0 * sampleSource(uv + vec2(h.x, -h.y));
+  up += 2.0 * sampleSource(uv + vec2(-h.x, h.y));
+  up += 2.0 * sampleSource(uv + vec2(h.x, h.y));
+  up /= 12.0;
+
+  vec3 current = imageLoad(outputLevel, invoke).rgb;
+  imageStore(outputLevel, invoke, vec4(current + up, 1.0));
+}
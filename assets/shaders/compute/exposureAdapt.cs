@@ -0,0 +1,63 @@
+#version 440
+/*
+ * Averages the luminance histogram and adapts the exposure. The average
+ * ignores the pixels in bin 0, which are too dark to count, and moves towards
+ * the measured luminance a fraction at a time. Clears the histogram for the
+ * next frame.
+ */
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 2) readonly buffer ExposureParams
+{
+  vec2 renderSize;
+  float minLogLuminance;
+  float logLuminanceRange;
+  float adaptation; // Fraction of the way to the measured luminance.
+  float compensation; // In stops.
+  uint resetHistory;
+};
+
+layout(std430, binding = 3) buffer ExposureData
+{
+  uint histogram[256];
+  uint lastHistogram[256];
+  float averageLuminance;
+  float exposure;
+};
+
+shared float weightedBins[256];
+
+void main()
+{
+  uint index = gl_LocalInvocationIndex;
+  uint count = histogram[index];
+  lastHistogram[index] = count;
+  histogram[index] = 0u;
+
+  weightedBins[index] = float(count) * float(index);
+  barrier();
+
+  for (uint stride = 128u; stride > 0u; stride >>= 1u)
+  {
+    if (index < stride)
+      weightedBins[index] += weightedBins[index + stride];
+    barrier();
+  }
+
+  if (index == 0u)
+  {
+    float numCounted = max(renderSize.x * renderSize.y - float(count), 1.0);
+    float averageBin = weightedBins[0] / numCounted;
+    float logAverage = (averageBin - 1.0) / 254.0 * logLuminanceRange + minLogLuminance;
+    float measured = exp2(logAverage);
+
+    if (resetHistory == 1u)
+      averageLuminance = measured;
+    else
+      averageLuminance += (measured - averageLuminance) * adaptation;
+
+    // Expose the average luminance to middle grey.
+    exposure = 0.18 / max(averageLuminance, 1e-4) * exp2(compensation);
+  }
+}
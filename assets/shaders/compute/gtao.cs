@@ -0,0 +1,147 @@
+#version 440
+/*
+ * Ground truth ambient occlusion. The hemisphere around each pixel is split
+ * into slices, and the visible arc between the horizons of each slice is
+ * integrated against the cosine lobe of the normal projected onto it:
+ * https://www.activision.com/cdn/research/Practical_Real_Time_Strategies_for_Accurate_Indirect_Occlusion_NEW%20VERSION_COLOR.pdf
+ * The slices rotate every frame so the temporal accumulation in the resolve
+ * pass converges.
+ */
+
+#define PI 3.141592654
+#define HALF_PI 1.570796327
+#define NUM_SLICES 2
+#define NUM_STEPS 4
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// The occlusion and view depth.
+layout(rg32f, binding = 0) writeonly uniform image2D aoImage;
+
+// Uniforms for the geometry buffer.
+layout(binding = 3) uniform sampler2D gPosition;
+layout(binding = 4) uniform sampler2D gNormal;
+
+layout(std430, binding = 2) readonly buffer AOParams
+{
+  mat4 view;
+  mat4 proj;
+  mat4 prevViewProj;
+  vec2 aoSize;
+  vec2 screenSize;
+  float radius;
+  float power;
+  float blend;
+  uint frameIndex;
+  uint downsample;
+  uint historyValid;
+  vec2 historyScale;
+};
+
+// Interleaved gradient noise, offset each frame.
+float noise(vec2 pixel);
+
+void main()
+{
+  ivec2 invoke = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(invoke, ivec2(aoSize))))
+    return;
+
+  ivec2 pixel = min(invoke * int(downsample), ivec2(screenSize) - ivec2(1));
+
+  // Nothing was drawn here, leave it unoccluded.
+  vec3 worldNormal = texelFetch(gNormal, pixel, 0).xyz;
+  if (dot(worldNormal, worldNormal) < 0.01)
+  {
+    imageStore(aoImage, invoke, vec4(1.0, 1e20, 0.0, 0.0));
+    return;
+  }
+
+  vec3 position = (view * vec4(texelFetch(gPosition, pixel, 0).xyz, 1.0)).xyz;
+  vec3 normal = normalize(mat3(view) * worldNormal);
+  vec3 viewV = normalize(-position);
+
+  // The radius in pixels, limited so close ups don't thrash the cache.
+  float pixelRadius = radius * proj[1][1] * 0.5 * screenSize.y / -position.z;
+  pixelRadius = min(pixelRadius, 0.1 * screenSize.y);
+
+  float sliceNoise = noise(vec2(invoke));
+  float stepNoise = fract(sliceNoise + 0.618034 * float(frameIndex % 16u));
+
+  float visibility = 0.0;
+  if (pixelRadius < 1.0)
+    visibility = float(NUM_SLICES);
+  else
+  {
+    for (int slice = 0; slice < NUM_SLICES; slice++)
+    {
+      float phi = (float(slice) + sliceNoise) * PI / float(NUM_SLICES);
+      vec2 omega = vec2(cos(phi), sin(phi));
+
+      // Project the normal onto the slice plane.
+      vec3 direction = vec3(omega, 0.0);
+      vec3 orthoDirection = direction - dot(direction, viewV) * viewV;
+      vec3 axis = normalize(cross(direction, viewV));
+      vec3 projNormal = normal - axis * dot(normal, axis);
+      float projNormalLength = length(projNormal);
+
+      float cosN = clamp(dot(projNormal, viewV) / projNormalLength, 0.0, 1.0);
+      float n = sign(dot(orthoDirection, projNormal)) * acos(cosN);
+
+      // Find the horizon on each side of the slice.
+      float lowHorizonCos0 = cos(n + HALF_PI);
+      float lowHorizonCos1 = cos(n - HALF_PI);
+      float horizonCos0 = lowHorizonCos0;
+      float horizonCos1 = lowHorizonCos1;
+      for (int i = 0; i < NUM_STEPS; i++)
+      {
+        float s = (float(i) + stepNoise) / float(NUM_STEPS);
+        vec2 offset = max(s * s * pixelRadius, 1.0 + float(i)) * omega;
+
+        for (int side = 0; side < 2; side++)
+        {
+          ivec2 samplePixel = ivec2(vec2(pixel) + 0.5 + (side == 0 ? offset : -offset));
+          if (any(lessThan(samplePixel, ivec2(0)))
+              || any(greaterThanEqual(samplePixel, ivec2(screenSize))))
+            continue;
+
+          vec3 sampleNormal = texelFetch(gNormal, samplePixel, 0).xyz;
+          if (dot(sampleNormal, sampleNormal) < 0.01)
+            continue;
+
+          vec3 samplePos = (view * vec4(texelFetch(gPosition, samplePixel, 0).xyz, 1.0)).xyz;
+          vec3 delta = samplePos - position;
+          float distance = length(delta);
+          float shc = dot(delta / distance, viewV);
+
+          // Fade occluders out towards the edge of the radius.
+          float weight = clamp((radius - distance) / (0.4 * radius), 0.0, 1.0);
+          if (side == 0)
+            horizonCos0 = max(horizonCos0, mix(lowHorizonCos0, shc, weight));
+          else
+            horizonCos1 = max(horizonCos1, mix(lowHorizonCos1, shc, weight));
+        }
+      }
+
+      // Clamp the horizons to the hemisphere and integrate the visible arc.
+      float h0 = -acos(horizonCos1);
+      float h1 = acos(horizonCos0);
+      h0 = n + max(h0 - n, -HALF_PI);
+      h1 = n + min(h1 - n, HALF_PI);
+
+      float sinN = sin(n);
+      float arc0 = (cosN + 2.0 * h0 * sinN - cos(2.0 * h0 - n)) / 4.0;
+      float arc1 = (cosN + 2.0 * h1 * sinN - cos(2.0 * h1 - n)) / 4.0;
+      visibility += projNormalLength * (arc0 + arc1);
+    }
+  }
+
+  visibility = pow(clamp(visibility / float(NUM_SLICES), 0.0, 1.0), power);
+  imageStore(aoImage, invoke, vec4(visibility, -position.z, 0.0, 0.0));
+}
+
+float noise(vec2 pixel)
+{
+  pixel += 5.588238 * float(frameIndex % 64u);
+  return fract(52.9829189 * fract(0.06711056 * pixel.x + 0.00583715 * pixel.y));
+}
@@ -0,0 +1,55 @@
+#version 440
+/*
+ * Builds a level of the hierarchical depth pyramid. The first level copies
+ * the depth buffer, every other level keeps the nearest and farthest depth
+ * of the texels it covers in the level above. Odd sized levels fold the
+ * leftover row and column into the last texel so nothing is skipped.
+ */
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D depthMap;
+
+layout(rg32f, binding = 0) readonly uniform image2D inputLevel;
+layout(rg32f, binding = 1) writeonly uniform image2D outputLevel;
+
+layout(std430, binding = 2) readonly buffer PyramidParams
+{
+  ivec2 inputSize;
+  ivec2 outputSize;
+  uint firstLevel;
+};
+
+void main()
+{
+  ivec2 invoke = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(invoke, outputSize)))
+    return;
+
+  if (firstLevel == 1u)
+  {
+    float depth = texelFetch(depthMap, invoke, 0).r;
+    imageStore(outputLevel, invoke, vec4(depth, depth, 0.0, 0.0));
+    return;
+  }
+
+  ivec2 extent = ivec2(2);
+  if ((inputSize.x & 1) != 0 && invoke.x == outputSize.x - 1)
+    extent.x = 3;
+  if ((inputSize.y & 1) != 0 && invoke.y == outputSize.y - 1)
+    extent.y = 3;
+
+  vec2 depths = vec2(1.0, 0.0);
+  for (int y = 0; y < extent.y; y++)
+  {
+    for (int x = 0; x < extent.x; x++)
+    {
+      ivec2 texel = min(2 * invoke + ivec2(x, y), inputSize - ivec2(1));
+      vec2 texelDepths = imageLoad(inputLevel, texel).rg;
+      depths.x = min(depths.x, texelDepths.x);
+      depths.y = max(depths.y, texelDepths.y);
+    }
+  }
+
+  imageStore(outputLevel, invoke, vec4(depths, 0.0, 0.0));
+}
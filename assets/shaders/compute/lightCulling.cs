@@ -0,0 +1,132 @@
+#version 440
+/*
+ * Lists the lights touching each screen tile for forward+ shading. The depth
+ * range of a tile is found from every sample of the pre-pass depth, and the
+ * bounding sphere of each light is tested against the tile's frustum. Each
+ * tile stores its light count followed by the light indices. Tiles without
+ * any geometry get no lights.
+ */
+
+#define TILE_SIZE 16
+#define MAX_LIGHTS_PER_TILE 63
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+layout(binding = 0) uniform sampler2DMS depthMap;
+
+layout(std430, binding = 2) readonly buffer TileCullParams
+{
+  mat4 view;
+  mat4 invProj;
+  uvec2 renderSize;
+  uvec2 numTiles;
+  uint numLights;
+  uint numSamples;
+};
+
+struct TiledLight
+{
+  vec4 position;  // w is the radius.
+  vec4 colour;    // w is the intensity.
+  vec4 direction; // w is the type.
+  vec4 cutoffs;
+};
+
+layout(std430, binding = 5) readonly buffer Lights
+{
+  TiledLight lights[];
+};
+
+layout(std430, binding = 6) writeonly buffer TileLights
+{
+  uint tileLights[];
+};
+
+shared uint minDepthBits;
+shared uint maxDepthBits;
+shared uint tileCount;
+shared uint tileIndices[MAX_LIGHTS_PER_TILE];
+
+// View space position of a point in normalized device coordinates.
+vec3 unproject(vec2 ndc, float depth)
+{
+  vec4 position = invProj * vec4(ndc, depth, 1.0);
+  return position.xyz / position.w;
+}
+
+void main()
+{
+  uvec2 tile = gl_WorkGroupID.xy;
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+  uint localIndex = gl_LocalInvocationIndex;
+
+  if (localIndex == 0u)
+  {
+    minDepthBits = 0xFFFFFFFFu;
+    maxDepthBits = 0u;
+    tileCount = 0u;
+  }
+  barrier();
+
+  // The depths are positive so their bits sort the same as the floats. The
+  // background is skipped, it doesn't need any lights.
+  if (all(lessThan(uvec2(pixel), renderSize)))
+  {
+    for (int i = 0; i < int(numSamples); i++)
+    {
+      float depth = texelFetch(depthMap, pixel, i).r;
+      if (depth < 1.0)
+      {
+        atomicMin(minDepthBits, floatBitsToUint(depth));
+        atomicMax(maxDepthBits, floatBitsToUint(depth));
+      }
+    }
+  }
+  barrier();
+
+  if (minDepthBits <= maxDepthBits)
+  {
+    // The side planes of the tile pass through the eye, the normals face
+    // inwards.
+    vec2 tileMin = vec2(tile * TILE_SIZE) / vec2(renderSize) * 2.0 - 1.0;
+    vec2 tileMax = vec2(min((tile + 1u) * TILE_SIZE, renderSize)) / vec2(renderSize) * 2.0 - 1.0;
+    vec3 c00 = unproject(tileMin, 1.0);
+    vec3 c10 = unproject(vec2(tileMax.x, tileMin.y), 1.0);
+    vec3 c11 = unproject(tileMax, 1.0);
+    vec3 c01 = unproject(vec2(tileMin.x, tileMax.y), 1.0);
+
+    vec3 planes[4];
+    planes[0] = normalize(cross(c00, c01));
+    planes[1] = normalize(cross(c11, c10));
+    planes[2] = normalize(cross(c10, c00));
+    planes[3] = normalize(cross(c01, c11));
+
+    float nearZ = unproject(vec2(0.0), uintBitsToFloat(minDepthBits) * 2.0 - 1.0).z;
+    float farZ = unproject(vec2(0.0), uintBitsToFloat(maxDepthBits) * 2.0 - 1.0).z;
+
+    for (uint i = localIndex; i < numLights; i += TILE_SIZE * TILE_SIZE)
+    {
+      vec3 centre = (view * vec4(lights[i].position.xyz, 1.0)).xyz;
+      float radius = lights[i].position.w;
+
+      bool inside = centre.z - radius <= nearZ && centre.z + radius >= farZ;
+      for (uint p = 0u; p < 4u && inside; p++)
+        inside = dot(planes[p], centre) >= -radius;
+
+      if (inside)
+      {
+        uint slot = atomicAdd(tileCount, 1u);
+        if (slot < MAX_LIGHTS_PER_TILE)
+          tileIndices[slot] = i;
+      }
+    }
+  }
+  barrier();
+
+  uint tileOffset = (tile.x + tile.y * numTiles.x) * (MAX_LIGHTS_PER_TILE + 1u);
+  uint count = min(tileCount, uint(MAX_LIGHTS_PER_TILE));
+  if (localIndex == 0u)
+    tileLights[tileOffset] = count;
+  for (uint i = localIndex; i < count; i += TILE_SIZE * TILE_SIZE)
+    tileLights[tileOffset + 1u + i] = tileIndices[i];
+}
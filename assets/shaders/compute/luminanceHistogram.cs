@@ -0,0 +1,54 @@
+#version 440
+/*
+ * Bins the log luminance of the scene into a histogram for auto-exposure.
+ * Each workgroup counts its pixels in shared memory before adding them to the
+ * global histogram. Bin 0 holds the pixels too dark to count.
+ */
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 0) uniform sampler2D sceneColour;
+
+layout(std430, binding = 2) readonly buffer ExposureParams
+{
+  vec2 renderSize;
+  float minLogLuminance;
+  float logLuminanceRange;
+  float adaptation;
+  float compensation;
+  uint resetHistory;
+};
+
+layout(std430, binding = 3) buffer ExposureData
+{
+  uint histogram[256];
+  uint lastHistogram[256];
+  float averageLuminance;
+  float exposure;
+};
+
+shared uint localBins[256];
+
+void main()
+{
+  localBins[gl_LocalInvocationIndex] = 0u;
+  barrier();
+
+  ivec2 invoke = ivec2(gl_GlobalInvocationID.xy);
+  if (all(lessThan(invoke, ivec2(renderSize))))
+  {
+    vec3 colour = texelFetch(sceneColour, invoke, 0).rgb;
+    float luminance = dot(colour, vec3(0.2126, 0.7152, 0.0722));
+
+    uint bin = 0u;
+    if (luminance > exp2(minLogLuminance))
+    {
+      float t = clamp((log2(luminance) - minLogLuminance) / logLuminanceRange, 0.0, 1.0);
+      bin = uint(t * 254.0 + 1.0);
+    }
+    atomicAdd(localBins[bin], 1u);
+  }
+  barrier();
+
+  atomicAdd(histogram[gl_LocalInvocationIndex], localBins[gl_LocalInvocationIndex]);
+}
@@ -0,0 +1,111 @@
+#version 440
+/*
+ * Culls draws against the hierarchical depth pyramid. The first phase
+ * enables the draws visible last frame. The second phase tests the bounds of
+ * every draw against the pyramid, enables the newly visible draws and stores
+ * the visibility for the next frame.
+ */
+
+layout(local_size_x = 64) in;
+
+struct DrawCommand
+{
+  uint count;
+  uint instanceCount;
+  uint firstIndex;
+  int baseVertex;
+  uint baseInstance;
+};
+
+layout(binding = 0) uniform sampler2D depthPyramid;
+
+layout(std430, binding = 2) readonly buffer CullParams
+{
+  mat4 viewProj;
+  vec2 pyramidSize;
+  uint numDraws;
+  uint phase;
+  uint numLevels;
+};
+
+// World space bounds, the minimum and maximum of each draw.
+layout(std430, binding = 3) readonly buffer DrawBounds
+{
+  vec4 bounds[];
+};
+
+layout(std430, binding = 4) buffer DrawCommands
+{
+  DrawCommand commands[];
+};
+
+layout(std430, binding = 5) buffer DrawVisibility
+{
+  uint visibility[];
+};
+
+// Test the screen space rectangle of the bounds against the farthest depth
+// of the pyramid level where it covers at most 2x2 texels.
+bool isVisible(uint index)
+{
+  vec3 minPos = bounds[2u * index].xyz;
+  vec3 maxPos = bounds[2u * index + 1u].xyz;
+
+  vec2 uvMin = vec2(1.0);
+  vec2 uvMax = vec2(0.0);
+  float nearest = 1.0;
+  for (int i = 0; i < 8; i++)
+  {
+    vec3 corner = mix(minPos, maxPos, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+    vec4 clip = viewProj * vec4(corner, 1.0);
+
+    // Bounds crossing the camera plane can't be projected.
+    if (clip.w <= 0.0)
+      return true;
+
+    vec3 ndc = clip.xyz / clip.w;
+    uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+    uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+    nearest = min(nearest, ndc.z * 0.5 + 0.5);
+  }
+
+  // Outside of the frustum.
+  if (any(greaterThan(uvMin, vec2(1.0))) || any(lessThan(uvMax, vec2(0.0))) || nearest > 1.0)
+    return false;
+
+  uvMin = clamp(uvMin, vec2(0.0), vec2(1.0));
+  uvMax = clamp(uvMax, vec2(0.0), vec2(1.0));
+
+  vec2 extent = (uvMax - uvMin) * pyramidSize;
+  int level = int(ceil(log2(max(max(extent.x, extent.y), 1.0))));
+  level = min(level, int(numLevels) - 1);
+
+  ivec2 levelSize = textureSize(depthPyramid, level);
+  ivec2 texelMin = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - ivec2(1));
+  ivec2 texelMax = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - ivec2(1));
+
+  float farthest = max(max(texelFetch(depthPyramid, texelMin, level).g,
+                           texelFetch(depthPyramid, ivec2(texelMax.x, texelMin.y), level).g),
+                       max(texelFetch(depthPyramid, ivec2(texelMin.x, texelMax.y), level).g,
+                           texelFetch(depthPyramid, texelMax, level).g));
+
+  return nearest <= farthest;
+}
+
+void main()
+{
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= numDraws)
+    return;
+
+  if (phase == 0u)
+  {
+    commands[index].instanceCount = visibility[index];
+    return;
+  }
+
+  // Draws from the first phase are already in the gbuffer.
+  uint visible = isVisible(index) ? 1u : 0u;
+  commands[index].instanceCount = visible == 1u && visibility[index] == 0u ? 1u : 0u;
+  visibility[index] = visible;
+}
@@ -0,0 +1,26 @@
+#version 440
+/*
+ * Resolves the multisampled entity IDs and selection mask of the forward+
+ * path into the gbuffer. IDs can't be averaged, a blend of two IDs is neither,
+ * so the first sample of each pixel is copied.
+ */
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2DMS idTarget;
+
+layout(rgba16f, binding = 0) writeonly uniform image2D gIDMaskColour;
+
+layout(std430, binding = 2) readonly buffer ResolveParams
+{
+  uvec2 renderSize;
+};
+
+void main()
+{
+  ivec2 invoke = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(uvec2(invoke), renderSize)))
+    return;
+
+  imageStore(gIDMaskColour, invoke, texelFetch(idTarget, invoke, 0));
+}
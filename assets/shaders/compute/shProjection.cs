@@ -0,0 +1,88 @@
+#version 440
+/*
+ * A compute shader to project an environment map onto the first three bands
+ * of the real spherical harmonics. Each work group reduces an 8x8 tile of a
+ * cubemap face in shared memory and writes out its partial sums, which are
+ * added up on the CPU.
+*/
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// The environment map to project, bound at a coarse mip.
+layout(rgba16f, binding = 0) uniform readonly imageCube environmentMap;
+
+// The size of the bound mip.
+layout(std140, binding = 2) buffer imageSize
+{
+  vec2 cubemapSize;
+};
+
+// Nine partial sums per work group, the solid angle covered is in w.
+layout(std430, binding = 3) writeonly buffer partialSums
+{
+  vec4 partials[];
+};
+
+shared vec4 groupSums[64][9];
+
+// Function for converting between image coordiantes and world coordiantes.
+vec3 cubeToWorld(vec3 cubeCoord, vec2 cubeSize);
+
+void main()
+{
+  uint local = gl_LocalInvocationIndex;
+
+  // Texel centers, weighted by the solid angle they subtend.
+  vec3 cubeCoord = vec3(vec2(gl_GlobalInvocationID.xy) + vec2(0.5), float(gl_GlobalInvocationID.z));
+  vec3 worldPos = cubeToWorld(cubeCoord, cubemapSize);
+  float weight = 4.0 / (cubemapSize.x * cubemapSize.y * pow(dot(worldPos, worldPos), 1.5));
+
+  vec3 n = normalize(worldPos);
+  vec3 radiance = imageLoad(environmentMap, ivec3(gl_GlobalInvocationID)).rgb * weight;
+
+  groupSums[local][0] = vec4(radiance * 0.282095, weight);
+  groupSums[local][1] = vec4(radiance * 0.488603 * n.y, weight);
+  groupSums[local][2] = vec4(radiance * 0.488603 * n.z, weight);
+  groupSums[local][3] = vec4(radiance * 0.488603 * n.x, weight);
+  groupSums[local][4] = vec4(radiance * 1.092548 * n.x * n.y, weight);
+  groupSums[local][5] = vec4(radiance * 1.092548 * n.y * n.z, weight);
+  groupSums[local][6] = vec4(radiance * 0.315392 * (3.0 * n.z * n.z - 1.0), weight);
+  groupSums[local][7] = vec4(radiance * 1.092548 * n.x * n.z, weight);
+  groupSums[local][8] = vec4(radiance * 0.546274 * (n.x * n.x - n.y * n.y), weight);
+
+  // Tree reduction over the work group.
+  for (uint stride = 32u; stride > 0u; stride >>= 1u)
+  {
+    barrier();
+    if (local < stride)
+    {
+      for (uint i = 0u; i < 9u; i++)
+        groupSums[local][i] += groupSums[local + stride][i];
+    }
+  }
+  barrier();
+
+  if (local < 9u)
+  {
+    uint group = gl_WorkGroupID.x + gl_NumWorkGroups.x * (gl_WorkGroupID.y
+               + gl_NumWorkGroups.y * gl_WorkGroupID.z);
+    partials[9u * group + local] = groupSums[0][local];
+  }
+}
+
+// Same face layout as the other cubemap compute shaders.
+vec3 cubeToWorld(vec3 cubeCoord, vec2 cubeSize)
+{
+  vec2 texCoord = cubeCoord.xy / cubeSize;
+  texCoord = texCoord  * 2.0 - 1.0; // Swap to -1 -> +1
+  switch(int(cubeCoord.z))
+  {
+    case 0: return vec3(1.0, -texCoord.yx); // CUBE_MAP_POS_X
+    case 1: return vec3(-1.0, -texCoord.y, texCoord.x); // CUBE_MAP_NEG_X
+    case 2: return vec3(texCoord.x, 1.0, texCoord.y); // CUBE_MAP_POS_Y
+    case 3: return vec3(texCoord.x, -1.0, -texCoord.y); // CUBE_MAP_NEG_Y
+    case 4: return vec3(texCoord.x, -texCoord.y, 1.0); // CUBE_MAP_POS_Z
+    case 5: return vec3(-texCoord.xy, -1.0); // CUBE_MAP_NEG_Z
+  }
+  return vec3(0.0);
+}
@@ -1,12 +1,14 @@
 #version 440
 /*
- * A fragment shader to compute the prefilter component of the split-sum
- * approach for environmental specular lighting.
+ * A compute shader to compute the prefilter component of the split-sum
+ * approach for environmental specular lighting. Samples are importance
+ * sampled from the GGX lobe and read from the mip of the environment map
+ * which matches the solid angle they cover, so few samples are needed.
 */
 
 #define PI 3.141592654
 
-layout(local_size_x = 32, local_size_y = 32) in;
+layout(local_size_x = 8, local_size_y = 8) in;
 
 // The environment map to prefilter.
 layout(binding = 0) uniform samplerCube environmentMap;
@@ -21,10 +23,13 @@ layout(std140, binding = 2) buffer paramBuff
   vec2 mipSize;
   float roughness;
   float resolution;
+  uint sampleCount;
+  // Zero to sample the base level only, for reference images.
+  uint filterSamples;
 };
 
 // Function for converting between image coordiantes and world coordiantes.
-vec3 cubeToWorld(ivec3 cubeCoord, vec2 cubeSize);
+vec3 cubeToWorld(vec3 cubeCoord, vec2 cubeSize);
 // Function for converting between tangent coordinates and image coordiantes.
 ivec3 texToCube(vec3 texCoord, vec2 cubeSize);
 // Smith-Schlick-Beckmann geometry function.
@@ -34,21 +39,24 @@ vec2 Hammersley(uint i, uint N);
 // Importance sampling of the Smith-Schlick-Beckmann geometry function.
 vec3 SSBImportance(vec2 Xi, vec3 N, float roughness);
 
-// Total number of samples.
-const uint SAMPLE_COUNT = 1024u;
-
 void main()
 {
   ivec3 cubeCoord = ivec3(gl_GlobalInvocationID);
-  vec3 worldPos = cubeToWorld(cubeCoord, mipSize);
+  // The dispatch is rounded up for the small mips.
+  if (any(greaterThanEqual(cubeCoord.xy, ivec2(mipSize))))
+    return;
+
+  vec3 worldPos = cubeToWorld(vec3(cubeCoord) + vec3(0.5, 0.5, 0.0), mipSize);
   vec3 N = normalize(worldPos);
 
   vec3 prefilteredColor = vec3(0.0);
   float totalWeight = 0.0;
 
-  for (uint i = 0u; i < SAMPLE_COUNT; ++i)
+  float saTexel  = 4.0 * PI / (6.0 * resolution * resolution);
+
+  for (uint i = 0u; i < sampleCount; ++i)
   {
-    vec2 Xi = Hammersley(i, SAMPLE_COUNT);
+    vec2 Xi = Hammersley(i, sampleCount);
     vec3 H = SSBImportance(Xi, N, roughness);
     vec3 L  = normalize(2.0 * dot(N, H) * H - N);
 
@@ -60,10 +68,12 @@ void main()
       float HdotV = max(dot(H, N), 0.0);
       float pdf = D * NdotH / (4.0 * HdotV) + 0.0001;
 
-      float saTexel  = 4.0 * PI / (6.0 * resolution * resolution);
-      float saSample = 1.0 / (float(SAMPLE_COUNT) * pdf + 0.0001);
+      float saSample = 1.0 / (float(sampleCount) * pdf + 0.0001);
 
-      float mipLevel = roughness == 0.0 ? 0.0 : 0.5 * log2(saSample / saTexel);
+      // Read from the mip whose texels cover the same solid angle as the
+      // sample, offset by one to smooth out the remaining noise.
+      float mipLevel = roughness == 0.0 || filterSamples == 0u
+                     ? 0.0 : max(0.5 * log2(saSample / saTexel) + 1.0, 0.0);
 
       prefilteredColor += textureLod(environmentMap, L, mipLevel).rgb * NdotL;
       totalWeight      += NdotL;
@@ -76,11 +86,11 @@ void main()
 }
 
 // I need to figure out how to make these branchless one of these days...
-vec3 cubeToWorld(ivec3 cubeCoord, vec2 cubeSize)
+vec3 cubeToWorld(vec3 cubeCoord, vec2 cubeSize)
 {
-  vec2 texCoord = vec2(cubeCoord.xy) / cubeSize;
+  vec2 texCoord = cubeCoord.xy / cubeSize;
   texCoord = texCoord  * 2.0 - 1.0; // Swap to -1 -> +1
-  switch(cubeCoord.z)
+  switch(int(cubeCoord.z))
   {
     case 0: return vec3(1.0, -texCoord.yx); // CUBE_MAP_POS_X
     case 1: return vec3(-1.0, -texCoord.y, texCoord.x); // CUBE_MAP_NEG_X
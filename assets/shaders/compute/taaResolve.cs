@@ -0,0 +1,101 @@
+#version 440
+/*
+ * Resolves temporal anti-aliasing. The history is fetched where the pixel was
+ * last frame using the gbuffer velocity, or the camera motion for the
+ * background, and clamped to the range of the 3x3 neighbourhood this frame in
+ * YCoCg space. Colours are weighted by their inverse luminance while blending
+ * so bright fireflies don't dominate the history.
+ */
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// The lit scene this frame, the gbuffer velocity and the previous result.
+layout(binding = 0) uniform sampler2D sceneColour;
+layout(binding = 1) uniform sampler2D gVelocity;
+layout(binding = 2) uniform sampler2D historyColour;
+
+// The anti-aliased frame.
+layout(rgba16f, binding = 0) writeonly uniform image2D outputColour;
+
+layout(std430, binding = 2) readonly buffer TAAParams
+{
+  mat4 prevViewProj;
+  mat4 invViewProj;
+  vec2 screenSize;
+  float blend;
+  uint historyValid;
+  vec2 historyScale; // The part of the history texture rendered last frame.
+};
+
+vec3 toYCoCg(vec3 rgb)
+{
+  return vec3(dot(rgb, vec3(0.25, 0.5, 0.25)),
+              dot(rgb, vec3(0.5, 0.0, -0.5)),
+              dot(rgb, vec3(-0.25, 0.5, -0.25)));
+}
+
+vec3 toRGB(vec3 yCoCg)
+{
+  return vec3(yCoCg.x + yCoCg.y - yCoCg.z,
+              yCoCg.x + yCoCg.z,
+              yCoCg.x - yCoCg.y - yCoCg.z);
+}
+
+void main()
+{
+  ivec2 invoke = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(invoke, ivec2(screenSize))))
+    return;
+
+  vec3 colour = texelFetch(sceneColour, invoke, 0).rgb;
+  if (historyValid == 0u)
+  {
+    imageStore(outputColour, invoke, vec4(colour, 1.0));
+    return;
+  }
+
+  // The colour range of the neighbourhood.
+  vec3 minColour = vec3(1e20);
+  vec3 maxColour = vec3(-1e20);
+  for (int y = -1; y <= 1; y++)
+  {
+    for (int x = -1; x <= 1; x++)
+    {
+      ivec2 texel = clamp(invoke + ivec2(x, y), ivec2(0), ivec2(screenSize) - ivec2(1));
+      vec3 neighbour = toYCoCg(texelFetch(sceneColour, texel, 0).rgb);
+      minColour = min(minColour, neighbour);
+      maxColour = max(maxColour, neighbour);
+    }
+  }
+
+  // Where the pixel was last frame. The background has no velocity written,
+  // the far plane point is reprojected instead.
+  vec2 uv = (vec2(invoke) + 0.5) / screenSize;
+  vec3 velocity = texelFetch(gVelocity, invoke, 0).xyz;
+  vec2 prevUV;
+  if (velocity.z > 0.5)
+    prevUV = uv - velocity.xy;
+  else
+  {
+    vec4 farPoint = invViewProj * vec4(uv * 2.0 - 1.0, 1.0, 1.0);
+    vec4 prevClip = prevViewProj * vec4(farPoint.xyz / farPoint.w, 1.0);
+    prevUV = prevClip.xy / prevClip.w * 0.5 + 0.5;
+  }
+
+  vec3 result = colour;
+  if (all(greaterThanEqual(prevUV, vec2(0.0))) && all(lessThanEqual(prevUV, vec2(1.0))))
+  {
+    // Stay half a texel inside last frame's area, the rest of the texture is
+    // stale.
+    vec2 texel = 0.5 / vec2(textureSize(historyColour, 0));
+    vec2 historyUV = clamp(prevUV * historyScale, texel, historyScale - texel);
+    vec3 history = toYCoCg(textureLod(historyColour, historyUV, 0.0).rgb);
+    history = toRGB(clamp(history, minColour, maxColour));
+
+    float currWeight = blend / (1.0 + dot(colour, vec3(0.2126, 0.7152, 0.0722)));
+    float histWeight = (1.0 - blend) / (1.0 + dot(history, vec3(0.2126, 0.7152, 0.0722)));
+    result = (colour * currWeight + history * histWeight) / (currWeight + histWeight);
+  }
+
+  imageStore(outputColour, invoke, vec4(result, 1.0));
+}
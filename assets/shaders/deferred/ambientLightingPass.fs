@@ -5,7 +5,6 @@
  */
 
 #define PI 3.141592654
-#define MAX_MIP 4.0
 
 struct Camera
 {
@@ -16,13 +15,16 @@ struct Camera
 // Camera uniform.
 uniform Camera camera;
 
+#include "../include/irradianceSH.glsl"
+
 // Uniforms for ambient lighting.
-layout(binding = 0) uniform samplerCube irradianceMap;
 layout(binding = 1) uniform samplerCube reflectanceMap;
 layout(binding = 2) uniform sampler2D brdfLookUp;
 
 // Uniforms for the geometry buffer.
 uniform vec2 screenSize;
+// The corner of the buffers rendered to this frame.
+uniform vec2 renderSize;
 layout(binding = 3) uniform sampler2D gPosition;
 layout(binding = 4) uniform sampler2D gNormal;
 layout(binding = 5) uniform sampler2D gAlbedo;
@@ -30,6 +32,41 @@ layout(binding = 6) uniform sampler2D gMatProp;
 
 uniform float intensity = 1.0;
 
+// Screen-space ambient occlusion of the scene.
+layout(binding = 8) uniform sampler2D sceneAO;
+uniform uint useSceneAO = 0u;
+
+// Reflection probes, sorted smallest first.
+struct ReflectionProbe
+{
+  vec4 position; // w is the shape, 0 for boxes and 1 for spheres.
+  vec4 extents;  // Half extents or radius, w is the blend distance.
+  uvec4 info;    // x is the layer in the probe array.
+};
+
+layout(std430, binding = 5) readonly buffer ProbeData
+{
+  ReflectionProbe probes[];
+};
+
+// The offset and count of the probes touching each cluster.
+layout(std430, binding = 6) readonly buffer ProbeClusters
+{
+  uvec2 clusters[];
+};
+
+layout(std430, binding = 7) readonly buffer ProbeIndices
+{
+  uint probeIndices[];
+};
+
+layout(binding = 7) uniform samplerCubeArray probeMaps;
+
+uniform uint numProbes = 0u;
+uniform vec3 clusterGrid;
+uniform vec2 clusterDepth; // Near and far plane.
+uniform mat4 cameraView;
+
 // Output colour variable.
 layout(location = 0) out vec4 fragColour;
 
@@ -41,6 +78,8 @@ float SSBGeometry(vec3 N, vec3 L, vec3 V, float roughness);
 vec3 SFresnel(float cosTheta, vec3 F0);
 // Schlick approximation to the Fresnel factor, with roughness!
 vec3 SFresnelR(float cosTheta, vec3 F0, float roughness);
+// Blend the probes around a point over the environment reflection.
+vec3 sampleProbes(vec3 position, vec3 reflection, float roughness, vec3 envSpec);
 
 void main()
 {
@@ -52,6 +91,8 @@ void main()
   float metallic = texture(gMatProp, fTexCoords).r;
   float roughness = texture(gMatProp, fTexCoords).g;
   float ao = texture(gMatProp, fTexCoords).b;
+  if (useSceneAO == 1u)
+    ao *= texelFetch(sceneAO, ivec2(gl_FragCoord.xy), 0).r;
 
   vec3 F0 = mix(vec3(0.04), albedo, metallic);
 
@@ -63,13 +104,17 @@ void main()
   vec3 kd = (vec3(1.0) - ks) * (1.0 - roughness);
 
 	vec3 radiosity = vec3(0.0);
-	vec3 ambientDiff = kd * texture(irradianceMap, normal).rgb * albedo;
-  vec3 ambientSpec = textureLod(reflectanceMap, reflection,
-                                roughness * MAX_MIP).rgb;
+	vec3 ambientDiff = intensity * kd * evaluateIrradiance(normal) * albedo;
+  // The prefilter has as many mips as its size allows.
+  float maxMip = float(textureQueryLevels(reflectanceMap) - 1);
+  vec3 ambientSpec = intensity * textureLod(reflectanceMap, reflection,
+                                            roughness * maxMip).rgb;
+  // Probes are captured with the intensity applied already.
+  ambientSpec = sampleProbes(position, reflection, roughness, ambientSpec);
   vec2 brdfInt = texture(brdfLookUp, vec2(nDotV, roughness)).rg;
   ambientSpec = ambientSpec * (brdfInt.r * ks + brdfInt.g);
 
-	vec3 colour = intensity * (radiosity + (ambientDiff + ambientSpec) * ao);
+	vec3 colour = radiosity + (ambientDiff + ambientSpec) * ao;
 
   fragColour = vec4(colour, 1.0);
 }
@@ -122,3 +167,65 @@ vec3 SFresnelR(float cosTheta, vec3 F0, float roughness)
 {
   return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(max(1.0 - cosTheta, 0.0), 5.0);
 }
+
+// Blend the probes of the pixel's cluster, smallest first. Each probe takes
+// its weight out of what's left, the environment gets the remainder.
+vec3 sampleProbes(vec3 position, vec3 reflection, float roughness, vec3 envSpec)
+{
+  if (numProbes == 0u)
+    return envSpec;
+
+  float viewDepth = -(cameraView * vec4(position, 1.0)).z;
+  uvec3 cluster;
+  cluster.xy = uvec2(gl_FragCoord.xy / renderSize * clusterGrid.xy);
+  cluster.z = uint(max(log(viewDepth / clusterDepth.x) / log(clusterDepth.y / clusterDepth.x)
+                       * clusterGrid.z, 0.0));
+  cluster = min(cluster, uvec3(clusterGrid) - uvec3(1u));
+  uvec2 list = clusters[cluster.x + uint(clusterGrid.x) * (cluster.y + uint(clusterGrid.y) * cluster.z)];
+
+  float maxMip = float(textureQueryLevels(probeMaps) - 1);
+  vec3 result = vec3(0.0);
+  float remaining = 1.0;
+  for (uint i = 0u; i < list.y && remaining > 0.0; i++)
+  {
+    ReflectionProbe probe = probes[probeIndices[list.x + i]];
+    vec3 toPoint = position - probe.position.xyz;
+
+    // Weight falls off over the blend distance inside the volume, and the
+    // reflection ray is intersected with the volume for parallax correction.
+    float weight;
+    vec3 direction;
+    if (probe.position.w < 0.5)
+    {
+      vec3 inside = probe.extents.xyz - abs(toPoint);
+      weight = clamp(min(min(inside.x, inside.y), inside.z) / probe.extents.w, 0.0, 1.0);
+
+      vec3 toMax = (probe.extents.xyz - toPoint) / reflection;
+      vec3 toMin = (-probe.extents.xyz - toPoint) / reflection;
+      vec3 exits = max(toMax, toMin);
+      float t = min(min(exits.x, exits.y), exits.z);
+      direction = toPoint + t * reflection;
+    }
+    else
+    {
+      float radius = probe.extents.x;
+      weight = clamp((radius - length(toPoint)) / probe.extents.w, 0.0, 1.0);
+
+      float b = dot(reflection, toPoint);
+      float c = dot(toPoint, toPoint) - radius * radius;
+      float t = -b + sqrt(max(b * b - c, 0.0));
+      direction = toPoint + t * reflection;
+    }
+
+    if (weight <= 0.0)
+      continue;
+
+    weight *= remaining;
+    vec3 probeSpec = textureLod(probeMaps, vec4(direction, float(probe.info.x)),
+                                roughness * maxMip).rgb;
+    result += weight * probeSpec;
+    remaining -= weight;
+  }
+
+  return result + remaining * envSpec;
+}
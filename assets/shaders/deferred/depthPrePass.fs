@@ -0,0 +1,10 @@
+#version 440
+/*
+ * A fragment shader for the depth pre-pass in deferred rendering. Only the
+ * depth is written.
+ */
+
+void main()
+{
+
+}
@@ -0,0 +1,19 @@
+#version 440
+#extension GL_ARB_shader_draw_parameters : require
+/*
+ * A vertex shader for the depth pre-pass in deferred rendering. Reads the
+ * position only stream of the meshes.
+ */
+
+layout (location = 0) in vec4 vPosition;
+
+#include "../include/instanceData.glsl"
+
+// Must match the geometry pass exactly, it's tested with GL_EQUAL.
+invariant gl_Position;
+
+void main()
+{
+  vec4 worldPosition = instances[gl_BaseInstanceARB].model * vPosition;
+  gl_Position = viewProj * worldPosition;
+}
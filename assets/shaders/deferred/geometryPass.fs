@@ -1,13 +1,16 @@
 #version 440
 /*
- * A fragment shader for the geometry pass in deferred rendering.
+ * A fragment shader for the geometry pass in deferred rendering. Materials
+ * without a map use a permutation with NO_<MAP> defined, which uses the
+ * material constants instead of sampling a placeholder texture.
  */
 
-layout (location = 4) out vec4 gPosition;
-layout (location = 3) out vec4 gNormal;
+layout (location = 0) out vec4 gPosition;
+layout (location = 1) out vec4 gNormal;
 layout (location = 2) out vec4 gAlbedo;
-layout (location = 1) out vec4 gMatProp;
-layout (location = 0) out vec4 gIDMaskColour;
+layout (location = 3) out vec4 gMatProp;
+layout (location = 4) out vec4 gIDMaskColour;
+layout (location = 5) out vec4 gVelocity;
 
 in VERT_OUT
 {
@@ -18,12 +21,19 @@ in VERT_OUT
 	mat3 fTBN;
 } fragIn;
 
+// Clip space positions with this frame's and last frame's unjittered
+// transforms, for the velocity.
+in vec4 fCurrClip;
+in vec4 fPrevClip;
+
 uniform vec3 uAlbedo = vec3(1.0);
 uniform float uMetallic = 1.0;
 uniform float uRoughness = 1.0;
 uniform float uAO = 1.0;
-uniform float uID = 0.0;
-uniform vec3 uMaskColour = vec3(0.0);
+
+// Entity ID and selection mask, from the instance buffer.
+flat in float fID;
+flat in vec3 fMaskColour;
 
 uniform sampler2D albedoMap;
 uniform sampler2D normalMap;
@@ -34,13 +44,36 @@ uniform sampler2D aOcclusionMap;
 void main()
 {
   gPosition = vec4(fragIn.fPosition, 1.0);
+
+#ifdef NO_NORMAL_MAP
+  gNormal = vec4(fragIn.fTBN[2], 1.0);
+#else
   gNormal = vec4(fragIn.fTBN * (texture(normalMap, fragIn.fTexCoords).xyz * 2.0 - 1.0), 1.0);
+#endif
+
+#ifdef NO_ALBEDO_MAP
+  gAlbedo = vec4(pow(uAlbedo, vec3(2.2)), 1.0);
+#else
   gAlbedo = vec4(pow(texture(albedoMap, fragIn.fTexCoords).rgb * uAlbedo, vec3(2.2)), 1.0);
+#endif
+
+  gMatProp = vec4(uMetallic, uRoughness, uAO, 1.0);
+#ifndef NO_METALLIC_MAP
+  gMatProp.r *= texture(metallicMap, fragIn.fTexCoords).r;
+#endif
+#ifndef NO_ROUGHNESS_MAP
+  gMatProp.g *= texture(roughnessMap, fragIn.fTexCoords).r;
+#endif
+#ifndef NO_AO_MAP
+  gMatProp.b *= texture(aOcclusionMap, fragIn.fTexCoords).r;
+#endif
 
-  gMatProp.r = texture(metallicMap, fragIn.fTexCoords).r * uMetallic;
-  gMatProp.g = texture(roughnessMap, fragIn.fTexCoords).r * uRoughness;
-  gMatProp.b = texture(aOcclusionMap, fragIn.fTexCoords).r * uAO;
-  gMatProp.a = 1.0;
+	gIDMaskColour = vec4(fMaskColour, fID);
 
-	gIDMaskColour = vec4(uMaskColour, uID);
+  // Screen space motion in UV units since last frame. The third component
+  // marks the pixels covered by geometry (the buffer is cleared to zero), the
+  // background is reprojected from the camera motion instead.
+  vec2 curr = fCurrClip.xy / fCurrClip.w;
+  vec2 prev = fPrevClip.xy / fPrevClip.w;
+  gVelocity = vec4((curr - prev) * 0.5, 1.0, 1.0);
 }
@@ -1,6 +1,8 @@
 #version 440
+#extension GL_ARB_shader_draw_parameters : require
 /*
- * A vertex shader for the geometry pass in deferred rendering.
+ * A vertex shader for the geometry pass in deferred rendering. The transforms
+ * of each draw come from the instance buffer.
  */
 
 layout (location = 0) in vec4 vPosition;
@@ -10,9 +12,10 @@ layout (location = 3) in vec2 vTexCoord;
 layout (location = 4) in vec3 vTangent;
 layout (location = 5) in vec3 vBitangent;
 
-uniform mat4 mVP;
-uniform mat3 normalMat;
-uniform mat4 model;
+#include "../include/instanceData.glsl"
+
+// Must match the depth pre-pass exactly, it's tested with GL_EQUAL.
+invariant gl_Position;
 
 // Vertex properties for shading.
 out VERT_OUT
@@ -24,18 +27,36 @@ out VERT_OUT
  	mat3 fTBN;
 } vertOut;
 
+out vec4 fCurrClip;
+out vec4 fPrevClip;
+
+// Entity ID and selection mask for picking and outlines.
+flat out float fID;
+flat out vec3 fMaskColour;
+
 void main()
 {
+  Instance instance = instances[gl_BaseInstanceARB];
+  mat3 normalMat = mat3(instance.normalMat);
+
   // Tangent to world matrix calculation.
- 	vec3 T = normalize(vec3(model * vec4(vTangent, 0.0)));
- 	vec3 N = normalize(vec3(model * vec4(vNormal, 0.0)));
+ 	vec3 T = normalize(vec3(instance.model * vec4(vTangent, 0.0)));
+ 	vec3 N = normalize(normalMat * vNormal);
  	T = normalize(T - dot(T, N) * N);
  	vec3 B = cross(N, T);
 
- 	gl_Position = mVP * vPosition;
-  vertOut.fPosition = (model * vPosition).xyz;
+  // Same expression as the depth pre-pass.
+  vec4 worldPosition = instances[gl_BaseInstanceARB].model * vPosition;
+ 	gl_Position = viewProj * worldPosition;
+  vertOut.fPosition = worldPosition.xyz;
  	vertOut.fNormal = N;
  	vertOut.fColour = vColour;
  	vertOut.fTexCoords = vTexCoord;
  	vertOut.fTBN = mat3(T, B, N);
+
+  fCurrClip = unjitteredViewProj * worldPosition;
+  fPrevClip = prevViewProj * (instance.prevModel * vPosition);
+
+  fID = float(instance.info.x);
+  fMaskColour = vec3(float(instance.info.y));
 }
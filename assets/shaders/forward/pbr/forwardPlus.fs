@@ -0,0 +1,189 @@
+#version 440
+/*
+ * Lighting fragment shader for the forward+ path. Shades with the
+ * environment, the directional lights and the point and spot lights listed
+ * for the fragment's screen tile. Drawn after a depth pre-pass, so every
+ * visible fragment is shaded once. Materials without a map use a permutation
+ * with NO_<MAP> defined.
+ */
+
+#define PI 3.141592654
+#define THRESHHOLD 0.00005
+#define MAX_DIR_LIGHTS 4
+#define TILE_SIZE 16
+#define MAX_LIGHTS_PER_TILE 63
+
+in VERT_OUT
+{
+	vec3 fNormal;
+	vec3 fPosition;
+	vec3 fColour;
+  vec2 fTexCoords;
+	mat3 fTBN;
+} fragIn;
+
+struct Camera
+{
+  vec3 position;
+  vec3 viewDir;
+};
+
+// Camera uniform.
+uniform Camera camera;
+
+uniform vec3 uAlbedo = vec3(1.0);
+uniform float uMetallic = 1.0;
+uniform float uRoughness = 1.0;
+uniform float uAO = 1.0;
+
+// Entity ID and selection mask, from the instance buffer.
+flat in float fID;
+flat in vec3 fMaskColour;
+
+uniform sampler2D albedoMap;
+uniform sampler2D normalMap;
+uniform sampler2D roughnessMap;
+uniform sampler2D metallicMap;
+uniform sampler2D aOcclusionMap;
+
+#include "../../include/irradianceSH.glsl"
+
+// Uniforms for ambient lighting.
+uniform samplerCube reflectanceMap;
+uniform sampler2D brdfLookUp;
+uniform float intensity = 1.0;
+
+// Directional lights, without shadows.
+uniform uint numDirLights = 0u;
+uniform vec3 lDirection[MAX_DIR_LIGHTS];
+uniform vec3 lColour[MAX_DIR_LIGHTS];
+uniform float lIntensity[MAX_DIR_LIGHTS];
+
+// Point and spot lights, and the lights of each screen tile.
+struct TiledLight
+{
+  vec4 position;  // w is the radius.
+  vec4 colour;    // w is the intensity.
+  vec4 direction; // w is 0 for point lights and 1 for spot lights.
+  vec4 cutoffs;   // Cosines of the inner and outer cone angles.
+};
+
+layout(std430, binding = 5) readonly buffer Lights
+{
+  TiledLight lights[];
+};
+
+layout(std430, binding = 6) readonly buffer TileLights
+{
+  uint tileLights[];
+};
+
+uniform uint numTilesX = 1u;
+
+// Output colour variables.
+layout(location = 0) out vec4 fragColour;
+layout(location = 1) out vec4 gIDMaskColour;
+
+#include "../../include/pbrBRDF.glsl"
+
+// Radiance reflected from a light in the direction to the light.
+vec3 evaluateLight(vec3 light, vec3 radiance, vec3 normal, vec3 view,
+                   vec3 albedo, float metallic, float roughness, vec3 F0);
+
+void main()
+{
+#ifdef NO_NORMAL_MAP
+  vec3 normal = normalize(fragIn.fTBN[2]);
+#else
+  vec3 normal = normalize(fragIn.fTBN * (texture(normalMap, fragIn.fTexCoords).xyz * 2.0 - 1.0));
+#endif
+
+#ifdef NO_ALBEDO_MAP
+  vec3 albedo = pow(uAlbedo, vec3(2.2));
+#else
+  vec3 albedo = pow(texture(albedoMap, fragIn.fTexCoords).rgb * uAlbedo, vec3(2.2));
+#endif
+
+  float metallic = uMetallic;
+  float roughness = uRoughness;
+  float ao = uAO;
+#ifndef NO_METALLIC_MAP
+  metallic *= texture(metallicMap, fragIn.fTexCoords).r;
+#endif
+#ifndef NO_ROUGHNESS_MAP
+  roughness *= texture(roughnessMap, fragIn.fTexCoords).r;
+#endif
+#ifndef NO_AO_MAP
+  ao *= texture(aOcclusionMap, fragIn.fTexCoords).r;
+#endif
+
+  vec3 position = fragIn.fPosition;
+  vec3 F0 = mix(vec3(0.04), albedo, metallic);
+  vec3 view = normalize(position - camera.position);
+
+  // Ambient lighting, same as the deferred ambient pass without the probes.
+  vec3 reflection = reflect(view, normal);
+  float nDotV = abs(dot(normal, -view));
+  vec3 ks = SFresnelR(nDotV, F0, roughness);
+  vec3 kd = (vec3(1.0) - ks) * (1.0 - roughness);
+
+  vec3 ambientDiff = intensity * kd * evaluateIrradiance(normal) * albedo;
+  float maxMip = float(textureQueryLevels(reflectanceMap) - 1);
+  vec3 ambientSpec = intensity * textureLod(reflectanceMap, reflection,
+                                            roughness * maxMip).rgb;
+  vec2 brdfInt = texture(brdfLookUp, vec2(nDotV, roughness)).rg;
+  ambientSpec = ambientSpec * (brdfInt.r * ks + brdfInt.g);
+
+  vec3 colour = (ambientDiff + ambientSpec) * ao;
+
+  for (uint i = 0u; i < min(numDirLights, uint(MAX_DIR_LIGHTS)); i++)
+    colour += evaluateLight(normalize(lDirection[i]), lColour[i] * lIntensity[i],
+                            normal, view, albedo, metallic, roughness, F0);
+
+  // The lights of this tile, with a windowed inverse square falloff to zero at
+  // the radius.
+  uvec2 tile = uvec2(gl_FragCoord.xy) / uint(TILE_SIZE);
+  uint tileOffset = (tile.x + tile.y * numTilesX) * (MAX_LIGHTS_PER_TILE + 1u);
+  uint count = tileLights[tileOffset];
+  for (uint i = 0u; i < count; i++)
+  {
+    TiledLight tLight = lights[tileLights[tileOffset + 1u + i]];
+
+    vec3 toLight = tLight.position.xyz - position;
+    float distance = length(toLight);
+    vec3 light = toLight / max(distance, THRESHHOLD);
+
+    float window = clamp(1.0 - pow(distance / max(tLight.position.w, THRESHHOLD), 4.0), 0.0, 1.0);
+    float attenuation = window * window / (distance * distance + 1.0);
+    if (tLight.direction.w > 0.5)
+    {
+      float theta = dot(light, normalize(tLight.direction.xyz));
+      attenuation *= clamp((theta - tLight.cutoffs.y)
+                           / max(tLight.cutoffs.x - tLight.cutoffs.y, THRESHHOLD), 0.0, 1.0);
+    }
+
+    if (attenuation > 0.0)
+      colour += evaluateLight(light, tLight.colour.rgb * tLight.colour.w * attenuation,
+                              normal, view, albedo, metallic, roughness, F0);
+  }
+
+  fragColour = vec4(colour, 1.0);
+  gIDMaskColour = vec4(fMaskColour, fID);
+}
+
+// Same as the deferred directional pass.
+vec3 evaluateLight(vec3 light, vec3 radiance, vec3 normal, vec3 view,
+                   vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+  vec3 halfWay = normalize(view + light);
+
+  float NDF = TRDistribution(normal, halfWay, roughness);
+  float G = SSBGeometry(normal, view, light, roughness);
+  vec3 F = SFresnel(max(dot(halfWay, view), THRESHHOLD), F0);
+
+  vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+  float den = 4.0 * max(dot(normal, view), THRESHHOLD) * max(dot(normal, light), THRESHHOLD);
+  vec3 spec = NDF * G * F / max(den, THRESHHOLD);
+
+  return (kD * albedo / PI + spec) * radiance * max(dot(normal, light), THRESHHOLD);
+}
@@ -4,7 +4,6 @@
  * techniques. Uses textures for material properties.
  */
 #define PI 3.141592654
-#define MAX_MIP 4.0
 
 struct FragMaterial
 {
@@ -42,8 +41,9 @@ uniform float metallic = 0.0;
 uniform float aOcclusion = 1.0;
 uniform float uID = -1.0;
 
+#include "../../include/irradianceSH.glsl"
+
 // Uniforms for ambient lighting.
-uniform samplerCube irradianceMap;
 uniform samplerCube reflectanceMap;
 uniform sampler2D brdfLookUp;
 
@@ -79,9 +79,11 @@ void main()
   vec3 kd = (vec3(1.0) - ks) * (1.0 - frag.roughness);
 
 	vec3 radiosity = vec3(0.0);
-	vec3 ambientDiff = kd * texture(irradianceMap, frag.normal).rgb * frag.albedo;
+	vec3 ambientDiff = kd * evaluateIrradiance(frag.normal) * frag.albedo;
+  // The prefilter has as many mips as its size allows.
+  float maxMip = float(textureQueryLevels(reflectanceMap) - 1);
   vec3 ambientSpec = textureLod(reflectanceMap, reflection,
-                                frag.roughness * MAX_MIP).rgb;
+                                frag.roughness * maxMip).rgb;
   vec2 brdfInt = texture(brdfLookUp, vec2(nDotV, frag.roughness)).rg;
   ambientSpec = ambientSpec * (brdfInt.r * ks + brdfInt.g);
 
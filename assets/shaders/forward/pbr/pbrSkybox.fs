@@ -1,7 +1,5 @@
 #version 440
 
-#define MAX_MIP 4.0
-
 uniform samplerCube skybox;
 
 uniform float roughness = 0.0;
@@ -16,6 +14,8 @@ layout(location = 0) out vec4 fragColour;
 
 void main()
 {
-  vec3 envColor = textureLod(skybox, fragIn.fTexCoords, roughness * MAX_MIP).rgb;
+  // The prefilter has as many mips as its size allows.
+  float maxMip = float(textureQueryLevels(skybox) - 1);
+  vec3 envColor = textureLod(skybox, fragIn.fTexCoords, roughness * maxMip).rgb;
   fragColour = vec4(envColor, 1.0);
 }
@@ -4,7 +4,6 @@
  * techniques. Uses textures for material properties.
  */
 #define PI 3.141592654
-#define MAX_MIP 4.0
 
 struct FragMaterial
 {
@@ -40,6 +39,7 @@ uniform vec3 uAlbedo = vec3(1.0);
 uniform float uMetallic = 1.0;
 uniform float uRoughness = 1.0;
 uniform float uAO = 1.0;
+uniform float uOpacity = 1.0;
 uniform float uID = -1.0;
 uniform vec3 uMaskColour = vec3(0.0);
 
@@ -50,8 +50,9 @@ uniform sampler2D roughnessMap;
 uniform sampler2D normalMap;
 uniform sampler2D aOcclusionMap;
 
+#include "../../include/irradianceSH.glsl"
+
 // Uniforms for ambient lighting.
-uniform samplerCube irradianceMap;
 uniform samplerCube reflectanceMap;
 uniform sampler2D brdfLookUp;
 
@@ -88,9 +89,11 @@ void main()
   vec3 kd = (vec3(1.0) - ks) * (1.0 - frag.roughness);
 
 	vec3 radiosity = vec3(0.0);
-	vec3 ambientDiff = kd * texture(irradianceMap, frag.normal).rgb * frag.albedo;
+	vec3 ambientDiff = kd * evaluateIrradiance(frag.normal) * frag.albedo;
+  // The prefilter has as many mips as its size allows.
+  float maxMip = float(textureQueryLevels(reflectanceMap) - 1);
   vec3 ambientSpec = textureLod(reflectanceMap, reflection,
-                                frag.roughness * MAX_MIP).rgb;
+                                frag.roughness * maxMip).rgb;
   vec2 brdfInt = texture(brdfLookUp, vec2(nDotV, frag.roughness)).rg;
   ambientSpec = ambientSpec * (brdfInt.r * ks + brdfInt.g);
 
@@ -100,7 +103,7 @@ void main()
 	// Tone map, gamma correction.
 	colour = pow(colour, vec3(1.0 / 2.2));
 
-  fragColour = vec4(colour.xyz, 1.0);
+  fragColour = vec4(colour.xyz, uOpacity);
 	gIDMaskColour = vec4(uMaskColour, uID);
 }
 
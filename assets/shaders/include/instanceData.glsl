@@ -0,0 +1,22 @@
+/*
+ * Per-instance transforms, kept in a persistent buffer and indexed by the base
+ * instance of each draw. Needs GL_ARB_shader_draw_parameters.
+ */
+
+struct Instance
+{
+  mat4 model;
+  mat4 prevModel;
+  mat4 normalMat; // The upper 3x3 is the normal matrix.
+  uvec4 info;     // x is the entity ID + 1, y is the selection mask.
+};
+
+// The camera transforms are shared by every instance. The view-projection is
+// jittered, the other two aren't.
+layout(std430, binding = 1) readonly buffer InstanceData
+{
+  mat4 viewProj;
+  mat4 unjitteredViewProj;
+  mat4 prevViewProj;
+  Instance instances[];
+};
@@ -0,0 +1,26 @@
+/*
+ * Diffuse irradiance stored as spherical harmonics, shared by every pass
+ * which lights with the environment.
+ */
+
+// Diffuse irradiance as the first nine spherical harmonics, convolved with the
+// cosine lobe and pre-multiplied by the basis constants.
+layout(std140, binding = 4) uniform IrradianceSH
+{
+  vec4 irradianceSH[9];
+};
+
+// Evaluate the irradiance spherical harmonics in the direction n.
+vec3 evaluateIrradiance(vec3 n)
+{
+  vec3 result = irradianceSH[0].rgb
+              + irradianceSH[1].rgb * n.y
+              + irradianceSH[2].rgb * n.z
+              + irradianceSH[3].rgb * n.x
+              + irradianceSH[4].rgb * n.x * n.y
+              + irradianceSH[5].rgb * n.y * n.z
+              + irradianceSH[6].rgb * (3.0 * n.z * n.z - 1.0)
+              + irradianceSH[7].rgb * n.x * n.z
+              + irradianceSH[8].rgb * (n.x * n.x - n.y * n.y);
+  return max(result, vec3(0.0));
+}
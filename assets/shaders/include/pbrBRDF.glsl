@@ -0,0 +1,60 @@
+/*
+ * The terms of the Cook-Torrance BRDF, shared by the passes which shade
+ * forward.
+ */
+
+#ifndef PI
+#define PI 3.141592654
+#endif
+#ifndef THRESHHOLD
+#define THRESHHOLD 0.00005
+#endif
+
+// Trowbridge-Reitz distribution function.
+float TRDistribution(vec3 N, vec3 H, float roughness)
+{
+  float alpha = roughness * roughness;
+  float a2 = alpha * alpha;
+  float NdotH = max(dot(N, H), THRESHHOLD);
+  float NdotH2 = NdotH * NdotH;
+
+  float nom = a2;
+  float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+  denom = PI * denom * denom;
+
+  return nom / denom;
+}
+
+// Schlick-Beckmann geometry function.
+float Geometry(float NdotV, float roughness)
+{
+  float k = (roughness * roughness) / 8.0;
+
+  float nom   = NdotV;
+  float denom = NdotV * (1.0 - k) + k;
+
+  return nom / denom;
+}
+
+// Smith's modified geometry function.
+float SSBGeometry(vec3 N, vec3 L, vec3 V, float roughness)
+{
+  float NdotV = max(dot(N, V), THRESHHOLD);
+  float NdotL = max(dot(N, L), THRESHHOLD);
+  float g2 = Geometry(NdotV, roughness);
+  float g1 = Geometry(NdotL, roughness);
+
+  return g1 * g2;
+}
+
+// Schlick approximation to the Fresnel factor.
+vec3 SFresnel(float cosTheta, vec3 F0)
+{
+  return F0 + (1.0 - F0) * pow(max(1.0 - cosTheta, THRESHHOLD), 5.0);
+}
+
+// Schlick approximation to the Fresnel factor, with roughness!
+vec3 SFresnelR(float cosTheta, vec3 F0, float roughness)
+{
+  return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(max(1.0 - cosTheta, THRESHHOLD), 5.0);
+}
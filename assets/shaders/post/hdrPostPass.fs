@@ -1,23 +1,53 @@
 #version 440
 
 uniform vec2 screenSize;
+// The part of the input textures rendered to this frame.
+uniform vec2 uvScale = vec2(1.0);
 uniform float gamma = 2.2;
 
 layout(binding = 0) uniform sampler2D screenColour;
 layout(binding = 1) uniform sampler2D entityIDs;
 
+// Bloom, blended into the scene before exposure.
+layout(binding = 2) uniform sampler2D bloom;
+uniform uint useBloom = 0u;
+uniform float bloomIntensity = 0.04;
+uniform float bloomLevels = 1.0;
+uniform vec2 bloomScale = vec2(1.0);
+
+// Exposure from the luminance histogram, or a fixed exposure.
+layout(std430, binding = 3) readonly buffer ExposureData
+{
+  uint histogram[256];
+  uint lastHistogram[256];
+  float averageLuminance;
+  float exposure;
+};
+uniform uint useAutoExposure = 0u;
+uniform float fixedExposure = 1.0;
+
 // Output colour variable.
-layout(location = 1) out vec4 fragColour;
-layout(location = 0) out float fragID;
+layout(location = 0) out vec4 fragColour;
+layout(location = 1) out float fragID;
 
 void main()
 {
-  vec2 fTexCoords = gl_FragCoord.xy / screenSize;
+  // Keep the bilinear upscale from blending in texels outside the rendered
+  // area.
+  vec2 fTexCoords = gl_FragCoord.xy / screenSize * uvScale;
+  fTexCoords = min(fTexCoords, uvScale - 0.5 / vec2(textureSize(screenColour, 0)));
 
   vec3 colour = texture(screenColour, fTexCoords).rgb;
+  if (useBloom == 1u)
+  {
+    vec2 bloomCoords = gl_FragCoord.xy / screenSize * bloomScale;
+    vec3 bloomColour = textureLod(bloom, bloomCoords, 0.0).rgb / bloomLevels;
+    colour = mix(colour, bloomColour, bloomIntensity);
+  }
+  colour *= useAutoExposure == 1u ? exposure : fixedExposure;
 
   colour = colour / (colour + vec3(1.0));
   colour = pow(colour, vec3(1.0 / gamma));
   fragColour = vec4(colour, 1.0);
-  fragID = texture(entityIDs, fTexCoords).a;
+  fragID = texelFetch(entityIDs, ivec2(fTexCoords * vec2(textureSize(entityIDs, 0))), 0).a;
 }
@@ -1,17 +1,18 @@
 #version 440
 
 uniform vec2 screenSize;
+uniform vec2 uvScale = vec2(1.0);
 layout(binding = 0) uniform sampler2D entity;
 
-layout(location = 1) out vec4 fragColour;
+layout(location = 0) out vec4 fragColour;
 
 void main()
 {
-  vec2 fTexCoords = gl_FragCoord.xy / screenSize;
+  vec2 fTexCoords = gl_FragCoord.xy / screenSize * uvScale;
 
   float kernel[9];
-  float w = 1.0 / screenSize.x;
-  float h = 1.0 / screenSize.y;
+  float w = 1.0 / float(textureSize(entity, 0).x);
+  float h = 1.0 / float(textureSize(entity, 0).y);
 
   kernel[0] = texture2D(entity, fTexCoords + vec2(-w, -h)).r;
 	kernel[1] = texture2D(entity, fTexCoords + vec2(0.0, -h)).r;
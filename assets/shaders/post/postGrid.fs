@@ -8,9 +8,11 @@ in VERT_OUT
 } fragIn;
 
 uniform mat4 viewProj;
+uniform vec2 screenSize;
+uniform vec2 uvScale = vec2(1.0);
 layout(binding = 0) uniform sampler2DShadow gDepth;
 
-layout(location = 1) out vec4 fragColour;
+layout(location = 0) out vec4 fragColour;
 
 // Helper functions.
 vec3 unProject(vec3 position, mat4 invVP);
@@ -36,7 +38,7 @@ void main()
   vec4 xyFragClipPos = viewProj * vec4(xyFragPos3D, 1.0);
   float xyFragDepth = 0.5 * (xyFragClipPos.z / xyFragClipPos.w) + 0.5;
   // Fetch the scene depth test for both planes.
-  vec2 fTexCoords = gl_FragCoord.xy / textureSize(gDepth, 0);
+  vec2 fTexCoords = gl_FragCoord.xy / screenSize * uvScale;
   float xzSceneDepth = texture(gDepth, vec3(fTexCoords, xzFragDepth)).r;
   float xySceneDepth = texture(gDepth, vec3(fTexCoords, xyFragDepth)).r;
 
@@ -0,0 +1,60 @@
+#version 440
+/*
+ * A fragment shader for capturing the scene into a reflection probe. Only the
+ * diffuse lighting is captured, from the environment and the directional
+ * lights, since anything view dependent would be wrong from every other
+ * viewpoint.
+ */
+
+#define PI 3.141592654
+#define MAX_DIR_LIGHTS 4
+
+in VERT_OUT
+{
+	vec3 fNormal;
+	vec3 fPosition;
+	vec3 fColour;
+  vec2 fTexCoords;
+	mat3 fTBN;
+} fragIn;
+
+uniform vec3 uAlbedo = vec3(1.0);
+uniform float uMetallic = 1.0;
+uniform float uAO = 1.0;
+
+uniform sampler2D albedoMap;
+uniform sampler2D normalMap;
+uniform sampler2D metallicMap;
+uniform sampler2D aOcclusionMap;
+
+#include "../include/irradianceSH.glsl"
+
+uniform float intensity = 1.0;
+
+// Directional lights.
+uniform uint numDirLights = 0u;
+uniform vec3 lDirection[MAX_DIR_LIGHTS];
+uniform vec3 lColour[MAX_DIR_LIGHTS];
+uniform float lIntensity[MAX_DIR_LIGHTS];
+
+// Output colour variable.
+layout(location = 0) out vec4 fragColour;
+
+void main()
+{
+  vec3 normal = normalize(fragIn.fTBN * (texture(normalMap, fragIn.fTexCoords).xyz * 2.0 - 1.0));
+  vec3 albedo = pow(texture(albedoMap, fragIn.fTexCoords).rgb * uAlbedo, vec3(2.2));
+  float metallic = texture(metallicMap, fragIn.fTexCoords).r * uMetallic;
+  float ao = texture(aOcclusionMap, fragIn.fTexCoords).r * uAO;
+
+  vec3 diffuse = albedo * (1.0 - metallic);
+
+  vec3 colour = intensity * diffuse * evaluateIrradiance(normal) * ao;
+  for (uint i = 0u; i < min(numDirLights, uint(MAX_DIR_LIGHTS)); i++)
+  {
+    float nDotL = max(dot(normal, normalize(lDirection[i])), 0.0);
+    colour += diffuse / PI * lColour[i] * lIntensity[i] * nDotL;
+  }
+
+  fragColour = vec4(colour, 1.0);
+}
@@ -0,0 +1,89 @@
+#version 440
+/*
+ * Composites the transparent fragments over the lit scene. Outputs the
+ * transparent colour and the transmittance of the pixel, blended as
+ * colour + scene * transmittance. Resolves the per-pixel linked lists if
+ * LINKED_LIST is defined, or the weighted blended accumulation otherwise.
+ */
+
+#ifdef LINKED_LIST
+#define MAX_FRAGMENTS 16
+
+layout(binding = 0, r32ui) uniform readonly uimage2D headPointers;
+
+layout(std430, binding = 8) readonly buffer FragmentNodes
+{
+  uint numNodes;
+  uint maxNodes;
+  uvec2 padding;
+  uvec4 nodes[];
+};
+#else
+layout(binding = 0) uniform sampler2D accumulation;
+layout(binding = 1) uniform sampler2D revealage;
+#endif
+
+// Output colour variable.
+layout(location = 0) out vec4 fragColour;
+
+void main()
+{
+  ivec2 coords = ivec2(gl_FragCoord.xy);
+
+#ifdef LINKED_LIST
+  // Gather the nearest fragments of the pixel, sorted by insertion far to
+  // near. Fragments past the limit which are further away are dropped.
+  uvec4 fragments[MAX_FRAGMENTS];
+  uint count = 0u;
+  uint node = imageLoad(headPointers, coords).r;
+  if (node == 0xFFFFFFFFu)
+    discard;
+
+  while (node != 0xFFFFFFFFu && node < maxNodes)
+  {
+    uvec4 fragment = nodes[node];
+    node = fragment.w;
+
+    float depth = uintBitsToFloat(fragment.z);
+    if (count == MAX_FRAGMENTS)
+    {
+      // Replace the furthest fragment if this one is nearer.
+      if (depth >= uintBitsToFloat(fragments[0].z))
+        continue;
+      count--;
+      for (uint i = 0u; i < count; i++)
+        fragments[i] = fragments[i + 1u];
+    }
+
+    uint i = count;
+    while (i > 0u && uintBitsToFloat(fragments[i - 1u].z) < depth)
+    {
+      fragments[i] = fragments[i - 1u];
+      i--;
+    }
+    fragments[i] = fragment;
+    count++;
+  }
+
+  // Blend the fragments back to front.
+  vec3 colour = vec3(0.0);
+  float transmittance = 1.0;
+  for (uint i = 0u; i < count; i++)
+  {
+    vec2 rg = unpackHalf2x16(fragments[i].x);
+    vec2 ba = unpackHalf2x16(fragments[i].y);
+    colour = mix(colour, vec3(rg, ba.x), ba.y);
+    transmittance *= 1.0 - ba.y;
+  }
+
+  fragColour = vec4(colour, transmittance);
+#else
+  float reveal = texelFetch(revealage, coords, 0).r;
+  if (reveal >= 1.0)
+    discard;
+
+  vec4 accum = texelFetch(accumulation, coords, 0);
+  vec3 average = accum.rgb / max(accum.a, 1e-5);
+  fragColour = vec4(average * (1.0 - reveal), reveal);
+#endif
+}
@@ -0,0 +1,165 @@
+#version 440
+/*
+ * A fragment shader for transparent surfaces, shaded forward with the
+ * environment and the directional lights. The fragments are accumulated for
+ * weighted blended order independent transparency, or inserted into the
+ * per-pixel linked lists if LINKED_LIST is defined. Materials without a map
+ * use a permutation with NO_<MAP> defined.
+ */
+
+#define PI 3.141592654
+#define THRESHHOLD 0.00005
+#define MAX_DIR_LIGHTS 4
+
+#ifdef LINKED_LIST
+// Only the visible fragments take a node.
+layout(early_fragment_tests) in;
+#endif
+
+in VERT_OUT
+{
+	vec3 fNormal;
+	vec3 fPosition;
+	vec3 fColour;
+  vec2 fTexCoords;
+	mat3 fTBN;
+} fragIn;
+
+struct Camera
+{
+  vec3 position;
+  vec3 viewDir;
+};
+
+// Camera uniform.
+uniform Camera camera;
+
+uniform vec3 uAlbedo = vec3(1.0);
+uniform float uMetallic = 1.0;
+uniform float uRoughness = 1.0;
+uniform float uAO = 1.0;
+uniform float uOpacity = 1.0;
+
+uniform sampler2D albedoMap;
+uniform sampler2D normalMap;
+uniform sampler2D roughnessMap;
+uniform sampler2D metallicMap;
+uniform sampler2D aOcclusionMap;
+
+#include "../include/irradianceSH.glsl"
+
+// Uniforms for ambient lighting.
+uniform samplerCube reflectanceMap;
+uniform sampler2D brdfLookUp;
+uniform float intensity = 1.0;
+
+// Directional lights, without shadows.
+uniform uint numDirLights = 0u;
+uniform vec3 lDirection[MAX_DIR_LIGHTS];
+uniform vec3 lColour[MAX_DIR_LIGHTS];
+uniform float lIntensity[MAX_DIR_LIGHTS];
+
+#ifdef LINKED_LIST
+// The first node of each pixel's list.
+layout(binding = 0, r32ui) uniform coherent uimage2D headPointers;
+
+// Nodes are the colour and alpha as halfs, the depth and the next node.
+layout(std430, binding = 8) coherent buffer FragmentNodes
+{
+  uint numNodes;
+  uint maxNodes;
+  uvec2 padding;
+  uvec4 nodes[];
+};
+#else
+// Weighted colour and the product of the transmittances.
+layout(location = 0) out vec4 accumulation;
+layout(location = 1) out float revealage;
+#endif
+
+#include "../include/pbrBRDF.glsl"
+
+void main()
+{
+#ifdef NO_NORMAL_MAP
+  vec3 normal = normalize(fragIn.fTBN[2]);
+#else
+  vec3 normal = normalize(fragIn.fTBN * (texture(normalMap, fragIn.fTexCoords).xyz * 2.0 - 1.0));
+#endif
+
+#ifdef NO_ALBEDO_MAP
+  vec3 albedo = pow(uAlbedo, vec3(2.2));
+#else
+  vec3 albedo = pow(texture(albedoMap, fragIn.fTexCoords).rgb * uAlbedo, vec3(2.2));
+#endif
+
+  float metallic = uMetallic;
+  float roughness = uRoughness;
+  float ao = uAO;
+#ifndef NO_METALLIC_MAP
+  metallic *= texture(metallicMap, fragIn.fTexCoords).r;
+#endif
+#ifndef NO_ROUGHNESS_MAP
+  roughness *= texture(roughnessMap, fragIn.fTexCoords).r;
+#endif
+#ifndef NO_AO_MAP
+  ao *= texture(aOcclusionMap, fragIn.fTexCoords).r;
+#endif
+
+  vec3 F0 = mix(vec3(0.04), albedo, metallic);
+  vec3 view = normalize(fragIn.fPosition - camera.position);
+
+  // Ambient lighting, same as the deferred ambient pass without the probes.
+  vec3 reflection = reflect(view, normal);
+  float nDotV = abs(dot(normal, -view));
+  vec3 ks = SFresnelR(nDotV, F0, roughness);
+  vec3 kd = (vec3(1.0) - ks) * (1.0 - roughness);
+
+  vec3 ambientDiff = intensity * kd * evaluateIrradiance(normal) * albedo;
+  float maxMip = float(textureQueryLevels(reflectanceMap) - 1);
+  vec3 ambientSpec = intensity * textureLod(reflectanceMap, reflection,
+                                            roughness * maxMip).rgb;
+  vec2 brdfInt = texture(brdfLookUp, vec2(nDotV, roughness)).rg;
+  ambientSpec = ambientSpec * (brdfInt.r * ks + brdfInt.g);
+
+  vec3 colour = (ambientDiff + ambientSpec) * ao;
+
+  // Directional lighting, same as the deferred directional pass.
+  for (uint i = 0u; i < min(numDirLights, uint(MAX_DIR_LIGHTS)); i++)
+  {
+    vec3 light = normalize(lDirection[i]);
+    vec3 halfWay = normalize(view + light);
+
+    float NDF = TRDistribution(normal, halfWay, roughness);
+    float G = SSBGeometry(normal, view, light, roughness);
+    vec3 F = SFresnel(max(dot(halfWay, view), THRESHHOLD), F0);
+
+    vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+    float den = 4.0 * max(dot(normal, view), THRESHHOLD) * max(dot(normal, light), THRESHHOLD);
+    vec3 spec = NDF * G * F / max(den, THRESHHOLD);
+
+    colour += (kD * albedo / PI + spec) * lColour[i] * lIntensity[i]
+              * max(dot(normal, light), THRESHHOLD);
+  }
+
+  float alpha = clamp(uOpacity, 0.0, 1.0);
+
+#ifdef LINKED_LIST
+  uint node = atomicAdd(numNodes, 1u);
+  if (node >= maxNodes)
+    return;
+
+  uint next = imageAtomicExchange(headPointers, ivec2(gl_FragCoord.xy), node);
+  nodes[node] = uvec4(packHalf2x16(colour.rg), packHalf2x16(vec2(colour.b, alpha)),
+                      floatBitsToUint(gl_FragCoord.z), next);
+#else
+  // Depth weight from McGuire and Bavoil, closer surfaces dominate the
+  // average of the overlapping fragments.
+  float distance = length(fragIn.fPosition - camera.position);
+  float weight = alpha * clamp(10.0 / (1e-5 + pow(distance / 5.0, 2.0)
+                                       + pow(distance / 200.0, 6.0)), 1e-2, 3e3);
+
+  accumulation = vec4(colour * alpha, alpha) * weight;
+  revealage = alpha;
+#endif
+}
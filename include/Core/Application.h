@@ -58,6 +58,10 @@ namespace SciRenderer
     // The last frame time.
     float lastTime;
 
+    // Startup is timed until the first frame is finished.
+    std::chrono::steady_clock::time_point startTime;
+    bool firstFrame;
+
     Unique<ThreadPool> workerGroup;
 
     // Asset managers for the different assets loaded in.
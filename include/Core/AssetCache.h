@@ -0,0 +1,152 @@
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// STL includes.
+#include <atomic>
+#include <mutex>
+
+namespace SciRenderer
+{
+  // Append-only byte buffer for writing cooked blobs. Values are written with
+  // their in-memory layout, cooked blobs are only ever read back by the same
+  // build on the same (little endian) platform.
+  struct BlobWriter
+  {
+    std::vector<unsigned char> bytes;
+
+    void writeBytes(const void* data, size_t size)
+    {
+      auto first = static_cast<const unsigned char*>(data);
+      this->bytes.insert(this->bytes.end(), first, first + size);
+    }
+
+    template <typename T>
+    void write(const T &value) { this->writeBytes(&value, sizeof(T)); }
+
+    void writeString(const std::string &value)
+    {
+      this->write<GLuint>(value.size());
+      this->writeBytes(value.data(), value.size());
+    }
+  };
+
+  // Bounds checked reader for blobs written with a BlobWriter. Reads fail
+  // (and keep failing) once the end of the blob is passed.
+  struct BlobReader
+  {
+    const std::vector<unsigned char> &bytes;
+    size_t offset;
+
+    BlobReader(const std::vector<unsigned char> &bytes)
+      : bytes(bytes)
+      , offset(0)
+    { }
+
+    bool readBytes(void* data, size_t size)
+    {
+      if (size > this->bytes.size() - this->offset)
+      {
+        this->offset = this->bytes.size();
+        return false;
+      }
+
+      memcpy(data, this->bytes.data() + this->offset, size);
+      this->offset += size;
+      return true;
+    }
+
+    template <typename T>
+    bool read(T &outValue) { return this->readBytes(&outValue, sizeof(T)); }
+
+    bool readString(std::string &outValue)
+    {
+      GLuint size;
+      if (!this->read(size) || size > this->bytes.size() - this->offset)
+        return false;
+
+      outValue.assign(reinterpret_cast<const char*>(this->bytes.data() + this->offset), size);
+      this->offset += size;
+      return true;
+    }
+
+    // Pointer to the unread part of the blob.
+    const unsigned char* current() { return this->bytes.data() + this->offset; }
+    size_t remaining() { return this->bytes.size() - this->offset; }
+  };
+
+  // A content addressed cache for cooked assets on disk. Entries are named by
+  // the hash of the source file and the settings they were cooked with, so an
+  // entry is valid for as long as it exists and stale entries simply age out.
+  // Files are written to a temporary file and renamed into place, so several
+  // editor instances can share the cache directory. The least recently used
+  // entries are evicted once the cache is larger than its size limit.
+  class AssetCache
+  {
+  public:
+    ~AssetCache() = default;
+
+    static std::mutex cacheMutex;
+
+    static AssetCache* getInstance();
+
+    // The key of a source cooked with some settings. Returns an empty key if
+    // the source can't be read.
+    std::string getKey(const std::string &sourcePath, const std::string &settings);
+
+    // The key of a source held in memory, like generated shader code.
+    std::string getDataKey(const std::string &data, const std::string &settings);
+
+    // The path of the cache entry for a key, extension includes the dot.
+    std::string getPath(const std::string &key, const std::string &extension);
+
+    // A unique temporary path to write an entry to before committing it.
+    std::string getTempPath(const std::string &path);
+
+    // Move a finished temporary file into place. The cache is only trimmed
+    // once the running size goes over the limit.
+    bool commitFile(const std::string &tempPath, const std::string &path);
+
+    // Read and write whole entries. Reading an entry marks it as recently used.
+    bool readBlob(const std::string &path, std::vector<unsigned char> &outBlob);
+    bool writeBlob(const std::string &path, const std::vector<unsigned char> &blob);
+
+    // Mark an entry as recently used.
+    void touch(const std::string &path);
+
+    // Evict the least recently used entries until the cache fits in its size
+    // limit, and clean up temporary files left behind by crashed writers.
+    // Scans the whole directory, called at startup and when the cache grows
+    // past its limit.
+    void trim();
+
+    void setSizeLimit(GLuint64 bytes) { this->sizeLimit = bytes; }
+    GLuint64 getSizeLimit() { return this->sizeLimit; }
+    const std::string& getDirectory() { return this->directory; }
+  private:
+    AssetCache();
+
+    // Hash of the contents of a file. Hashes are remembered by path, size and
+    // modification time so each source is only read once per session.
+    bool hashFile(const std::string &filepath, GLuint64 &outHash);
+
+    static AssetCache* instance;
+
+    std::string directory;
+    GLuint64 sizeLimit;
+
+    // Size of the cache as of the last trim plus the entries committed since.
+    // Entries rewritten or evicted by other instances make it drift, every
+    // trim resyncs it with the directory.
+    std::atomic<GLuint64> cacheSize;
+
+    struct FileHash
+    {
+      uintmax_t size;
+      int64_t modified;
+      GLuint64 hash;
+    };
+    std::unordered_map<std::string, FileHash> fileHashes;
+  };
+}
@@ -54,6 +54,22 @@ namespace SciRenderer
       return returnValue;
     }
 
+    // Wait on a future, executing queued jobs while waiting. This lets jobs
+    // fan out more jobs and wait on them without starving the workers.
+    template <typename ReturnType>
+    void waitFor(std::future<ReturnType> &future)
+    {
+      while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      {
+        if (!this->executeNext())
+          std::this_thread::yield();
+      }
+    }
+
+    // Execute the next job in the queue on the calling thread. Returns false
+    // if the queue was empty.
+    bool executeNext();
+
   private:
     friend class Job;
     friend class ReturnJob;
@@ -0,0 +1,75 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Buffers.h"
+#include "Graphics/Camera.h"
+#include "Graphics/Compute.h"
+#include "Graphics/GeometryBuffer.h"
+#include "Graphics/GPUTimer.h"
+
+namespace SciRenderer
+{
+  // The resolution the occlusion is computed at.
+  enum class AOMode : GLuint { Off = 0, Full = 1, Half = 2 };
+
+  // Screen-space ambient occlusion over the whole scene. Ground truth ambient
+  // occlusion (horizon based) is computed from the gbuffer positions and
+  // normals, at full or half resolution. The result is upsampled with a depth
+  // aware bilateral filter and accumulated over frames, the sampling pattern
+  // rotates every frame so the accumulation converges to a smooth result.
+  class AmbientOcclusion
+  {
+  public:
+    AmbientOcclusion(GLuint width, GLuint height);
+    ~AmbientOcclusion();
+
+    void resize(GLuint width, GLuint height);
+
+    // Compute the occlusion for this frame, over the corner of the gbuffer
+    // which was rendered to. The gbuffer positions and normals must be bound
+    // to texture units 3 and 4.
+    void compute(Shared<Camera> camera, const glm::uvec2 &renderSize, AOMode mode,
+                 GLfloat radius, GLfloat power);
+
+    // Bind the resolved occlusion to a texture unit.
+    void bind(GLuint textureUnit);
+
+    // Forget the accumulated frames, for when the history can't be
+    // reprojected (camera cuts, resizes, mode switches).
+    void resetHistory() { this->historyValid = false; }
+
+    // Most recent GPU time of a mode in milliseconds.
+    GLfloat getTime(AOMode mode);
+    GLuint getResultID() { return this->history[this->current]; }
+  private:
+    void createTextures();
+    void deleteTextures();
+
+    GLuint width;
+    GLuint height;
+
+    // Occlusion and view depth at the working resolution, and the
+    // accumulated occlusion and view depth at full resolution.
+    GLuint rawAO;
+    GLuint history[2];
+    GLuint current;
+
+    GLuint frameIndex;
+    glm::mat4 prevViewProj;
+    glm::uvec2 prevRenderSize;
+    bool historyValid;
+    AOMode lastMode;
+
+    ComputeShader aoShader;
+    ComputeShader resolveShader;
+    ShaderStorageBuffer paramBuffer;
+
+    GPUTimer fullTimer;
+    GPUTimer halfTimer;
+  };
+}
@@ -0,0 +1,63 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Graphics/Buffers.h"
+#include "Graphics/Compute.h"
+#include "Graphics/GPUTimer.h"
+
+// Number of bins in the luminance histogram.
+#define LUMINANCE_HISTOGRAM_BINS 256
+
+namespace SciRenderer
+{
+  // Automatic exposure from a histogram of the scene's log luminance. The
+  // average luminance adapts towards the one measured this frame over time,
+  // like an eye adjusting to the dark, and the exposure maps it to middle grey.
+  // The exposure stays on the GPU, the tone mapping pass reads it from the
+  // exposure buffer.
+  class AutoExposure
+  {
+  public:
+    AutoExposure();
+    ~AutoExposure();
+
+    // Measure the scene and adapt the exposure. The scene must be bound to
+    // texture unit 0. The compensation is in stops, the speed is the rate of
+    // adaptation per second.
+    void compute(const glm::uvec2 &renderSize, GLfloat compensation, GLfloat speed);
+
+    // Bind the exposure buffer to a shader storage binding point.
+    void bind(GLuint bindPoint);
+
+    // Jump straight to the measured exposure next frame.
+    void resetHistory() { this->historyValid = false; }
+
+    // Read back the last histogram, for debugging. Stalls until the GPU
+    // catches up.
+    void getHistogram(std::vector<GLfloat> &outHistogram);
+
+    // The log luminance range covered by the histogram.
+    GLfloat getMinLogLuminance() { return this->minLogLuminance; }
+    GLfloat getMaxLogLuminance() { return this->minLogLuminance + this->logLuminanceRange; }
+
+    // Most recent GPU time in milliseconds.
+    GLfloat getTime() { return this->timer.getTime(); }
+  private:
+    GLfloat minLogLuminance;
+    GLfloat logLuminanceRange;
+
+    bool historyValid;
+    std::chrono::steady_clock::time_point lastTime;
+
+    ComputeShader histogramShader;
+    ComputeShader adaptShader;
+    ShaderStorageBuffer paramBuffer;
+    ShaderStorageBuffer exposureBuffer;
+
+    GPUTimer timer;
+  };
+}
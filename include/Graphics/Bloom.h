@@ -0,0 +1,63 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Graphics/Buffers.h"
+#include "Graphics/Compute.h"
+#include "Graphics/GPUTimer.h"
+
+// Maximum number of levels in the bloom mip chain.
+#define MAX_BLOOM_MIPS 6
+
+namespace SciRenderer
+{
+  // Bloom from a dual filter blur. The scene is downsampled into a mip chain
+  // starting at half resolution, each level from the one above with a five
+  // tap filter, then the levels are upsampled and added back up the chain with
+  // a tent filter. The first downsample weights the texels by their inverse
+  // luminance so single bright pixels don't flicker.
+  class Bloom
+  {
+  public:
+    Bloom(GLuint width, GLuint height);
+    ~Bloom();
+
+    void resize(GLuint width, GLuint height);
+
+    // Blur the scene over the corner of it which was rendered to. The scene
+    // must be bound to texture unit 0.
+    void compute(const glm::uvec2 &renderSize);
+
+    // Bind the blurred scene to a texture unit. The result is the sum of the
+    // levels of the chain.
+    void bind(GLuint textureUnit);
+    GLuint getNumMips() { return this->numMips; }
+
+    // The part of the result texture covered this frame, in texture
+    // coordinates.
+    glm::vec2 getResultScale() { return this->resultScale; }
+
+    // Most recent GPU time in milliseconds.
+    GLfloat getTime() { return this->timer.getTime(); }
+    GLuint getResultID() { return this->mipChain; }
+  private:
+    void createTextures();
+    void deleteTextures();
+
+    GLuint width;
+    GLuint height;
+
+    GLuint mipChain;
+    GLuint numMips;
+    glm::vec2 resultScale;
+
+    ComputeShader downsampleShader;
+    ComputeShader upsampleShader;
+    ShaderStorageBuffer paramBuffer;
+
+    GPUTimer timer;
+  };
+}
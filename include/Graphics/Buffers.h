@@ -4,6 +4,10 @@
 // Macro include file.
 #include "SciRenderPCH.h"
 
+// STL includes.
+#include <mutex>
+#include <deque>
+
 namespace SciRenderer
 {
   // Draw types.
@@ -163,6 +167,10 @@ namespace SciRenderer
     // Set the data in a region of the buffer.
     void setData(GLuint start, GLuint newDataSize, const void* newData);
 
+    // Read back a region of the buffer. Writes from shaders need a
+    // GL_BUFFER_UPDATE_BARRIER_BIT barrier first.
+    void getData(GLuint start, GLuint size, void* outData);
+
     GLuint getID() { return this->bufferID; }
     bool hasData() { return this->filled; }
   protected:
@@ -178,4 +186,54 @@ namespace SciRenderer
     // The size of the data currently in the buffer.
     GLuint dataSize;
   };
+
+  //----------------------------------------------------------------------------
+  // Persistently mapped pixel unpack ring buffer here. Worker threads reserve
+  // regions of the ring and write pixels into them, the main thread issues the
+  // copies out of the regions and fences them. Regions are recycled in order
+  // once their fences have signalled.
+  //----------------------------------------------------------------------------
+  class PixelUnpackRing
+  {
+  public:
+    PixelUnpackRing(const unsigned &ringSize);
+    ~PixelUnpackRing();
+
+    // Bind/unbind the buffer.
+    void bind();
+    void unbind();
+
+    // Reserve a region of the ring. Returns a pointer to the mapped memory, or
+    // nullptr if there isn't enough free space. Safe to call from any thread.
+    void* reserve(GLuint size, GLuint &outOffset);
+
+    // Fence the region at the offset once the copies out of it are issued.
+    // Main thread only.
+    void fence(GLuint offset);
+
+    // Recycle the regions whose copies have completed. Main thread only.
+    void retire();
+
+    GLuint getID() { return this->bufferID; }
+    GLuint getSize() { return this->ringSize; }
+  protected:
+    struct RingRegion
+    {
+      GLuint offset;
+      GLuint size;
+      GLsync fence;
+    };
+
+    // OpenGL buffer ID.
+    GLuint bufferID;
+
+    // The persistently mapped memory.
+    unsigned char* mappedData;
+
+    // Ring state, regions are stored in allocation order.
+    GLuint ringSize;
+    GLuint head;
+    std::deque<RingRegion> regions;
+    std::mutex ringMutex;
+  };
 }
@@ -46,6 +46,13 @@ namespace SciRenderer
     glm::mat4& getViewMatrix();
     glm::mat4& getProjMatrix();
 
+    // Sub-pixel offset of the projection in normalized device coordinates,
+    // for temporal anti-aliasing. Only the scene geometry is drawn with the
+    // jittered projection.
+    void setJitter(const glm::vec2 &jitter) { this->jitter = jitter; }
+    glm::vec2 getJitter() { return this->jitter; }
+    glm::mat4 getJitteredProjMatrix();
+
     // Get the camera position and front.
     glm::vec3 getCamPos();
     glm::vec3 getCamFront();
@@ -73,6 +80,7 @@ namespace SciRenderer
     // The camera matrices. Stored here to avoid recalculation on each frame.
     glm::mat4   view;
     glm::mat4   proj;
+    glm::vec2   jitter;
 
     // Time steps to normalize camera movement to frame time.
     GLfloat       lastTime;
@@ -28,9 +28,17 @@ namespace SciRenderer
 
     // Program linker function.
     void buildProgram();
+
+    // Compiles and links don't wait on the driver, errors are checked when
+    // the program is first bound.
+    void finishBuild();
   protected:
     GLuint progID;
     GLuint computeID;
+
+    std::string filepath;
+    bool pending;
+    std::string binaryPath;
   private:
       char* readShaderFile(const char* filename);
   };
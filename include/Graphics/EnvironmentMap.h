@@ -10,10 +10,32 @@
 #include "Graphics/Shaders.h"
 #include "Graphics/Camera.h"
 #include "Graphics/Textures.h"
+#include "Graphics/Buffers.h"
+#include "Graphics/Compute.h"
 
 namespace SciRenderer
 {
-  enum class MapType { Equirectangular, Skybox, Irradiance, Prefilter, Integration };
+  enum class MapType { Equirectangular, Skybox, Prefilter, Integration };
+
+  // Quality tiers of the specular prefilter, by the number of samples per
+  // texel. Samples are read from the mip matching their footprint, so far
+  // fewer are needed than with point sampling.
+  enum class PrefilterQuality : GLuint { Fast = 32, Medium = 128, High = 512 };
+
+  // Number of prefiltered levels for a cubemap of some size. Filtering stops
+  // at 8x8, the roughest lobes don't need more texels than that.
+  GLuint getNumPrefilterMips(GLuint width);
+
+  // Allocate a RGBA16F cubemap with numMips levels for the prefilter to write
+  // into. The cubemap is left bound.
+  Unique<CubeMap> createPrefilterMap(GLuint width, GLuint height, GLuint numMips);
+
+  // Prefilter a cubemap (with mips) into every level of a prefilter map,
+  // roughness increases linearly with the level. Without filterSamples every
+  // sample reads the base level of the source, which is only useful as a
+  // reference.
+  void dispatchPrefilter(ComputeShader &filterShader, CubeMap* source, CubeMap* prefilter,
+                         GLuint numMips, GLuint sampleCount, bool filterSamples);
 
   class EnvironmentMap
   {
@@ -41,14 +63,23 @@ namespace SciRenderer
     // Binds one of the environment map PBR textures to a point.
     void bind(const MapType &type, GLuint bindPoint);
 
+    // Binds the irradiance coefficients to a uniform block binding point.
+    void bindIrradiance(GLuint bindPoint);
+
     // Draw the skybox.
     void configure(Shared<Camera> camera);
 
-    // Generate the diffuse irradiance map.
-    void precomputeIrradiance(const GLuint &width = 512, const GLuint &height = 512, bool isHDR = true);
+    // Generate the diffuse irradiance, as the coefficients of the first nine
+    // spherical harmonics convolved with the cosine lobe.
+    void precomputeIrradiance(bool isHDR = true);
 
     // Generate the specular map components (pre-filter and BRDF integration map).
-    void precomputeSpecular(const GLuint &width = 512, const GLuint &height = 512, bool isHDR = true);
+    // The number of prefiltered mips follows the size of the cubemap.
+    void precomputeSpecular(const GLuint &width = 512, const GLuint &height = 512, bool isHDR = true,
+                            GLuint sampleCount = static_cast<GLuint>(PrefilterQuality::Medium));
+
+    // Log the time and error of each prefilter quality tier.
+    void benchmarkPrefilter(const GLuint &width = 256);
 
     // Getters.
     GLuint getTexID(const MapType &type);
@@ -60,18 +91,17 @@ namespace SciRenderer
     std::string& getFilepath() { return this->filepath; }
     bool hasEqrMap() { return this->erMap != nullptr; }
     bool hasSkybox() { return this->skybox != nullptr; }
-    bool hasIrradiance() { return this->irradiance != nullptr; }
+    bool hasIrradiance() { return this->irradianceSH != nullptr; }
     bool hasPrefilter() { return this->specPrefilter != nullptr; }
     bool hasIntegration() { return this->brdfIntMap != nullptr; }
     bool drawingSkybox() { return this->currentEnvironment == MapType::Skybox; }
-    bool drawingIrrad() { return this->currentEnvironment == MapType::Irradiance; }
     bool drawingFilter() { return this->currentEnvironment == MapType::Prefilter; }
 
     void setDrawingType(MapType type) { this->currentEnvironment = type; }
   protected:
     Unique<Texture2D> erMap;
     Unique<CubeMap>   skybox;
-    Unique<CubeMap>   irradiance;
+    Unique<UniformBuffer> irradianceSH;
     Unique<CubeMap>   specPrefilter;
     Unique<Texture2D> brdfIntMap;
 
@@ -0,0 +1,97 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Buffers.h"
+#include "Graphics/Camera.h"
+#include "Graphics/Compute.h"
+#include "Graphics/FrameBuffer.h"
+#include "Graphics/GeometryBuffer.h"
+#include "Graphics/GPUTimer.h"
+
+// Size of the screen tiles in pixels, and the most lights listed per tile.
+#define FORWARD_TILE_SIZE 16
+#define MAX_LIGHTS_PER_TILE 63
+
+namespace SciRenderer
+{
+  // Layout of a point or spot light in the shader storage buffer.
+  struct TiledLight
+  {
+    glm::vec4 position;  // w is the radius.
+    glm::vec4 colour;    // w is the intensity.
+    glm::vec4 direction; // w is 0 for point lights and 1 for spot lights.
+    glm::vec4 cutoffs;   // Cosines of the inner and outer cone angles.
+  };
+
+  // Forward+ rendering. The scene is drawn into a multisampled target with a
+  // depth pre-pass, the lights touching each screen tile are listed in compute
+  // from the pre-pass depth, and every visible fragment is shaded once with
+  // the lights of its tile. Only the lit colour, entity IDs and depth are
+  // stored, a lower bandwidth alternative to the gbuffer for scenes with few
+  // lights.
+  class ForwardPlus
+  {
+  public:
+    ForwardPlus(GLuint width, GLuint height, GLuint samples = 4);
+    ~ForwardPlus();
+
+    // Resize the targets, or change the number of samples.
+    void resize(GLuint width, GLuint height, GLuint samples);
+
+    // Clear and bind the multisampled target.
+    void begin(const glm::uvec2 &renderSize);
+    void end();
+
+    // Only write the colour, for the skybox which has no entity ID.
+    void colourOnly();
+
+    // Upload the lights and list the ones touching each tile, from the depth
+    // drawn so far.
+    void cullLights(Shared<Camera> camera, const std::vector<TiledLight> &lights,
+                    const glm::uvec2 &renderSize);
+
+    // Bind the lights and the tile lists for shading, to storage bindings 5
+    // and 6.
+    void bindLights();
+
+    // Resolve the samples into the lit scene colour, and the entity IDs and
+    // depth into the gbuffer for the post processing passes. The IDs take
+    // the first sample of each pixel, averaging them would blend the IDs of
+    // the entities along every silhouette.
+    void resolve(FrameBuffer &sceneColour, GeometryBuffer &gBuffer,
+                 const glm::uvec2 &renderSize);
+
+    glm::uvec2 getNumTiles(const glm::uvec2 &renderSize);
+    GLuint getSamples() { return this->samples; }
+    GLfloat getTime() { return this->timer.getTime(); }
+  private:
+    void createTargets();
+    void deleteTargets();
+
+    GLuint width;
+    GLuint height;
+    GLuint samples;
+
+    // Multisampled colour, entity IDs and depth.
+    GLuint targetFBO;
+    GLuint colourTarget;
+    GLuint idTarget;
+    GLuint depthTarget;
+
+    // Lights and the per tile light lists, a count followed by the indices.
+    GLuint lightCapacity;
+    Unique<ShaderStorageBuffer> lightBuffer;
+    Unique<ShaderStorageBuffer> tileBuffer;
+
+    ComputeShader cullShader;
+    ComputeShader idResolveShader;
+    ShaderStorageBuffer paramBuffer;
+
+    GPUTimer timer;
+  };
+}
@@ -0,0 +1,34 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Number of queries in flight per timer.
+#define NUM_TIMER_QUERIES 4
+
+namespace SciRenderer
+{
+  // Times a span of GPU commands with a pair of timestamp queries. The queries
+  // are kept in a ring and read a few frames late, so reading the result never
+  // stalls the pipeline. Timers can be nested.
+  class GPUTimer
+  {
+  public:
+    GPUTimer();
+    ~GPUTimer();
+
+    void begin();
+    void end();
+
+    // The most recent result in milliseconds.
+    GLfloat getTime() { return this->lastTime; }
+  private:
+    GLuint startQueries[NUM_TIMER_QUERIES];
+    GLuint endQueries[NUM_TIMER_QUERIES];
+    bool pending[NUM_TIMER_QUERIES];
+    GLuint current;
+
+    GLfloat lastTime;
+  };
+}
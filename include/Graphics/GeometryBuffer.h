@@ -29,6 +29,11 @@ namespace SciRenderer
     void resize(GLuint width, GLuint height);
     void blitzToOther(FrameBuffer &target, const FBOTargetParam &type);
 
+    // Copy an attachment of another framebuffer into the gbuffer, resolving
+    // it if it's multisampled. The source attachment is ignored for depth.
+    void blitzFromOther(GLuint sourceID, GLenum sourceAttachment,
+                        const FBOTargetParam &target, const glm::uvec2 &size);
+
     void bindAttachment(const FBOTargetParam &attachment, GLuint bindPoint);
     GLuint getAttachmentID(const FBOTargetParam &attachment) { return this->geoBuffer.getAttachID(attachment); }
     glm::vec2 getSize() { return this->geoBuffer.getSize(); }
@@ -0,0 +1,83 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Buffers.h"
+#include "Graphics/Meshes.h"
+
+// STL includes.
+#include <map>
+
+namespace SciRenderer
+{
+  // The transforms of every submesh drawn, kept in a persistent shader storage
+  // buffer. Each submesh of an entity keeps its slot while it's drawn, and
+  // only the slots which changed are uploaded, so a static scene uploads
+  // nothing. Draws fetch their slot through the base instance, which replaces
+  // the per-draw transform uniforms.
+  class InstanceBuffer
+  {
+  public:
+    InstanceBuffer();
+    ~InstanceBuffer();
+
+    // Set this frame's camera transforms. Only uploaded when they change.
+    void setCamera(const glm::mat4 &viewProj, const glm::mat4 &unjitteredViewProj,
+                   const glm::mat4 &prevViewProj);
+
+    // Find or assign the slot of a submesh of an entity for this frame, and
+    // queue it for upload if its data changed. Returns the slot.
+    GLuint update(GLuint id, Mesh* submesh, const glm::mat4 &transform,
+                  bool drawSelectionMask);
+
+    // Free the slots which weren't drawn this frame and upload the changes.
+    void flush();
+
+    // Bind the buffer to its shader storage binding point.
+    void bind();
+
+    GLuint getNumInstances() { return this->slots.size(); }
+    GLuint getNumUploaded() { return this->numUploaded; }
+  private:
+    struct InstanceSlot
+    {
+      GLuint index;
+      GLuint lastFrame;
+    };
+
+    // Layout of an instance in the shader storage buffer.
+    struct GPUInstance
+    {
+      glm::mat4 model;
+      glm::mat4 prevModel;
+      glm::mat4 normalMat;  // The upper 3x3 is the normal matrix.
+      glm::uvec4 info;      // x is the entity ID + 1, y is the selection mask.
+    };
+
+    // Layout of the camera transforms at the start of the buffer.
+    struct GPUCamera
+    {
+      glm::mat4 viewProj;
+      glm::mat4 unjitteredViewProj;
+      glm::mat4 prevViewProj;
+    };
+
+    std::map<std::pair<GLuint, Mesh*>, InstanceSlot> slots;
+    std::vector<GLuint> freeSlots;
+    std::vector<GLuint> dirtySlots;
+
+    // CPU copies of the slots, to diff against and to refill a grown buffer.
+    std::vector<GPUInstance> instances;
+    GPUCamera camera;
+    bool cameraDirty;
+
+    GLuint frame;
+    GLuint capacity;
+    GLuint numUploaded;
+    Unique<ShaderStorageBuffer> buffer;
+  };
+}
@@ -30,6 +30,13 @@ namespace SciRenderer
     void configure();
     void configure(Shader* overrideProgram);
 
+    // Prepare for drawing with the permutation of a program which skips the
+    // maps this material doesn't have. Returns the permutation to draw with.
+    Shader* configureVariant(Shader* baseProgram);
+
+    // Bitmask of the optional maps which are unassigned or placeholders.
+    GLuint getMissingMaps();
+
     // Sampler configuration.
     bool hasSampler1D(const std::string &samplerName);
     void attachSampler1D(const std::string &samplerName, const SciRenderer::AssetHandle &handle);
@@ -53,6 +60,10 @@ namespace SciRenderer
     // Get the shader program.
     Shader* getShader() { return this->program; }
 
+    // Transparent materials are drawn in the transparency pass instead of the
+    // geometry pass.
+    bool& isTransparent() { return this->transparent; }
+
     // Get the shader data.
     GLfloat& getFloat(const std::string &name)
     {
@@ -103,8 +114,12 @@ namespace SciRenderer
     // Reflect the attached shader.
     void reflect();
 
+    // Upload the material to a program, without the maps which are skipped.
+    void uploadUniforms(Shader* program, GLuint skippedMaps);
+
     // The material type.
     MaterialType type;
+    bool transparent;
 
     // The shader and shader data.
     Shader* program;
@@ -119,6 +134,11 @@ namespace SciRenderer
     std::vector<std::pair<std::string, SciRenderer::AssetHandle>> sampler2Ds;
     std::vector<std::pair<std::string, SciRenderer::AssetHandle>> sampler3Ds;
     std::vector<std::pair<std::string, SciRenderer::AssetHandle>> samplerCubes;
+
+    // The last permutation used, so it's only looked up when the maps change.
+    Shader* variantBase;
+    Shader* variant;
+    GLuint variantMaps;
   };
 
   // Macro material which holds all the individual material objects for each
@@ -0,0 +1,54 @@
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Graphics/Meshes.h"
+
+namespace SciRenderer
+{
+  // Post-transform vertex cache statistics for an indexed triangle list.
+  struct VertexCacheStats
+  {
+    // Average cache miss ratio, transformed vertices per triangle. 0.5 is
+    // optimal for large regular grids, 3.0 is the worst case.
+    GLfloat acmr;
+    // Average transformed vertex ratio, transformed vertices per unique
+    // vertex. 1.0 is optimal.
+    GLfloat atvr;
+
+    VertexCacheStats()
+      : acmr(0.0f)
+      , atvr(0.0f)
+    { }
+  };
+
+  // Import-time optimizations for indexed triangle lists. All of these are
+  // pure CPU functions which only touch the arguments, so they are safe to
+  // call from the worker threads.
+  namespace MeshOptimizer
+  {
+    // Reorder the triangles to maximize post-transform vertex cache hits using
+    // Forsyth's linear-speed vertex cache optimization.
+    void optimizeVertexCache(std::vector<GLuint> &indices, GLuint numVertices);
+
+    // Split the cache optimized triangle order into clusters and sort them so
+    // outward facing clusters are drawn first, reducing overdraw (Sander et al.).
+    // Clusters are only broken where the ACMR stays within threshold times the
+    // ACMR of the original order.
+    void optimizeOverdraw(std::vector<GLuint> &indices,
+                          const std::vector<Vertex> &vertices,
+                          GLfloat threshold = 1.05f);
+
+    // Reorder the vertices in the order they're first referenced by the index
+    // buffer so vertex fetches are as linear as possible. Unreferenced vertices
+    // are dropped.
+    void optimizeVertexFetch(std::vector<Vertex> &vertices,
+                             std::vector<GLuint> &indices);
+
+    // Simulate a FIFO post-transform cache to compute the ACMR and ATVR.
+    VertexCacheStats analyzeVertexCache(const std::vector<GLuint> &indices,
+                                        GLuint numVertices, GLuint cacheSize = 16);
+  }
+}
@@ -49,6 +49,7 @@ namespace SciRenderer
     glm::vec3& getMinPos() { return this->minPos; }
     glm::vec3& getMaxPos() { return this->maxPos; }
     VertexArray*  getVAO() { return this->vArray.get(); }
+    VertexArray*  getPositionVAO() { return this->positionArray.get(); }
     std::string& getFilepath() { return this->filepath; }
     std::string& getName() { return this->name; }
 
@@ -72,5 +73,9 @@ namespace SciRenderer
 
     // Vertex array object for the mesh data.
     Unique<VertexArray> vArray;
+
+    // Positions only, for depth only passes which don't need to fetch the
+    // rest of the vertex.
+    Unique<VertexArray> positionArray;
   };
 }
@@ -0,0 +1,49 @@
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Graphics/Textures.h"
+
+// STL includes.
+#include <functional>
+
+namespace SciRenderer
+{
+  // A single image level as RGBA floats. LDR images are normalized to [0, 1].
+  struct MipLevel
+  {
+    GLuint width;
+    GLuint height;
+    std::vector<GLfloat> texels;
+
+    MipLevel()
+      : width(0)
+      , height(0)
+    { }
+  };
+
+  // CPU image processing for the texture loaders. The work is split into
+  // bands of rows which run on the thread pool, and the filter kernels use
+  // SSE when it's available. Safe to call from the workers.
+  namespace MipGenerator
+  {
+    // Expand decoded pixels (n channels of bytes or floats) into an RGBA
+    // level. Missing channels are filled like OpenGL does.
+    void expandToRGBA(const void* pixels, GLuint width, GLuint height, int n,
+                      bool isHDR, MipLevel &outLevel);
+
+    // Build the full mip chain of a level. Each level is handed to
+    // onLevel(index, level) as soon as it's built and dropped afterwards, level
+    // 0 is the base level itself. At most two float levels are alive at once.
+    // Colour channels of sRGB images are filtered in linear space.
+    void generateMips(MipLevel &&baseLevel, TextureMipFilter filter, bool isSRGB,
+                      bool isHDR,
+                      const std::function<void(GLuint, const MipLevel&)> &onLevel);
+
+    // Pack a level into channels bytes or floats per texel.
+    void packLevel(const MipLevel &level, int channels, bool isHDR,
+                   void* destination);
+  }
+}
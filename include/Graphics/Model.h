@@ -19,6 +19,33 @@
 
 namespace SciRenderer
 {
+  // Import settings for a model, set per asset. Triangulation and primitive
+  // sorting are always performed.
+  typedef int ModelImportFlags;
+  enum ModelImportFlags_
+  {
+    ModelImportFlags_None = 0,
+    ModelImportFlags_GenNormals = 1 << 0,
+    ModelImportFlags_GenTangents = 1 << 1,
+    ModelImportFlags_JoinVertices = 1 << 2,
+    ModelImportFlags_GenUVs = 1 << 3,
+    ModelImportFlags_OptimizeMeshes = 1 << 4,
+    ModelImportFlags_Default = ModelImportFlags_GenNormals | ModelImportFlags_GenTangents
+                             | ModelImportFlags_JoinVertices | ModelImportFlags_GenUVs
+                             | ModelImportFlags_OptimizeMeshes
+  };
+
+  class Model;
+
+  // A submesh which finished converting on a worker and is waiting to be
+  // uploaded on the main thread.
+  struct StreamedSubmesh
+  {
+    Model* model;
+    ModelMaterial* materials;
+    Shared<Mesh> submesh;
+  };
+
   // Model class
   class Model
   {
@@ -26,17 +53,25 @@ namespace SciRenderer
     Model();
     ~Model();
 
-    static std::queue<std::pair<Model*, ModelMaterial*>> asyncModelQueue;
-    static std::mutex asyncModelMutex;
+    static std::queue<StreamedSubmesh> asyncMeshQueue;
+    static std::mutex asyncMeshMutex;
+
+    // Upload the streamed submeshes and generate their materials. Stops once
+    // uploadBudget bytes have been uploaded, returns the bytes uploaded.
+    static GLuint bulkGenerateMaterials(GLuint uploadBudget);
 
-    // Async load a model (using a separate thread).
-    static void bulkGenerateMaterials();
-    static void asyncLoadModel(const std::string &filepath, const std::string &name, ModelMaterial* materialContainer);
+    // Async load a model (using a separate thread). The model is available
+    // immediately with its bounds, submeshes stream in as they're converted.
+    static void asyncLoadModel(const std::string &filepath, const std::string &name,
+                               ModelMaterial* materialContainer,
+                               ModelImportFlags flags = ModelImportFlags_Default);
 
-    // Load a model.
-    void loadModel(const std::string &filepath);
+    // Load a model. The submeshes are converted in parallel on the thread pool.
+    void loadModel(const std::string &filepath,
+                   ModelImportFlags flags = ModelImportFlags_Default);
 
-    // Is the model loaded or not.
+    // Is the model loaded or not. Streaming models aren't loaded until all of
+    // their submeshes are uploaded.
     bool isLoaded() { return this->loaded; }
 
     // Get the submeshes for the model.
@@ -44,8 +79,12 @@ namespace SciRenderer
     glm::vec3& getMaxPos() { return this->maxPos; }
     std::vector<std::pair<std::string, Shared<Mesh>>>& getSubmeshes() { return this->subMeshes; }
     std::string& getFilepath() { return this->filepath; }
+    ModelImportFlags getImportFlags() { return this->importFlags; }
   protected:
     bool loaded;
+    ModelImportFlags importFlags;
+    GLuint numStreamingMeshes;
+    GLuint numStreamedMeshes;
     std::vector<std::pair<std::string, Shared<Mesh>>> subMeshes;
 
     glm::vec3 minPos;
@@ -55,8 +94,12 @@ namespace SciRenderer
     std::string name;
 
   private:
-    void processNode(aiNode* node, const aiScene* scene);
-    void processMesh(aiMesh* mesh, const aiScene* scene);
+    const aiScene* importScene(Assimp::Importer &importer, const std::string &filepath,
+                               ModelImportFlags flags);
+    bool convertScene(const std::string &filepath, ModelImportFlags flags,
+                      std::vector<Shared<Mesh>> &outMeshes);
+    void processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*> &meshes);
+    Shared<Mesh> processMesh(aiMesh* mesh, const aiScene* scene);
 
     friend class Mesh;
   };
@@ -0,0 +1,80 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Buffers.h"
+#include "Graphics/Compute.h"
+#include "Graphics/GPUTimer.h"
+
+namespace SciRenderer
+{
+  // Layout of glDrawElementsIndirect commands.
+  struct DrawElementsCommand
+  {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+  };
+
+  // GPU occlusion culling against a hierarchical depth buffer. Each draw gets
+  // an indirect command, culled draws are left with an instance count of zero.
+  // Culling happens in two phases to avoid popping:
+  // - The draws visible last frame are drawn first.
+  // - A min/max depth pyramid is built from their depth.
+  // - Every draw is tested against the pyramid. Draws which became visible are
+  //   drawn in the second phase, and the visibility is kept for next frame.
+  class OcclusionCuller
+  {
+  public:
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    // Upload the world space bounds, index counts and base instances of this
+    // frame's draws. The visibility of last frame carries over while the draws
+    // don't change.
+    void setDraws(const std::vector<std::pair<glm::vec3, glm::vec3>> &bounds,
+                  const std::vector<GLuint> &indexCounts,
+                  const std::vector<GLuint> &baseInstances);
+
+    // Enable the draws which were visible last frame.
+    void cullFirstPhase();
+
+    // Build the depth pyramid from the depth drawn so far and enable the draws
+    // which are no longer occluded.
+    void cullSecondPhase(GLuint depthID, const glm::vec2 &depthSize,
+                         const glm::mat4 &viewProj);
+
+    // Bind the commands to the indirect draw target.
+    void bindCommands();
+
+    GLuint getPyramidID() { return this->pyramidID; }
+    GLfloat getTime() { return this->timer.getTime(); }
+  private:
+    void buildPyramid(GLuint depthID, const glm::vec2 &depthSize);
+    void dispatchCull(GLuint phase, const glm::mat4 &viewProj);
+
+    // The depth pyramid, the nearest depth in red and farthest in green.
+    GLuint pyramidID;
+    glm::uvec2 pyramidSize;
+    GLuint numLevels;
+    GLuint depthSampler;
+
+    GLuint numDraws;
+    GLuint capacity;
+    Unique<ShaderStorageBuffer> boundsBuffer;
+    Unique<ShaderStorageBuffer> commandBuffer;
+    Unique<ShaderStorageBuffer> visibilityBuffer;
+    ShaderStorageBuffer paramBuffer;
+
+    ComputeShader pyramidShader;
+    ComputeShader cullShader;
+
+    GPUTimer timer;
+  };
+}
@@ -0,0 +1,123 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Buffers.h"
+#include "Graphics/Camera.h"
+#include "Graphics/Compute.h"
+#include "Graphics/Textures.h"
+
+// Maximum number of probes in the cubemap array, and per cluster.
+#define MAX_REFLECTION_PROBES 32
+#define MAX_PROBES_PER_CLUSTER 8
+
+namespace SciRenderer
+{
+  enum class ProbeShape : GLuint { Box = 0, Sphere = 1 };
+
+  // A localized reflection probe. Reflections of points inside the influence
+  // volume are parallax corrected against the volume, and fade out to the
+  // global environment over the blend distance at its edges.
+  struct ReflectionProbe
+  {
+    glm::vec3 position;
+    glm::vec3 extents; // Half extents of a box, the radius of a sphere is extents.x.
+    GLfloat blendDistance;
+    ProbeShape shape;
+
+    // The entity the probe belongs to, and if it needs to be rebaked.
+    GLuint id;
+    bool dirty;
+
+    ReflectionProbe()
+      : position(glm::vec3(0.0f))
+      , extents(glm::vec3(5.0f))
+      , blendDistance(1.0f)
+      , shape(ProbeShape::Box)
+      , id(0)
+      , dirty(false)
+    { }
+  };
+
+  // The reflection probes of a scene. Each probe is captured into a cubemap
+  // which is prefiltered into its slot of a cubemap array. Probes are only
+  // baked when they're new, moved or flagged dirty, one per frame. The probes
+  // touching each cluster of the view frustum are listed every frame so the
+  // ambient pass only blends the probes near each pixel.
+  class ReflectionProbes
+  {
+  public:
+    ReflectionProbes(const GLuint &probeSize = 128);
+    ~ReflectionProbes();
+
+    // Queue a probe for this frame.
+    void submit(const ReflectionProbe &probe);
+
+    // Assign slots to the probes submitted this frame and free the slots of
+    // removed probes. Returns true and the probe to bake this frame if any
+    // probe is dirty.
+    bool update(ReflectionProbe &outDirtyProbe);
+
+    // Rebake every probe, for when the environment or scene changes.
+    void markAllDirty();
+
+    // Render target for capturing a face of a probe.
+    void bindCaptureFace(GLuint face);
+
+    // Prefilter the captured cubemap into the probe's slot.
+    void endCapture(const ReflectionProbe &probe, GLuint sampleCount);
+
+    // List the probes touching each cluster of the camera's frustum and
+    // upload the lists. Clears the probes submitted this frame.
+    void buildClusters(Shared<Camera> camera);
+
+    // Bind the probe buffers, and the cubemap array to a texture unit.
+    void bind(GLuint textureUnit);
+
+    GLuint getProbeSize() { return this->probeSize; }
+    GLuint getNumBaked() { return this->numBaked; }
+    glm::uvec3 getClusterGrid() { return this->clusterGrid; }
+  private:
+    struct ProbeSlot
+    {
+      GLuint layer;
+      glm::vec3 bakedPosition;
+      bool baked;
+      bool dirty;
+    };
+
+    // Layout of a probe in the shader storage buffer.
+    struct GPUProbe
+    {
+      glm::vec4 position; // w is the shape.
+      glm::vec4 extents;  // w is the blend distance.
+      glm::uvec4 info;    // x is the cubemap array layer.
+    };
+
+    GLuint probeSize;
+    GLuint numMips;
+
+    // The prefiltered probes and the capture target.
+    GLuint probeArrayID;
+    Unique<CubeMap> capture;
+    Unique<CubeMap> filtered;
+    GLuint captureFBO;
+    GLuint captureDepth;
+    ComputeShader filterShader;
+
+    std::vector<ReflectionProbe> frameProbes;
+    std::unordered_map<GLuint, ProbeSlot> slots;
+    std::vector<GLuint> freeLayers;
+
+    // Cluster lists.
+    glm::uvec3 clusterGrid;
+    GLuint numBaked;
+    ShaderStorageBuffer probeBuffer;
+    ShaderStorageBuffer clusterBuffer;
+    ShaderStorageBuffer indexBuffer;
+  };
+}
@@ -1,4 +1,5 @@
 #define NUM_CASCADES 4
+#define RENDER_SCALE_HISTORY 128
 
 // Include guard.
 #pragma once
@@ -17,11 +18,21 @@
 #include "Graphics/Material.h"
 #include "Graphics/Camera.h"
 #include "Graphics/FrameBuffer.h"
+#include "Graphics/InstanceBuffer.h"
 #include "Graphics/GeometryBuffer.h"
 #include "Graphics/EnvironmentMap.h"
+#include "Graphics/ReflectionProbes.h"
+#include "Graphics/AmbientOcclusion.h"
+#include "Graphics/TemporalAA.h"
+#include "Graphics/AutoExposure.h"
+#include "Graphics/Bloom.h"
+#include "Graphics/Transparency.h"
+#include "Graphics/ForwardPlus.h"
+#include "Graphics/OcclusionCuller.h"
 #include "Graphics/RendererCommands.h"
 
 // STL includes.
+#include <map>
 #include <tuple>
 
 namespace SciRenderer
@@ -95,6 +106,20 @@ namespace SciRenderer
       { }
     };
 
+    // A submesh to draw, with its world space bounds and its slot in the
+    // instance buffer.
+    struct GeometryDraw
+    {
+      Mesh* submesh;
+      Material* material;
+      glm::mat4 transform;
+      GLuint instance;
+      GLuint id;
+      bool drawSelectionMask;
+      glm::vec3 min;
+      glm::vec3 max;
+    };
+
     // The renderer storage.
     struct RendererStorage
     {
@@ -102,6 +127,14 @@ namespace SciRenderer
       GLuint width;
       GLuint height;
 
+      // The area of the buffers rendered to this frame with dynamic
+      // resolution, and the last few scales for the renderer panel.
+      GLfloat renderScale;
+      GLuint renderWidth;
+      GLuint renderHeight;
+      GLfloat scaleHistory[RENDER_SCALE_HISTORY];
+      GLuint scaleHistoryOffset;
+
       // Various properties for rendering.
       bool isForward;
       bool drawEdge;
@@ -118,6 +151,12 @@ namespace SciRenderer
       // Items for the geometry pass.
       std::vector<std::tuple<Model*, ModelMaterial*, glm::mat4, GLuint, bool>> renderQueue;
 
+      // Transparent submeshes, routed out of the geometry pass.
+      std::vector<GeometryDraw> transparentQueue;
+
+      // Items for capturing reflection probes, which aren't frustum culled.
+      std::vector<std::tuple<Model*, ModelMaterial*, glm::mat4>> captureQueue;
+
       // Items for the shadow pass.
       std::vector<std::pair<Model*, glm::mat4>> shadowQueue;
       glm::mat4 cascades[NUM_CASCADES];
@@ -126,6 +165,7 @@ namespace SciRenderer
 
       // The required shaders for processing.
       Shader* geometryShader;
+      Shader* depthPrePassShader;
       Shader* shadowShader;
       Shader* ambientShader;
       Shader* directionalShaderShadowed;
@@ -135,15 +175,45 @@ namespace SciRenderer
       Shader* hdrPostShader;
       Shader* outlineShader;
       Shader* gridShader;
+      Shader* probeCaptureShader;
+      Shader* transparentShader;
+      Shader* oitCompositeShader;
+      Shader* forwardPlusShader;
 
       ComputeShader comHorBlur;
       ComputeShader comVerBlur;
 
       Unique<EnvironmentMap> currentEnvironment;
+      Unique<ReflectionProbes> reflectionProbes;
+      Unique<AmbientOcclusion> ambientOcclusion;
+      Unique<TemporalAA> temporalAA;
+      Unique<AutoExposure> autoExposure;
+      Unique<Bloom> bloom;
+      Unique<Transparency> transparency;
+      Unique<ForwardPlus> forwardPlus;
+      Unique<OcclusionCuller> occlusionCuller;
+
+      // Times the whole geometry pass, including the pre-pass and culling. In
+      // the forward path this is the pre-pass, light culling and shading.
+      GPUTimer geometryTimer;
+      // Times the whole deferred frame, drives the dynamic resolution.
+      GPUTimer frameTimer;
+      // Times the tone mapping pass.
+      GPUTimer toneMapTimer;
+      // Times the transparency pass, including the composite.
+      GPUTimer transparencyTimer;
+
+      // The transforms of the submeshes drawn, and last frame's unjittered
+      // camera transform for the velocity buffer.
+      Unique<InstanceBuffer> instances;
+      glm::mat4 prevViewProj;
 
       Shared<Camera> sceneCam;
       Frustum camFrustum;
 
+      // Material for the bounding box proxies of models which are streaming in.
+      Unique<Material> proxyMaterial;
+
       std::vector<DirectionalLight> directionalQueue;
       std::vector<PointLight> pointQueue;
       std::vector<SpotLight> spotQueue;
@@ -159,13 +229,15 @@ namespace SciRenderer
     // The renderer states (for serialization and other things of that nature).
     struct RendererState
     {
-      // Settings for rendering.
+      // Settings for rendering. The forward path is multisampled.
       bool isForward;
+      GLuint msaaSamples;
       bool frustumCull;
+      bool occlusionCull;
+      bool depthPrePass;
 
       // Environment map settings.
       GLuint skyboxWidth;
-      GLuint irradianceWidth;
       GLuint prefilterWidth;
       GLuint prefilterSamples;
 
@@ -174,20 +246,67 @@ namespace SciRenderer
       GLuint cascadeSize;
       GLfloat bleedReduction;
 
+      // Screen-space ambient occlusion settings.
+      AOMode aoMode;
+      GLfloat aoRadius;
+      GLfloat aoPower;
+
+      // Temporal anti-aliasing.
+      bool temporalAA;
+
+      // How transparent surfaces are blended.
+      OITMode oitMode;
+
+      // Scale the render resolution between half and full to keep the GPU
+      // frame time under a target, in milliseconds.
+      bool dynamicResolution;
+      GLfloat targetFrameTime;
+
+      // Post processing settings. The exposure compensation is in stops, and
+      // is the exposure when it isn't automatic.
+      bool autoExposure;
+      GLfloat exposureCompensation;
+      GLfloat adaptationSpeed;
+      bool bloom;
+      GLfloat bloomIntensity;
+
       // Some editor settings.
       bool drawGrid;
 
+      // Maximum number of bytes uploaded to the GPU per frame by asset
+      // streaming. Zero pauses the uploads.
+      GLuint uploadBudget;
+
+      // Video memory the streamed textures can use, in megabytes.
+      GLuint streamingBudget;
+
       RendererState()
         : isForward(false)
+        , msaaSamples(4)
         , frustumCull(false)
+        , occlusionCull(false)
+        , depthPrePass(false)
         , skyboxWidth(512)
-        , irradianceWidth(128)
         , prefilterWidth(512)
-        , prefilterSamples(1024)
+        , prefilterSamples(128)
         , cascadeLambda(0.5f)
         , cascadeSize(2048)
         , bleedReduction(0.2f)
+        , aoMode(AOMode::Half)
+        , aoRadius(1.0f)
+        , aoPower(1.0f)
+        , temporalAA(false)
+        , oitMode(OITMode::WeightedBlended)
+        , dynamicResolution(false)
+        , targetFrameTime(16.6f)
+        , autoExposure(false)
+        , exposureCompensation(0.0f)
+        , adaptationSpeed(1.5f)
+        , bloom(false)
+        , bloomIntensity(0.04f)
         , drawGrid(true)
+        , uploadBudget(16 * 1024 * 1024)
+        , streamingBudget(512)
       { }
     };
 
@@ -218,6 +337,9 @@ namespace SciRenderer
     RendererState* getState();
     RendererStats* getStats();
 
+    // The size rendered at this frame, with dynamic resolution.
+    glm::uvec2 getRenderSize();
+
     // Generic begin and end for the renderer.
     void begin(GLuint width, GLuint height, Shared<Camera> sceneCam, bool isForward = false);
     void end(Shared<FrameBuffer> frontBuffer);
@@ -228,5 +350,6 @@ namespace SciRenderer
     void submit(DirectionalLight light);
     void submit(PointLight light, const glm::mat4 &model);
     void submit(SpotLight light, const glm::mat4 &model);
+    void submit(ReflectionProbe probe, const glm::mat4 &model);
   }
 }
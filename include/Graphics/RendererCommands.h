@@ -9,7 +9,8 @@ namespace SciRenderer
   enum class DepthFunctions
   {
     Less = GL_LESS,
-    LEq = GL_LEQUAL
+    LEq = GL_LEQUAL,
+    Equal = GL_EQUAL
   };
 
   // Render functions to glEnable. Adding to this as they are required.
@@ -27,7 +28,10 @@ namespace SciRenderer
 
   enum class BlendFunction
   {
-    One = GL_ONE
+    One = GL_ONE,
+    Zero = GL_ZERO,
+    SrcAlpha = GL_SRC_ALPHA,
+    OneMinusSrcColour = GL_ONE_MINUS_SRC_COLOR
   };
 
   enum class PrimativeType
@@ -41,8 +45,13 @@ namespace SciRenderer
     void disable(const RendererFunction &toDisable);
     void enableDepthMask();
     void disableDepthMask();
+    void enableColourMask();
+    void disableColourMask();
     void blendEquation(const BlendEquation &equation);
     void blendFunction(const BlendFunction &source, const BlendFunction &target);
+    // Blend function of a single draw buffer.
+    void blendFunction(GLuint drawBuffer, const BlendFunction &source,
+                       const BlendFunction &target);
     void depthFunction(const DepthFunctions &function);
     void setClearColour(const glm::vec4 &colour);
     void clear(const bool &clearColour = true, const bool &clearDepth = true,
@@ -50,5 +59,11 @@ namespace SciRenderer
     void setViewport(const glm::ivec2 topRight, const glm::ivec2 bottomLeft = glm::ivec2(0));
 
     void drawPrimatives(PrimativeType primative, GLuint count, const void* indices = nullptr);
+    // Draw a single instance, shaders can index per-instance data with the
+    // base instance.
+    void drawPrimativesBaseInstance(PrimativeType primative, GLuint count,
+                                    GLuint baseInstance);
+    // Draw using the command at an offset into the bound indirect buffer.
+    void drawPrimativesIndirect(PrimativeType primative, GLuint commandOffset);
   };
 }
@@ -7,9 +7,54 @@
 // Macro include file.
 #include "SciRenderPCH.h"
 
+// Project includes.
+#include "Core/ApplicationBase.h"
+
+// STL includes.
+#include <map>
+
 namespace SciRenderer
 {
   enum class AttribType { Vec4 = 4, Vec3 = 3, Vec2 = 2};
+
+  // Defines added to the sources of a shader permutation. Sorted, so a set of
+  // defines always gives the same permutation key.
+  typedef std::map<std::string, std::string> ShaderDefines;
+
+  // KHR_parallel_shader_compile isn't in the loader. The ARB version of the
+  // extension uses the same tokens.
+  #ifndef GL_COMPLETION_STATUS_KHR
+  #define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+  #define GL_COMPLETION_STATUS_KHR 0x91B1
+  #endif
+
+  // A cache of linked program binaries on disk. Binaries are keyed by the hash
+  // of their sources, the defines they were built with and the driver, since
+  // a binary is only valid for the driver which produced it.
+  namespace ProgramCache
+  {
+    struct Stats
+    {
+      GLuint numLoaded;
+      GLuint numCompiled;
+      double buildTime;
+    };
+
+    // The cache path of a program built from the given sources.
+    std::string getPath(const std::string &sources, const std::string &defines = "");
+
+    // Create a program from a cached binary. Returns 0 if there's no binary,
+    // or the driver rejects it.
+    GLuint loadProgram(const std::string &path);
+
+    // Store the binary of a linked program. The program should be linked with
+    // GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    void saveProgram(GLuint program, const std::string &path);
+
+    // Number of programs loaded and compiled this session, and the total time
+    // spent building them.
+    Stats& getStats();
+  }
   enum class UniformType
   {
     Float = GL_FLOAT, Vec2 = GL_FLOAT_VEC2, Vec3 = GL_FLOAT_VEC3,
@@ -24,9 +69,20 @@ namespace SciRenderer
   public:
     // Constructor and destructor.
     Shader();
-    Shader(const std::string &vertPath, const std::string &fragPath);
+    Shader(const std::string &vertPath, const std::string &fragPath,
+           const ShaderDefines &defines = ShaderDefines());
     ~Shader();
 
+    // Get the permutation of this shader with extra defines. Permutations are
+    // built the first time they're requested and rebuilt with the shader.
+    Shader* getVariant(const ShaderDefines &defines);
+
+    // Defines added to every shader, for constants shared with the renderer.
+    // Must be set before the shaders using them are built.
+    static void setGlobalDefine(const std::string &name, const std::string &value);
+
+    static std::string getPermutationKey(const ShaderDefines &defines);
+
     // Shader parser/compiler function.
     void buildShader(int type, const char* filename);
     void buildShaderSource(int type, const std::string &strSource);
@@ -47,6 +103,15 @@ namespace SciRenderer
     // Saves the vertex and fragment shader source code to a new text file.
     void saveSourceToFiles(const std::string &vertPath, const std::string &fragPath);
 
+    // Load the parallel compile extension if the driver supports it.
+    static void initParallelCompile();
+
+    // Compiles and links are submitted without waiting on the driver. Poll
+    // if the program is done without blocking, or wait for it and reflect
+    // the uniforms. Binding the shader finishes the build.
+    bool isReady();
+    void finishBuild();
+
     // Bind/unbind the shader.
     void bind();
     void unbind();
@@ -75,11 +140,12 @@ namespace SciRenderer
 
     // Getters.
     GLuint getShaderID() { return this->progID; }
-    std::string& getInfoString() { return this->shaderInfoString; }
+    std::string& getInfoString() { this->finishBuild(); return this->shaderInfoString; }
     std::string& getVertSource() { return this->vertSource; }
     std::string& getFragSource() { return this->fragSource; }
-    std::vector<std::pair<std::string, UniformType>>& getUniforms() { return this->uniforms; }
-    std::vector<std::string>& getUniformNames() { return this->uniformNames; }
+    const ShaderDefines& getDefines() { return this->defines; }
+    std::vector<std::pair<std::string, UniformType>>& getUniforms() { this->finishBuild(); return this->uniforms; }
+    std::vector<std::string>& getUniformNames() { this->finishBuild(); return this->uniformNames; }
 
     // Set the shader source for dynamic rebuilding.
     void setVertSource(const std::string &source) { this->vertSource = source; }
@@ -102,7 +168,29 @@ namespace SciRenderer
     std::string shaderInfoString;
     std::vector<std::pair<std::string, UniformType>> uniforms;
     std::vector<std::string> uniformNames;
+
+    // If the build still has to be finished, and where to cache its binary.
+    bool pending;
+    std::string binaryPath;
+
+    // The defines of this permutation, and the permutations built from it.
+    ShaderDefines defines;
+    std::unordered_map<std::string, Unique<Shader>> variants;
+
+    static bool parallelCompile;
+    static ShaderDefines globalDefines;
   private:
       char *readShaderFile(const char* filename);
+
+      // Build the program from the vertex and fragment sources, or load the
+      // binary of a previous build of the same sources.
+      void buildCachedProgram(bool fromFiles);
+
+      void checkShader(GLuint shaderID, const std::string &filename);
+
+      // Expand the includes of a source and add the defines after its version
+      // directive. Includes are relative to the file the source is from.
+      std::string preprocess(const std::string &source, const std::string &filepath);
+      GLuint compileShader(int type, const std::string &source);
   };
 }
@@ -0,0 +1,72 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Buffers.h"
+#include "Graphics/Camera.h"
+#include "Graphics/Compute.h"
+#include "Graphics/GPUTimer.h"
+
+// Length of the jitter sequence.
+#define TAA_JITTER_SAMPLES 8
+
+namespace SciRenderer
+{
+  // Temporal anti-aliasing. The scene geometry is drawn with a sub-pixel
+  // jitter which follows a Halton (2, 3) sequence, and each frame is blended
+  // with the history reprojected through the gbuffer velocity. The history is
+  // clamped to the colour range of the pixel's neighbourhood this frame, so
+  // disocclusions and shading changes don't ghost.
+  class TemporalAA
+  {
+  public:
+    TemporalAA(GLuint width, GLuint height);
+    ~TemporalAA();
+
+    void resize(GLuint width, GLuint height);
+
+    // The jitter for the next frame in normalized device coordinates, a
+    // sub-pixel offset at the size rendered at.
+    glm::vec2 nextJitter(const glm::uvec2 &renderSize);
+
+    // Resolve this frame against the history, over the corner of the buffers
+    // which was rendered to. The lit scene and the gbuffer velocity must be
+    // bound to texture units 0 and 1.
+    void resolve(Shared<Camera> camera, const glm::uvec2 &renderSize);
+
+    // Bind the anti-aliased frame to a texture unit.
+    void bind(GLuint textureUnit);
+
+    // Forget the history, for when it can't be reprojected (camera cuts,
+    // resizes, toggling the effect).
+    void resetHistory() { this->historyValid = false; }
+
+    // Most recent GPU time in milliseconds.
+    GLfloat getTime() { return this->timer.getTime(); }
+    GLuint getResultID() { return this->history[this->current]; }
+  private:
+    void createTextures();
+    void deleteTextures();
+
+    GLuint width;
+    GLuint height;
+
+    // The anti-aliased frames, this frame's result and the previous one.
+    GLuint history[2];
+    GLuint current;
+
+    GLuint frameIndex;
+    glm::mat4 prevViewProj;
+    glm::uvec2 prevRenderSize;
+    bool historyValid;
+
+    ComputeShader resolveShader;
+    ShaderStorageBuffer paramBuffer;
+
+    GPUTimer timer;
+  };
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Graphics/Textures.h"
+#include "Graphics/MipGenerator.h"
+
+namespace SciRenderer
+{
+  // A block compressed image with (part of) its mip chain. Each mip level is
+  // stored as tightly packed 4x4 blocks, mips[0] is level firstMip. The width
+  // and height are always those of level 0.
+  struct CompressedImage
+  {
+    TextureCompression format;
+    GLuint width;
+    GLuint height;
+    GLuint firstMip;
+    std::vector<std::vector<unsigned char>> mips;
+
+    CompressedImage()
+      : format(TextureCompression::None)
+      , width(0)
+      , height(0)
+      , firstMip(0)
+    { }
+  };
+
+  // Offline texture cooking. Images are encoded to BC1/3/4/5/7 (LDR) or BC6H
+  // (HDR) with a full mip chain and cached as a DDS file in the content
+  // addressed asset cache. The encoders are pure CPU functions, safe to call
+  // from the workers.
+  namespace TextureCooker
+  {
+    // Pick the compressed format for an image. Auto maps 1 and 2 channel
+    // images to BC4/BC5, 3 and 4 channel images to BC7 and HDR images to BC6H.
+    TextureCompression resolveFormat(TextureCompression requested, int n, bool isHDR);
+
+    // OpenGL internal format and block size (in bytes) of a compressed format.
+    GLenum getGLFormat(TextureCompression format);
+    GLuint getBlockSize(TextureCompression format);
+
+    // Number of channels a compressed format stores.
+    int getNumChannels(TextureCompression format);
+
+    // Number of levels in a full mip chain, and the size of a level in bytes.
+    GLuint getNumMips(GLuint width, GLuint height);
+    GLuint getLevelSize(TextureCompression format, GLuint width, GLuint height,
+                        GLuint level);
+
+    // Build the mip chain of a level with the mip generator and encode each
+    // level into compressed blocks as it's built. The base level is left
+    // untouched if the format doesn't match the image.
+    bool cookImage(MipLevel &&baseLevel, TextureMipFilter filter, bool isSRGB,
+                   bool isHDR, TextureCompression format, CompressedImage &outImage);
+
+    // The path of the cooked file for a source image in the asset cache. It
+    // depends on the contents of the source and every setting which changes
+    // the cooked result. Images which aren't compressed are cached as their
+    // packed mip chain instead of a DDS file. Empty if the source can't be
+    // read.
+    std::string getCookedPath(const std::string &sourcePath, const Texture2DParams &params);
+
+    // DDS (DX10 header) input and output. Files are written atomically.
+    // Reading can be restricted to the levels [firstMip, lastMip), which is
+    // how the streamer fetches mips.
+    bool writeDDS(const std::string &filepath, const CompressedImage &image);
+    bool readDDS(const std::string &filepath, CompressedImage &outImage,
+                 GLuint firstMip = 0, GLuint lastMip = ~0u);
+  }
+}
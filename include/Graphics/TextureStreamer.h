@@ -0,0 +1,119 @@
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Textures.h"
+#include "Graphics/TextureCompression.h"
+
+// STL includes.
+#include <mutex>
+
+namespace SciRenderer
+{
+  // Residency of a streamed texture. Mip levels are those of the cooked chain,
+  // so level 0 is always the full resolution image.
+  struct StreamedTexture
+  {
+    std::string cookedPath;
+    TextureCompression format;
+    GLuint width;
+    GLuint height;
+    GLuint numMips;
+
+    // The finest level on the GPU. Levels coarser than tailMip never leave.
+    GLuint residentMip;
+    GLuint tailMip;
+
+    // The finest level the renderer asked for this frame and the level it
+    // last asked for, in the frame it asked for it.
+    GLuint requestedMip;
+    GLuint wantedMip;
+    GLuint64 lastRequestFrame;
+
+    // The finest level being read from disk (numMips if nothing is) and the
+    // ID of that read, so stale reads can be dropped.
+    GLuint pendingMip;
+    GLuint64 pendingRequest;
+
+    StreamedTexture()
+      : format(TextureCompression::None)
+      , width(0)
+      , height(0)
+      , numMips(0)
+      , residentMip(0)
+      , tailMip(0)
+      , requestedMip(0)
+      , wantedMip(0)
+      , lastRequestFrame(0)
+      , pendingMip(0)
+      , pendingRequest(0)
+    { }
+  };
+
+  // Mip levels read from disk by a worker.
+  struct StreamedMips
+  {
+    Texture2D* texture;
+    GLuint64 request;
+    CompressedImage image;
+  };
+
+  // Streams the mip levels of cooked textures in and out under a VRAM budget.
+  // The renderer records the finest mip each texture needs every frame, the
+  // streamer then loads missing levels on the workers and evicts the levels
+  // which are no longer needed (or don't fit) on the main thread.
+  class TextureStreamer
+  {
+  public:
+    ~TextureStreamer() = default;
+
+    static TextureStreamer* getInstance();
+
+    // Levels this size and smaller are uploaded with the texture and are
+    // always resident.
+    static GLuint getTailMip(GLuint width, GLuint height);
+
+    // Start streaming a texture which was created with the levels from
+    // residentMip down.
+    void addTexture(Texture2D* texture, const std::string &cookedPath,
+                    TextureCompression format, GLuint residentMip);
+    void removeTexture(Texture2D* texture);
+
+    // Record the finest mip needed this frame, or derive it from the number of
+    // pixels the texture covers on screen.
+    void requestMip(Texture2D* texture, GLuint mip);
+    void requestScreenSize(Texture2D* texture, GLfloat screenSize);
+
+    // Upload the mips read since the last frame, then evict and request mips
+    // so the resident textures fit in vramBudget bytes. Returns the bytes
+    // uploaded, stopping once uploadBudget bytes have been uploaded.
+    GLuint update(GLuint uploadBudget, GLuint64 vramBudget);
+
+    // Statistics.
+    GLuint64 getResidentBytes(const StreamedTexture &texture);
+    GLuint64 getTotalResidentBytes();
+    GLuint64 getTotalFullBytes();
+
+    std::unordered_map<Texture2D*, StreamedTexture>& getTextures() { return this->textures; }
+    StreamedTexture* getTexture(Texture2D* texture);
+  private:
+    TextureStreamer();
+
+    // Recreate the texture with levels from newResidentMip down. Levels which
+    // are already resident are copied on the GPU, the others come from mips.
+    void rebuildTexture(Texture2D* texture, StreamedTexture &state,
+                        GLuint newResidentMip, const CompressedImage* mips = nullptr);
+
+    static TextureStreamer* instance;
+
+    std::unordered_map<Texture2D*, StreamedTexture> textures;
+    GLuint64 frame;
+    GLuint64 nextRequest;
+
+    std::queue<StreamedMips> completedReads;
+    std::mutex readMutex;
+  };
+}
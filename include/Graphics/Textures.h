@@ -5,6 +5,7 @@
 
 // Project includes.
 #include "Core/ApplicationBase.h"
+#include "Graphics/Buffers.h"
 
 // STL includes.
 #include <mutex>
@@ -55,6 +56,19 @@ namespace SciRenderer
     PosZ = GL_TEXTURE_CUBE_MAP_POSITIVE_Z, NegZ = GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
   };
 
+  // Block compression formats textures can be cooked to. Auto picks a format
+  // from the channel count and dynamic range of the image.
+  enum class TextureCompression
+  {
+    None, Auto, BC1, BC3, BC4, BC5, BC6H, BC7
+  };
+
+  // Filters for building mip chains on the CPU.
+  enum class TextureMipFilter
+  {
+    Box, Triangle, Kaiser
+  };
+
   // Parameters for loading textures.
   struct Texture2DParams
   {
@@ -62,12 +76,21 @@ namespace SciRenderer
     TextureWrapParams      tWrap;
     TextureMinFilterParams minFilter;
     TextureMaxFilterParams maxFilter;
+    TextureCompression     compression;
+    TextureMipFilter       mipFilter;
+
+    // Colour channels are gamma encoded (albedo maps), mips are filtered in
+    // linear space.
+    bool                   isSRGB;
 
     Texture2DParams()
       : sWrap(TextureWrapParams::Repeat)
       , tWrap(TextureWrapParams::Repeat)
       , minFilter(TextureMinFilterParams::Linear)
       , maxFilter(TextureMaxFilterParams::Linear)
+      , compression(TextureCompression::Auto)
+      , mipFilter(TextureMipFilter::Kaiser)
+      , isSRGB(false)
     { };
   };
 
@@ -94,12 +117,30 @@ namespace SciRenderer
     int height;
     int n;
 
+    // The pixels are either in client memory (data) or were written straight
+    // into the upload ring by the worker (isStaged, stagingOffset). Either way
+    // they're in the layout the texture is uploaded with.
     void* data;
+    bool isStaged;
+    GLuint stagingOffset;
+    GLuint dataSize;
+
+    // The whole mip chain is built by the loader. Level firstMip + i starts
+    // mipOffsets[i] bytes into the pixels. Cooked images only hold the tail
+    // of their chain as compressed blocks, the finer levels are streamed in on
+    // demand.
+    TextureCompression compression;
+    GLuint firstMip;
+    std::vector<GLuint> mipOffsets;
+    std::vector<GLuint> mipSizes;
 
     bool isHDR;
     Texture2DParams params;
     std::string name;
     std::string filepath;
+
+    // The cooked file in the asset cache, empty if it couldn't be written.
+    std::string cookedPath;
   };
 
   //----------------------------------------------------------------------------
@@ -112,7 +153,20 @@ namespace SciRenderer
     static std::queue<ImageData2D> asyncTexQueue;
     static std::mutex asyncTexMutex;
 
-    static void bulkGenerateTextures();
+    // Ring buffer the workers stage decoded pixels in.
+    static Unique<PixelUnpackRing> uploadRing;
+
+    // Create the upload ring. Must be called on the main thread, the workers
+    // fall back to client memory until this is called.
+    static void initAsyncUploads(GLuint ringSize);
+
+    // Destroy the upload ring. Must be called on the main thread before the
+    // context is destroyed.
+    static void shutdownUploads();
+
+    // Create the textures for the loaded images. Stops once uploadBudget bytes
+    // have been uploaded, returns the bytes uploaded.
+    static GLuint bulkGenerateTextures(GLuint uploadBudget);
     static void loadImageAsync(const std::string &filepath,
                                const Texture2DParams &params = Texture2DParams());
 
@@ -124,7 +178,8 @@ namespace SciRenderer
                                        bool cache = true);
 
     // This loads an image and generates the texture all at once, does so on the
-    // main thread due to OpenGL thread safety.
+    // main thread due to OpenGL thread safety. Uses the cooked image if one is
+    // up to date, but never cooks (that's left to the asynchronous loader).
     static Texture2D* loadTexture2D(const std::string &filepath, const Texture2DParams &params
                                     = Texture2DParams(), bool cache = true);
 
@@ -147,10 +202,14 @@ namespace SciRenderer
 
     GLuint& getID() { return this->textureID; }
     std::string& getFilepath() { return this->filepath; }
+
+    // If the mips of the texture are managed by the texture streamer.
+    bool& isStreamed() { return this->streamed; }
   private:
     GLuint textureID;
 
     std::string filepath;
+    bool streamed;
   };
 
   //----------------------------------------------------------------------------
@@ -0,0 +1,69 @@
+// Include guard.
+#pragma once
+
+// Macro include file.
+#include "SciRenderPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Buffers.h"
+#include "Graphics/FrameBuffer.h"
+#include "Graphics/GeometryBuffer.h"
+
+// Average number of fragments per pixel the linked lists have room for.
+#define OIT_NODES_PER_PIXEL 4
+
+namespace SciRenderer
+{
+  // How the transparent fragments of a pixel are combined.
+  enum class OITMode : GLuint { WeightedBlended = 0, LinkedList = 1 };
+
+  // Order independent transparency. Transparent surfaces are drawn after the
+  // lighting pass against the opaque depth, in any order. Weighted blended
+  // transparency accumulates the fragments with a weight which falls off with
+  // distance, an approximation which doesn't need any sorting. Linked lists
+  // store every fragment of a pixel and sort them when compositing, which is
+  // exact up to the memory available, for comparisons.
+  class Transparency
+  {
+  public:
+    Transparency(GLuint width, GLuint height);
+    ~Transparency();
+
+    void resize(GLuint width, GLuint height);
+
+    // Switch modes. The linked lists take a lot of memory, they're only
+    // allocated while the linked list mode is in use.
+    void setMode(OITMode mode);
+
+    // Bind the targets for drawing transparent geometry, depth tested against
+    // the gbuffer.
+    void begin(OITMode mode, GeometryBuffer &gBuffer, const glm::uvec2 &renderSize);
+    void end(OITMode mode);
+
+    // Bind the accumulated fragments for compositing. Weighted blended uses
+    // texture units 0 and 1, linked lists use image unit 0 and storage
+    // binding 8.
+    void bindResults(OITMode mode);
+
+    // Blend function for compositing over the lit scene. The composite
+    // outputs the transparent colour and the transmittance as alpha.
+    static void setCompositeBlending();
+
+    GLuint getAccumulationID() { return this->oitBuffer.getAttachID(FBOTargetParam::Colour0); }
+  private:
+    void createLists();
+    void deleteLists();
+
+    GLuint width;
+    GLuint height;
+
+    // Weighted blended targets.
+    FrameBuffer oitBuffer;
+
+    // Linked list heads and nodes, zero and empty while they aren't used.
+    GLuint headPointers;
+    GLuint maxNodes;
+    Unique<ShaderStorageBuffer> nodeBuffer;
+  };
+}
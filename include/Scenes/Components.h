@@ -134,14 +134,20 @@ namespace SciRenderer
     // Name so we can fetch the associated model.
     std::string meshName;
 
+    // Importer settings used when loading the model.
+    ModelImportFlags importFlags;
+
     RenderableComponent(const RenderableComponent&) = default;
 
     RenderableComponent()
       : meshName("")
+      , importFlags(ModelImportFlags_Default)
     { }
 
-    RenderableComponent(const std::string &meshName)
+    RenderableComponent(const std::string &meshName,
+                        ModelImportFlags importFlags = ModelImportFlags_Default)
       : meshName(meshName)
+      , importFlags(importFlags)
     { }
 
     operator Model*()
@@ -180,8 +186,9 @@ namespace SciRenderer
 
       ambient->loadEquirectangularMap(iblImagePath);
       ambient->equiToCubeMap(true, state->skyboxWidth, state->skyboxWidth);
-      ambient->precomputeIrradiance(state->irradianceWidth, state->irradianceWidth, true);
-      ambient->precomputeSpecular(state->prefilterWidth, state->prefilterWidth, true);
+      ambient->precomputeIrradiance(true);
+      ambient->precomputeSpecular(state->prefilterWidth, state->prefilterWidth, true,
+                                  state->prefilterSamples);
     }
   };
 
@@ -234,4 +241,20 @@ namespace SciRenderer
       return light;
     }
   };
+
+  struct ReflectionProbeComponent
+  {
+    ReflectionProbe probe;
+
+    ReflectionProbeComponent(const ReflectionProbeComponent&) = default;
+
+    ReflectionProbeComponent()
+      : probe()
+    { }
+
+    operator ReflectionProbe()
+    {
+      return probe;
+    }
+  };
 }
@@ -1,8 +1,10 @@
 #include "Core/Application.h"
 
 // Project includes.
+#include "Core/AssetCache.h"
 #include "Core/Events.h"
 #include "Core/Logs.h"
+#include "Graphics/TextureStreamer.h"
 
 namespace SciRenderer
 {
@@ -14,6 +16,8 @@ namespace SciRenderer
     , running(true)
     , isMinimized(false)
     , lastTime(0.0f)
+    , startTime(std::chrono::steady_clock::now())
+    , firstFrame(true)
   {
     if (Application::appInstance != nullptr)
     {
@@ -39,6 +43,9 @@ namespace SciRenderer
     this->modelAssets.reset(AssetManager<Model>::getManager());
     this->texture2DAssets.reset(AssetManager<Texture2D>::getManager());
 
+    // Constants shared between the renderer and its shaders.
+    Shader::setGlobalDefine("NUM_CASCADES", std::to_string(NUM_CASCADES));
+
     // Load the shaders into a cache.
     this->shaderCache->attachAsset("pbr_shader",
       new Shader("./assets/shaders/mesh.vs",
@@ -52,18 +59,34 @@ namespace SciRenderer
       new Shader("./assets/shaders/deferred/geometryPass.vs",
                  "./assets/shaders/deferred/geometryPass.fs"));
 
+    this->shaderCache->attachAsset("depth_prepass_shader",
+      new Shader("./assets/shaders/deferred/depthPrePass.vs",
+                 "./assets/shaders/deferred/depthPrePass.fs"));
+
     this->shaderCache->attachAsset("deferred_ambient",
       new Shader("./assets/shaders/deferred/lightingPass.vs",
                  "./assets/shaders/deferred/ambientLightingPass.fs"));
 
-    this->shaderCache->attachAsset("deferred_directional_shadowed",
-      new Shader("./assets/shaders/deferred/lightingPass.vs",
-                 "./assets/shaders/deferred/directionalLightPassShadowed.fs"));
+    this->shaderCache->attachAsset("probe_capture",
+      new Shader("./assets/shaders/mesh.vs",
+                 "./assets/shaders/probes/probeCapture.fs"));
 
     this->shaderCache->attachAsset("deferred_directional",
       new Shader("./assets/shaders/deferred/lightingPass.vs",
                  "./assets/shaders/deferred/directionalLightPass.fs"));
 
+    this->shaderCache->attachAsset("forward_plus",
+      new Shader("./assets/shaders/deferred/geometryPass.vs",
+                 "./assets/shaders/forward/pbr/forwardPlus.fs"));
+
+    this->shaderCache->attachAsset("transparent_shader",
+      new Shader("./assets/shaders/deferred/geometryPass.vs",
+                 "./assets/shaders/transparency/transparentPass.fs"));
+
+    this->shaderCache->attachAsset("oit_composite",
+      new Shader("./assets/shaders/post/postProcessingPass.vs",
+                 "./assets/shaders/transparency/oitComposite.fs"));
+
     this->shaderCache->attachAsset("post_hdr",
       new Shader("./assets/shaders/post/postProcessingPass.vs",
                  "./assets/shaders/post/hdrPostPass.fs"));
@@ -88,6 +111,12 @@ namespace SciRenderer
       new Shader("./assets/shaders/viewport.vs",
                  "./assets/shaders/viewport.fs"));
 
+    // Staging memory for asynchronous texture uploads.
+    Texture2D::initAsyncUploads(64 * 1024 * 1024);
+
+    // Cooked assets from previous sessions, evict whatever doesn't fit.
+    AssetCache::getInstance()->trim();
+
     // Load the default assets.
     this->texture2DAssets->setDefaultAsset(Texture2D::createMonoColour(
       glm::vec4(1.0f, 0.0f, 1.0f, 1.0f), Texture2DParams(), false));
@@ -174,9 +203,32 @@ namespace SciRenderer
       }
 
       // Must be called at the end of every frame to create textures with loaded
-      // images.
-      Texture2D::bulkGenerateTextures();
-      Model::bulkGenerateMaterials();
+      // images, stream texture mips and upload streamed submeshes. All of them
+      // share the upload budget, a budget of zero pauses them all. Submeshes
+      // go first with a quarter of the budget so textures can't starve them,
+      // the textures get whatever they leave.
+      GLuint uploadBudget = Renderer3D::getState()->uploadBudget;
+      GLuint uploadedBytes = Model::bulkGenerateMaterials(uploadBudget / 4);
+      uploadBudget = uploadedBytes < uploadBudget ? uploadBudget - uploadedBytes : 0;
+
+      uploadedBytes = Texture2D::bulkGenerateTextures(uploadBudget);
+      uploadBudget = uploadedBytes < uploadBudget ? uploadBudget - uploadedBytes : 0;
+
+      GLuint64 streamingBudget = (GLuint64) Renderer3D::getState()->streamingBudget * 1024 * 1024;
+      TextureStreamer::getInstance()->update(uploadBudget, streamingBudget);
+
+      if (this->firstFrame)
+      {
+        this->firstFrame = false;
+
+        std::chrono::duration<double> startup = std::chrono::steady_clock::now() - this->startTime;
+        auto& stats = ProgramCache::getStats();
+        Logger::getInstance()->logMessage(LogMessage("First frame after "
+          + std::to_string(startup.count()) + " s, "
+          + std::to_string(stats.numLoaded) + " shader programs loaded from the cache and "
+          + std::to_string(stats.numCompiled) + " compiled in "
+          + std::to_string(stats.buildTime) + " s.", true, true));
+      }
     }
   }
 
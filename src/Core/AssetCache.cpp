@@ -0,0 +1,301 @@
+#include "Core/AssetCache.h"
+
+// Project includes.
+#include "Core/Logs.h"
+
+// STL includes.
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+
+namespace SciRenderer
+{
+  // Default size limit of the cache, in bytes.
+  static const GLuint64 defaultCacheSize = 4ull * 1024ull * 1024ull * 1024ull;
+
+  // Temporary files older than this were left behind by a writer which died.
+  static const auto staleTempAge = std::chrono::hours(1);
+
+  static const GLuint64 fnvOffset = 14695981039346656037ull;
+  static const GLuint64 fnvPrime = 1099511628211ull;
+
+  // FNV-1a over 64 bit words, with the tail hashed byte by byte.
+  static GLuint64
+  hashBytes(const unsigned char* data, size_t size, GLuint64 hash)
+  {
+    size_t numWords = size / sizeof(GLuint64);
+    for (size_t i = 0; i < numWords; i++)
+    {
+      GLuint64 word;
+      memcpy(&word, data + i * sizeof(GLuint64), sizeof(GLuint64));
+      hash = (hash ^ word) * fnvPrime;
+    }
+
+    for (size_t i = numWords * sizeof(GLuint64); i < size; i++)
+      hash = (hash ^ data[i]) * fnvPrime;
+
+    return hash;
+  }
+
+  static std::string
+  toHex(GLuint64 value)
+  {
+    std::stringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << value;
+    return stream.str();
+  }
+
+  static bool
+  isTempFile(const std::filesystem::path &path)
+  {
+    return path.filename().string().find(".tmp") != std::string::npos;
+  }
+
+  AssetCache* AssetCache::instance = nullptr;
+  std::mutex AssetCache::cacheMutex;
+
+  AssetCache::AssetCache()
+    : directory("./assets/.cache/")
+    , sizeLimit(defaultCacheSize)
+    , cacheSize(0)
+  {
+    std::error_code error;
+    std::filesystem::create_directories(this->directory, error);
+  }
+
+  AssetCache*
+  AssetCache::getInstance()
+  {
+    std::lock_guard<std::mutex> guard(cacheMutex);
+
+    if (instance == nullptr)
+    {
+      instance = new AssetCache();
+      return instance;
+    }
+    else
+      return instance;
+  }
+
+  bool
+  AssetCache::hashFile(const std::string &filepath, GLuint64 &outHash)
+  {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(filepath, error);
+    if (error)
+      return false;
+    int64_t modified = std::filesystem::last_write_time(filepath, error).time_since_epoch().count();
+    if (error)
+      return false;
+
+    {
+      std::lock_guard<std::mutex> guard(cacheMutex);
+      auto loc = this->fileHashes.find(filepath);
+      if (loc != this->fileHashes.end() && loc->second.size == size
+          && loc->second.modified == modified)
+      {
+        outHash = loc->second.hash;
+        return true;
+      }
+    }
+
+    std::ifstream input(filepath, std::ios::binary);
+    if (!input.is_open())
+      return false;
+
+    // Chunks are a multiple of the word size, so the result doesn't depend
+    // on how the file is split up.
+    std::vector<unsigned char> chunk(1024 * 1024);
+    GLuint64 hash = fnvOffset;
+    while (input)
+    {
+      input.read(reinterpret_cast<char*>(chunk.data()), chunk.size());
+      hash = hashBytes(chunk.data(), input.gcount(), hash);
+    }
+    if (input.bad())
+      return false;
+
+    std::lock_guard<std::mutex> guard(cacheMutex);
+    this->fileHashes[filepath] = { size, modified, hash };
+    outHash = hash;
+
+    return true;
+  }
+
+  std::string
+  AssetCache::getKey(const std::string &sourcePath, const std::string &settings)
+  {
+    GLuint64 sourceHash;
+    if (!this->hashFile(sourcePath, sourceHash))
+      return "";
+
+    GLuint64 settingsHash = hashBytes(reinterpret_cast<const unsigned char*>(settings.data()),
+                                      settings.size(), fnvOffset);
+
+    return toHex(sourceHash) + toHex(settingsHash);
+  }
+
+  std::string
+  AssetCache::getDataKey(const std::string &data, const std::string &settings)
+  {
+    GLuint64 dataHash = hashBytes(reinterpret_cast<const unsigned char*>(data.data()),
+                                  data.size(), fnvOffset);
+    GLuint64 settingsHash = hashBytes(reinterpret_cast<const unsigned char*>(settings.data()),
+                                      settings.size(), fnvOffset);
+
+    return toHex(dataHash) + toHex(settingsHash);
+  }
+
+  std::string
+  AssetCache::getPath(const std::string &key, const std::string &extension)
+  {
+    return this->directory + key + extension;
+  }
+
+  std::string
+  AssetCache::getTempPath(const std::string &path)
+  {
+    std::size_t threadID = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return path + ".tmp" + std::to_string(getpid()) + "_" + std::to_string(threadID);
+  }
+
+  bool
+  AssetCache::commitFile(const std::string &tempPath, const std::string &path)
+  {
+    // Rename replaces the destination atomically. If another instance wrote
+    // the same entry first the contents are identical anyway.
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(tempPath, error);
+    if (error)
+      size = 0;
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+      std::filesystem::remove(tempPath, error);
+      return false;
+    }
+
+    if (this->cacheSize.fetch_add(size) + size > this->sizeLimit)
+      this->trim();
+    return true;
+  }
+
+  bool
+  AssetCache::readBlob(const std::string &path, std::vector<unsigned char> &outBlob)
+  {
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+    if (!input.is_open())
+      return false;
+
+    outBlob.resize(input.tellg());
+    input.seekg(0, std::ios::beg);
+    input.read(reinterpret_cast<char*>(outBlob.data()), outBlob.size());
+    if (!input)
+      return false;
+
+    this->touch(path);
+    return true;
+  }
+
+  bool
+  AssetCache::writeBlob(const std::string &path, const std::vector<unsigned char> &blob)
+  {
+    std::string tempPath = this->getTempPath(path);
+    std::ofstream output(tempPath, std::ios::binary);
+    if (!output.is_open())
+      return false;
+
+    output.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+    output.close();
+
+    if (!output)
+    {
+      std::error_code error;
+      std::filesystem::remove(tempPath, error);
+      return false;
+    }
+
+    return this->commitFile(tempPath, path);
+  }
+
+  void
+  AssetCache::touch(const std::string &path)
+  {
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+  }
+
+  void
+  AssetCache::trim()
+  {
+    std::lock_guard<std::mutex> guard(cacheMutex);
+
+    const auto now = std::filesystem::file_time_type::clock::now();
+
+    struct CacheEntry
+    {
+      std::filesystem::path path;
+      std::filesystem::file_time_type lastUsed;
+      uintmax_t size;
+    };
+    std::vector<CacheEntry> entries;
+    GLuint64 totalSize = 0;
+
+    std::error_code error;
+    for (auto& file : std::filesystem::directory_iterator(this->directory, error))
+    {
+      if (!file.is_regular_file(error))
+        continue;
+
+      auto lastUsed = file.last_write_time(error);
+      if (error)
+        continue;
+
+      // Other writers may still be busy with their temporary files.
+      if (isTempFile(file.path()))
+      {
+        if (now - lastUsed > staleTempAge)
+          std::filesystem::remove(file.path(), error);
+        continue;
+      }
+
+      uintmax_t size = file.file_size(error);
+      if (error)
+        continue;
+
+      entries.push_back({ file.path(), lastUsed, size });
+      totalSize += size;
+    }
+
+    if (totalSize <= this->sizeLimit)
+    {
+      this->cacheSize = totalSize;
+      return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const CacheEntry &a, const CacheEntry &b)
+    {
+      return a.lastUsed < b.lastUsed;
+    });
+
+    // Another instance may have evicted an entry already, it still counts as
+    // freed.
+    GLuint numEvicted = 0;
+    for (auto& entry : entries)
+    {
+      if (totalSize <= this->sizeLimit)
+        break;
+
+      std::filesystem::remove(entry.path, error);
+      totalSize -= entry.size;
+      numEvicted++;
+    }
+    this->cacheSize = totalSize;
+
+    Logger::getInstance()->logMessage(LogMessage("Evicted " + std::to_string(numEvicted)
+                                                 + " entries from the asset cache.",
+                                                 true, true));
+  }
+}
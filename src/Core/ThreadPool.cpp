@@ -18,22 +18,29 @@ namespace SciRenderer
     {
       while (true)
       {
-        std::unique_lock<std::mutex> taskLock(parentPool->taskMutex);
-        parentPool->signal.wait(taskLock, [parentPool]()
+        Shared<Job> task;
         {
-          return !parentPool->tasks.empty();
-        });
+          std::unique_lock<std::mutex> taskLock(parentPool->taskMutex);
+          parentPool->signal.wait(taskLock, [parentPool]()
+          {
+            return !parentPool->tasks.empty();
+          });
 
-        if (!parentPool->isActive.load(std::memory_order_relaxed))
-          break;
+          if (!parentPool->isActive.load(std::memory_order_relaxed))
+            break;
 
-        // This fixes a weird bug where occasionally the thread will just
-        // advance past the barrier?
-        if (parentPool->tasks.size() < 1)
-          continue;
+          // This fixes a weird bug where occasionally the thread will just
+          // advance past the barrier?
+          if (parentPool->tasks.size() < 1)
+            continue;
 
-        (*parentPool->tasks.front()).execute();
-        parentPool->tasks.pop();
+          task = parentPool->tasks.front();
+          parentPool->tasks.pop();
+        }
+
+        // Execute outside of the lock so the workers actually run in parallel
+        // and jobs can push more jobs.
+        task->execute();
       }
     };
 
@@ -60,6 +67,23 @@ namespace SciRenderer
     }
   }
 
+  bool
+  ThreadPool::executeNext()
+  {
+    Shared<Job> task;
+    {
+      std::unique_lock<std::mutex> taskLock(this->taskMutex);
+      if (this->tasks.empty())
+        return false;
+
+      task = this->tasks.front();
+      this->tasks.pop();
+    }
+
+    task->execute();
+    return true;
+  }
+
   ThreadPool*
   ThreadPool::getInstance(unsigned int numThreads)
   {
@@ -0,0 +1,172 @@
+#include "Graphics/AmbientOcclusion.h"
+
+namespace SciRenderer
+{
+  // The parameters shared by the occlusion and resolve passes.
+  struct AOParams
+  {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 prevViewProj;
+    glm::vec2 aoSize;
+    glm::vec2 screenSize;
+    GLfloat radius;
+    GLfloat power;
+    GLfloat blend;
+    GLuint frameIndex;
+    GLuint downsample;
+    GLuint historyValid;
+    glm::vec2 historyScale;
+  };
+
+  AmbientOcclusion::AmbientOcclusion(GLuint width, GLuint height)
+    : width(width)
+    , height(height)
+    , rawAO(0)
+    , current(0)
+    , frameIndex(0)
+    , prevViewProj(glm::mat4(1.0f))
+    , prevRenderSize(glm::uvec2(width, height))
+    , historyValid(false)
+    , lastMode(AOMode::Off)
+    , aoShader("./assets/shaders/compute/gtao.cs")
+    , resolveShader("./assets/shaders/compute/aoResolve.cs")
+    , paramBuffer(sizeof(AOParams), BufferType::Dynamic)
+  {
+    this->history[0] = 0;
+    this->history[1] = 0;
+    this->createTextures();
+  }
+
+  AmbientOcclusion::~AmbientOcclusion()
+  {
+    this->deleteTextures();
+  }
+
+  void
+  AmbientOcclusion::createTextures()
+  {
+    // The raw occlusion is allocated at full size, half resolution only
+    // uses a corner of it.
+    glGenTextures(1, &this->rawAO);
+    glGenTextures(2, this->history);
+
+    GLuint textures[3] = { this->rawAO, this->history[0], this->history[1] };
+    for (unsigned i = 0; i < 3; i++)
+    {
+      glBindTexture(GL_TEXTURE_2D, textures[i]);
+      glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG32F, this->width, this->height);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    this->historyValid = false;
+  }
+
+  void
+  AmbientOcclusion::deleteTextures()
+  {
+    glDeleteTextures(1, &this->rawAO);
+    glDeleteTextures(2, this->history);
+  }
+
+  void
+  AmbientOcclusion::resize(GLuint width, GLuint height)
+  {
+    if (this->width == width && this->height == height)
+      return;
+
+    this->width = width;
+    this->height = height;
+
+    this->deleteTextures();
+    this->createTextures();
+  }
+
+  void
+  AmbientOcclusion::compute(Shared<Camera> camera, const glm::uvec2 &renderSize,
+                            AOMode mode, GLfloat radius, GLfloat power)
+  {
+    if (mode == AOMode::Off)
+    {
+      this->lastMode = mode;
+      return;
+    }
+
+    if (mode != this->lastMode)
+      this->historyValid = false;
+    this->lastMode = mode;
+
+    GPUTimer &timer = mode == AOMode::Full ? this->fullTimer : this->halfTimer;
+    timer.begin();
+
+    GLuint downsample = mode == AOMode::Half ? 2 : 1;
+    glm::uvec2 aoSize = (renderSize + glm::uvec2(downsample - 1)) / downsample;
+
+    glm::mat4 viewProj = camera->getProjMatrix() * camera->getViewMatrix();
+
+    AOParams params;
+    params.view = camera->getViewMatrix();
+    params.proj = camera->getProjMatrix();
+    params.prevViewProj = this->prevViewProj;
+    params.aoSize = glm::vec2(aoSize);
+    params.screenSize = glm::vec2(renderSize);
+    params.radius = radius;
+    params.power = power;
+    params.blend = 0.1f;
+    params.frameIndex = this->frameIndex;
+    params.downsample = downsample;
+    params.historyValid = this->historyValid ? 1 : 0;
+    // The history covers last frame's render size.
+    params.historyScale = glm::vec2(this->prevRenderSize)
+                        / glm::vec2((GLfloat) this->width, (GLfloat) this->height);
+    this->paramBuffer.setData(0, sizeof(AOParams), &params);
+    this->paramBuffer.bindToPoint(2);
+
+    // Occlusion at the working resolution.
+    glBindImageTexture(0, this->rawAO, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+    this->aoShader.launchCompute(glm::ivec3((aoSize.x + 7) / 8, (aoSize.y + 7) / 8, 1));
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    // Upsample and accumulate with the previous frames.
+    GLuint previous = this->current;
+    this->current = 1 - this->current;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, this->rawAO);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, this->history[previous]);
+    glBindImageTexture(0, this->history[this->current], 0, GL_FALSE, 0,
+                       GL_WRITE_ONLY, GL_RG32F);
+    this->resolveShader.launchCompute(glm::ivec3((renderSize.x + 7) / 8,
+                                                 (renderSize.y + 7) / 8, 1));
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    timer.end();
+
+    this->prevViewProj = viewProj;
+    this->prevRenderSize = renderSize;
+    this->historyValid = true;
+    this->frameIndex++;
+  }
+
+  void
+  AmbientOcclusion::bind(GLuint textureUnit)
+  {
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D, this->history[this->current]);
+  }
+
+  GLfloat
+  AmbientOcclusion::getTime(AOMode mode)
+  {
+    switch (mode)
+    {
+      case AOMode::Full: return this->fullTimer.getTime();
+      case AOMode::Half: return this->halfTimer.getTime();
+      default: return 0.0f;
+    }
+  }
+}
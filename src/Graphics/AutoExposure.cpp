@@ -0,0 +1,98 @@
+#include "Graphics/AutoExposure.h"
+
+namespace SciRenderer
+{
+  // The parameters of the histogram and adaptation passes.
+  struct ExposureParams
+  {
+    glm::vec2 renderSize;
+    GLfloat minLogLuminance;
+    GLfloat logLuminanceRange;
+    GLfloat adaptation;
+    GLfloat compensation;
+    GLuint resetHistory;
+    GLfloat padding;
+  };
+
+  // Layout of the exposure buffer. The histogram is built up during the frame,
+  // the last histogram is a copy kept for debugging.
+  struct ExposureData
+  {
+    GLuint histogram[LUMINANCE_HISTOGRAM_BINS];
+    GLuint lastHistogram[LUMINANCE_HISTOGRAM_BINS];
+    GLfloat averageLuminance;
+    GLfloat exposure;
+  };
+
+  AutoExposure::AutoExposure()
+    : minLogLuminance(-10.0f)
+    , logLuminanceRange(22.0f)
+    , historyValid(false)
+    , lastTime(std::chrono::steady_clock::now())
+    , histogramShader("./assets/shaders/compute/luminanceHistogram.cs")
+    , adaptShader("./assets/shaders/compute/exposureAdapt.cs")
+    , paramBuffer(sizeof(ExposureParams), BufferType::Dynamic)
+    , exposureBuffer(sizeof(ExposureData), BufferType::Dynamic)
+  {
+    ExposureData data;
+    std::fill(data.histogram, data.histogram + LUMINANCE_HISTOGRAM_BINS, 0);
+    std::fill(data.lastHistogram, data.lastHistogram + LUMINANCE_HISTOGRAM_BINS, 0);
+    data.averageLuminance = 0.18f;
+    data.exposure = 1.0f;
+    this->exposureBuffer.setData(0, sizeof(ExposureData), &data);
+  }
+
+  AutoExposure::~AutoExposure()
+  { }
+
+  void
+  AutoExposure::compute(const glm::uvec2 &renderSize, GLfloat compensation,
+                        GLfloat speed)
+  {
+    auto now = std::chrono::steady_clock::now();
+    GLfloat deltaTime = std::chrono::duration<GLfloat>(now - this->lastTime).count();
+    this->lastTime = now;
+
+    this->timer.begin();
+
+    ExposureParams params;
+    params.renderSize = glm::vec2(renderSize);
+    params.minLogLuminance = this->minLogLuminance;
+    params.logLuminanceRange = this->logLuminanceRange;
+    params.adaptation = 1.0f - std::exp(-deltaTime * speed);
+    params.compensation = compensation;
+    params.resetHistory = this->historyValid ? 0 : 1;
+    this->paramBuffer.setData(0, sizeof(ExposureParams), &params);
+    this->paramBuffer.bindToPoint(2);
+    this->exposureBuffer.bindToPoint(3);
+
+    this->histogramShader.launchCompute(glm::ivec3((renderSize.x + 15) / 16,
+                                                   (renderSize.y + 15) / 16, 1));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    this->adaptShader.launchCompute(glm::ivec3(1, 1, 1));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    this->timer.end();
+
+    this->historyValid = true;
+  }
+
+  void
+  AutoExposure::bind(GLuint bindPoint)
+  {
+    this->exposureBuffer.bindToPoint(bindPoint);
+  }
+
+  void
+  AutoExposure::getHistogram(std::vector<GLfloat> &outHistogram)
+  {
+    GLuint histogram[LUMINANCE_HISTOGRAM_BINS];
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    this->exposureBuffer.getData(offsetof(ExposureData, lastHistogram),
+                                 sizeof(histogram), histogram);
+
+    outHistogram.resize(LUMINANCE_HISTOGRAM_BINS);
+    for (unsigned i = 0; i < LUMINANCE_HISTOGRAM_BINS; i++)
+      outHistogram[i] = (GLfloat) histogram[i];
+  }
+}
@@ -0,0 +1,143 @@
+#include "Graphics/Bloom.h"
+
+namespace SciRenderer
+{
+  // The parameters of a level of the downsample and upsample passes.
+  struct BloomParams
+  {
+    glm::vec2 outputSize;
+    glm::vec2 sourceTexel;
+    glm::vec2 sourceScale;
+    GLfloat sourceLod;
+    GLuint firstLevel;
+  };
+
+  Bloom::Bloom(GLuint width, GLuint height)
+    : width(width)
+    , height(height)
+    , mipChain(0)
+    , numMips(1)
+    , resultScale(1.0f)
+    , downsampleShader("./assets/shaders/compute/bloomDownsample.cs")
+    , upsampleShader("./assets/shaders/compute/bloomUpsample.cs")
+    , paramBuffer(sizeof(BloomParams), BufferType::Dynamic)
+  {
+    this->createTextures();
+  }
+
+  Bloom::~Bloom()
+  {
+    this->deleteTextures();
+  }
+
+  void
+  Bloom::createTextures()
+  {
+    GLuint chainWidth = std::max(this->width / 2, 1u);
+    GLuint chainHeight = std::max(this->height / 2, 1u);
+    GLuint levels = (GLuint) std::floor(std::log2(std::max(chainWidth, chainHeight))) + 1;
+    this->numMips = std::min(levels, (GLuint) MAX_BLOOM_MIPS);
+
+    glGenTextures(1, &this->mipChain);
+    glBindTexture(GL_TEXTURE_2D, this->mipChain);
+    glTexStorage2D(GL_TEXTURE_2D, this->numMips, GL_RGBA16F, chainWidth, chainHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, this->numMips - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  void
+  Bloom::deleteTextures()
+  {
+    glDeleteTextures(1, &this->mipChain);
+  }
+
+  void
+  Bloom::resize(GLuint width, GLuint height)
+  {
+    if (this->width == width && this->height == height)
+      return;
+
+    this->width = width;
+    this->height = height;
+
+    this->deleteTextures();
+    this->createTextures();
+  }
+
+  void
+  Bloom::compute(const glm::uvec2 &renderSize)
+  {
+    this->timer.begin();
+
+    // The allocated and rendered size of each level, the scene is level -1.
+    glm::uvec2 allocSize = glm::uvec2(this->width, this->height);
+    glm::uvec2 levelAlloc[MAX_BLOOM_MIPS];
+    glm::uvec2 levelSize[MAX_BLOOM_MIPS];
+    for (GLuint i = 0; i < this->numMips; i++)
+    {
+      levelAlloc[i] = glm::max(allocSize / (2u << i), glm::uvec2(1));
+      levelSize[i] = glm::max(renderSize / (2u << i), glm::uvec2(1));
+    }
+
+    BloomParams params;
+
+    // Down the chain, the first level reads the scene bound to unit 0.
+    for (GLuint i = 0; i < this->numMips; i++)
+    {
+      glm::uvec2 sourceAlloc = i == 0 ? allocSize : levelAlloc[i - 1];
+      glm::uvec2 sourceSize = i == 0 ? renderSize : levelSize[i - 1];
+
+      params.outputSize = glm::vec2(levelSize[i]);
+      params.sourceTexel = 1.0f / glm::vec2(sourceAlloc);
+      params.sourceScale = glm::vec2(sourceSize) / glm::vec2(sourceAlloc);
+      params.sourceLod = i == 0 ? 0.0f : (GLfloat) (i - 1);
+      params.firstLevel = i == 0 ? 1 : 0;
+      this->paramBuffer.setData(0, sizeof(BloomParams), &params);
+      this->paramBuffer.bindToPoint(2);
+
+      if (i == 1)
+      {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, this->mipChain);
+      }
+      glBindImageTexture(0, this->mipChain, i, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+      this->downsampleShader.launchCompute(glm::ivec3((levelSize[i].x + 7) / 8,
+                                                      (levelSize[i].y + 7) / 8, 1));
+      glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    // Back up, adding each level to the one above.
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, this->mipChain);
+    for (GLint i = (GLint) this->numMips - 2; i >= 0; i--)
+    {
+      params.outputSize = glm::vec2(levelSize[i]);
+      params.sourceTexel = 1.0f / glm::vec2(levelAlloc[i + 1]);
+      params.sourceScale = glm::vec2(levelSize[i + 1]) / glm::vec2(levelAlloc[i + 1]);
+      params.sourceLod = (GLfloat) (i + 1);
+      params.firstLevel = 0;
+      this->paramBuffer.setData(0, sizeof(BloomParams), &params);
+      this->paramBuffer.bindToPoint(2);
+
+      glBindImageTexture(0, this->mipChain, i, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA16F);
+      this->upsampleShader.launchCompute(glm::ivec3((levelSize[i].x + 7) / 8,
+                                                    (levelSize[i].y + 7) / 8, 1));
+      glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    this->timer.end();
+
+    this->resultScale = glm::vec2(levelSize[0]) / glm::vec2(levelAlloc[0]);
+  }
+
+  void
+  Bloom::bind(GLuint textureUnit)
+  {
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D, this->mipChain);
+  }
+}
@@ -219,11 +219,11 @@ namespace SciRenderer
                                            BufferType bufferType)
     : filled(false)
     , type(bufferType)
-    , dataSize(dataSize)
+    , dataSize(bufferSize)
   {
     glGenBuffers(1, &this->bufferID);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->bufferID);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, dataSize, nullptr,
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr,
                  static_cast<GLenum>(bufferType));
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
   }
@@ -269,4 +269,149 @@ namespace SciRenderer
 
     this->filled = true;
   }
+
+  void
+  ShaderStorageBuffer::getData(GLuint start, GLuint size, void* outData)
+  {
+    if (start + size > this->dataSize)
+    {
+      std::cout << "Read (" << size << ") at position " << start
+                << " exceeds the maximum buffer size of " << this->dataSize << "."
+                << std::endl;
+      return;
+    }
+    this->bind();
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, start, size, outData);
+    this->unbind();
+  }
+
+  //----------------------------------------------------------------------------
+  // Persistently mapped pixel unpack ring buffer here.
+  //----------------------------------------------------------------------------
+  PixelUnpackRing::PixelUnpackRing(const unsigned &ringSize)
+    : mappedData(nullptr)
+    , ringSize(ringSize)
+    , head(0)
+  {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &this->bufferID);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->bufferID);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, ringSize, nullptr, flags);
+    this->mappedData = static_cast<unsigned char*>(
+      glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, ringSize, flags));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+
+  PixelUnpackRing::~PixelUnpackRing()
+  {
+    for (auto& region : this->regions)
+      if (region.fence)
+        glDeleteSync(region.fence);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->bufferID);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &this->bufferID);
+  }
+
+  void
+  PixelUnpackRing::bind()
+  {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->bufferID);
+  }
+
+  void
+  PixelUnpackRing::unbind()
+  {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+
+  void*
+  PixelUnpackRing::reserve(GLuint size, GLuint &outOffset)
+  {
+    std::lock_guard<std::mutex> ringGuard(this->ringMutex);
+
+    if (!this->mappedData)
+      return nullptr;
+
+    // Keep the regions aligned so any pixel type can be unpacked from them.
+    size = (size + 255) & ~255u;
+    if (size > this->ringSize)
+      return nullptr;
+
+    GLuint offset;
+    if (this->regions.empty())
+    {
+      offset = 0;
+    }
+    else
+    {
+      GLuint tail = this->regions.front().offset;
+      if (this->head > tail)
+      {
+        // Free space at the end of the ring, and at the start before the tail.
+        if (this->head + size <= this->ringSize)
+          offset = this->head;
+        else if (size < tail)
+          offset = 0;
+        else
+          return nullptr;
+      }
+      else
+      {
+        // The ring has wrapped around, free space is between head and tail.
+        if (this->head + size < tail)
+          offset = this->head;
+        else
+          return nullptr;
+      }
+    }
+
+    this->head = offset + size;
+    this->regions.push_back({ offset, size, 0 });
+
+    outOffset = offset;
+    return this->mappedData + offset;
+  }
+
+  void
+  PixelUnpackRing::fence(GLuint offset)
+  {
+    std::lock_guard<std::mutex> ringGuard(this->ringMutex);
+
+    for (auto& region : this->regions)
+    {
+      if (region.offset == offset && !region.fence)
+      {
+        region.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        break;
+      }
+    }
+  }
+
+  void
+  PixelUnpackRing::retire()
+  {
+    std::lock_guard<std::mutex> ringGuard(this->ringMutex);
+
+    while (!this->regions.empty())
+    {
+      auto& region = this->regions.front();
+
+      // Still being written to, or the copy hasn't been issued yet.
+      if (!region.fence)
+        break;
+
+      GLenum status = glClientWaitSync(region.fence, 0, 0);
+      if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        break;
+
+      glDeleteSync(region.fence);
+      this->regions.pop_front();
+    }
+
+    if (this->regions.empty())
+      this->head = 0;
+  }
 }
@@ -12,6 +12,7 @@ namespace SciRenderer
     , camFront(glm::vec3 { 0.0f, 0.0f, -1.0f })
     , camTop(glm::vec3 { 0.0f, 1.0f, 0.0f })
     , proj(glm::mat4(1.0f))
+    , jitter(glm::vec2(0.0f))
     , lastTime(0.0f)
     , lastMouseX(xCenter)
     , lastMouseY(yCenter)
@@ -30,6 +31,7 @@ namespace SciRenderer
     , camFront(glm::vec3 { 0.0f, 0.0f, -1.0f })
     , camTop(glm::vec3 { 0.0f, 1.0f, 0.0f })
     , proj(glm::mat4(1.0f))
+    , jitter(glm::vec2(0.0f))
     , lastTime(0.0f)
     , lastMouseX(xCenter)
     , lastMouseY(yCenter)
@@ -276,6 +278,17 @@ namespace SciRenderer
     return this->proj;
   }
 
+  // The projection matrix offset by the jitter. Moves the projected points
+  // by the jitter after the perspective divide.
+  glm::mat4
+  Camera::getJitteredProjMatrix()
+  {
+    glm::mat4 jittered = this->proj;
+    jittered[2][0] -= this->jitter.x;
+    jittered[2][1] -= this->jitter.y;
+    return jittered;
+  }
+
   // Fetch the camera position (for shading).
   glm::vec3
   Camera::getCamPos()
@@ -1,11 +1,36 @@
 #include "Graphics/Compute.h"
 
+// Project includes.
+#include "Graphics/Shaders.h"
+
 namespace SciRenderer
 {
   ComputeShader::ComputeShader(const std::string &filepath)
+    : progID(0)
+    , computeID(0)
+    , filepath(filepath)
+    , pending(true)
   {
-    this->buildShader(GL_COMPUTE_SHADER, filepath.c_str());
-    this->buildProgram();
+    auto start = std::chrono::steady_clock::now();
+    auto& stats = ProgramCache::getStats();
+
+    // Load the program from the binary cache if it was built before.
+    char* source = readShaderFile(filepath.c_str());
+    std::string path = ProgramCache::getPath(source ? std::string(source) : "");
+    delete[] source;
+
+    this->progID = ProgramCache::loadProgram(path);
+    if (this->progID == 0)
+    {
+      this->buildShader(GL_COMPUTE_SHADER, filepath.c_str());
+      this->buildProgram();
+
+      this->binaryPath = path;
+      stats.numCompiled++;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stats.buildTime += elapsed.count();
   }
 
   ComputeShader::~ComputeShader()
@@ -19,6 +44,7 @@ namespace SciRenderer
   void
   ComputeShader::bind()
   {
+    this->finishBuild();
     glUseProgram(this->progID);
   }
 
@@ -41,26 +67,15 @@ namespace SciRenderer
 	{
 		GLuint shaderID;
 		char *source;
-		int result;
-		char *buffer;
 
 		shaderID = glCreateShader(type);
 		source = readShaderFile(filename);
 		if (source == 0)
 			return;
 
+		// Errors are checked once the program is first bound.
 		glShaderSource(shaderID, 1, (const  GLchar**) &source, 0);
 		glCompileShader(shaderID);
-		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
-		if (result != GL_TRUE)
-		{
-			printf("shader compile error: %s\n",filename);
-			glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &result);
-			buffer = new char[result];
-			glGetShaderInfoLog(shaderID, result, 0, buffer);
-			printf("%s\n", buffer);
-			delete buffer;
-		}
 
 		switch (type)
 		{
@@ -80,20 +95,48 @@ namespace SciRenderer
     this->progID = glCreateProgram();
     glAttachShader(this->progID, this->computeID);
 
-    int result;
+    glProgramParameteri(this->progID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(this->progID);
-		glGetProgramiv(this->progID, GL_LINK_STATUS, &result);
+  }
 
+  // Wait for the driver to finish the program, print any errors and store the
+  // binary.
+  void
+  ComputeShader::finishBuild()
+  {
+    if (!this->pending)
+      return;
+    this->pending = false;
+
+    int result;
     char* buffer;
-		if (result != GL_TRUE)
-		{
-			printf("program link error\n");
-			glGetProgramiv(this->progID, GL_INFO_LOG_LENGTH, &result);
-			buffer = new char[result];
-			glGetProgramInfoLog(this->progID, result, 0, buffer);
-			printf("%s\n",buffer);
-			delete buffer;
-		}
+    if (this->computeID != 0)
+    {
+      glGetShaderiv(this->computeID, GL_COMPILE_STATUS, &result);
+      if (result != GL_TRUE)
+      {
+        printf("shader compile error: %s\n", this->filepath.c_str());
+        glGetShaderiv(this->computeID, GL_INFO_LOG_LENGTH, &result);
+        buffer = new char[result];
+        glGetShaderInfoLog(this->computeID, result, 0, buffer);
+        printf("%s\n", buffer);
+        delete[] buffer;
+      }
+    }
+
+    glGetProgramiv(this->progID, GL_LINK_STATUS, &result);
+    if (result != GL_TRUE)
+    {
+      printf("program link error\n");
+      glGetProgramiv(this->progID, GL_INFO_LOG_LENGTH, &result);
+      buffer = new char[result];
+      glGetProgramInfoLog(this->progID, result, 0, buffer);
+      printf("%s\n",buffer);
+      delete[] buffer;
+    }
+    else if (this->binaryPath != "")
+      ProgramCache::saveProgram(this->progID, this->binaryPath);
+    this->binaryPath = "";
   }
 
   // Read in the shader source code.
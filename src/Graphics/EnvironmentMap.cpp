@@ -2,16 +2,286 @@
 
 // Project includes.
 #include "Core/Logs.h"
+#include "Core/AssetCache.h"
 #include "Core/AssetManager.h"
 #include "Graphics/Buffers.h"
 #include "Graphics/Compute.h"
 
 namespace SciRenderer
 {
+  //----------------------------------------------------------------------------
+  // Precompute cache.
+  //----------------------------------------------------------------------------
+  // The float16 RGBA levels of a 2D texture or cubemap, images[level * numFaces
+  // + face] holds one face of one level.
+  struct HalfFloatTexture
+  {
+    GLuint width;
+    GLuint height;
+    GLuint numFaces;
+    GLuint numMips;
+    std::vector<std::vector<unsigned char>> images;
+  };
+
+  static const unsigned char ktxIdentifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31,
+                                                   0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+  // The path of a precomputed map in the asset cache. Maps depend on the
+  // environment, the shader which computed them and the sizes in settings.
+  // Empty if either file can't be read.
+  static std::string
+  getPrecomputedPath(const std::string &sourcePath, const std::string &shaderPath,
+                     const std::string &settings, const std::string &extension = ".ktx")
+  {
+    auto cache = AssetCache::getInstance();
+    std::string shaderKey = cache->getKey(shaderPath, "");
+    if (shaderKey == "")
+      return "";
+
+    std::string key = cache->getKey(sourcePath, settings + ":" + shaderKey);
+    if (key == "")
+      return "";
+
+    return cache->getPath(key, extension);
+  }
+
+  // Read the first numMips levels of the bound texture back from the GPU.
+  static void
+  readBackTexture(GLuint width, GLuint height, GLuint numFaces, GLuint numMips,
+                  HalfFloatTexture &outTexture)
+  {
+    outTexture.width = width;
+    outTexture.height = height;
+    outTexture.numFaces = numFaces;
+    outTexture.numMips = numMips;
+    outTexture.images.resize(numMips * numFaces);
+
+    // Wait for the compute shaders which wrote the texture.
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    for (GLuint level = 0; level < numMips; level++)
+    {
+      GLuint mipWidth = std::max(width >> level, 1u);
+      GLuint mipHeight = std::max(height >> level, 1u);
+      for (GLuint face = 0; face < numFaces; face++)
+      {
+        auto& image = outTexture.images[level * numFaces + face];
+        image.resize(mipWidth * mipHeight * 4 * sizeof(GLushort));
+
+        GLenum target = numFaces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+        glGetTexImage(target, level, GL_RGBA, GL_HALF_FLOAT, image.data());
+      }
+    }
+  }
+
+  // Upload the levels to the bound texture.
+  static void
+  uploadTexture(const HalfFloatTexture &texture)
+  {
+    for (GLuint level = 0; level < texture.numMips; level++)
+    {
+      GLuint mipWidth = std::max(texture.width >> level, 1u);
+      GLuint mipHeight = std::max(texture.height >> level, 1u);
+      for (GLuint face = 0; face < texture.numFaces; face++)
+      {
+        GLenum target = texture.numFaces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+        glTexImage2D(target, level, GL_RGBA16F, mipWidth, mipHeight, 0, GL_RGBA,
+                     GL_HALF_FLOAT, texture.images[level * texture.numFaces + face].data());
+      }
+    }
+  }
+
+  // KTX 1.1 files, each level is its image size followed by its faces. Faces
+  // of RGBA16F levels are always a multiple of 4 bytes, so there's no padding.
+  static bool
+  writeKTX(const std::string &filepath, const HalfFloatTexture &texture)
+  {
+    BlobWriter writer;
+    writer.writeBytes(ktxIdentifier, sizeof(ktxIdentifier));
+
+    // Endianness, type, type size, format, internal format, base internal
+    // format, size, depth, array elements, faces, levels and key/value bytes.
+    GLuint header[13] = { 0x04030201, GL_HALF_FLOAT, sizeof(GLushort), GL_RGBA, GL_RGBA16F,
+                          GL_RGBA, texture.width, texture.height, 0, 0, texture.numFaces,
+                          texture.numMips, 0 };
+    writer.writeBytes(header, sizeof(header));
+
+    for (GLuint level = 0; level < texture.numMips; level++)
+    {
+      writer.write<GLuint>(texture.images[level * texture.numFaces].size());
+      for (GLuint face = 0; face < texture.numFaces; face++)
+      {
+        auto& image = texture.images[level * texture.numFaces + face];
+        writer.writeBytes(image.data(), image.size());
+      }
+    }
+
+    return AssetCache::getInstance()->writeBlob(filepath, writer.bytes);
+  }
+
+  static bool
+  readKTX(const std::string &filepath, HalfFloatTexture &outTexture)
+  {
+    std::vector<unsigned char> blob;
+    if (filepath == "" || !AssetCache::getInstance()->readBlob(filepath, blob))
+      return false;
+
+    BlobReader reader(blob);
+    unsigned char identifier[12];
+    GLuint header[13];
+    if (!reader.readBytes(identifier, sizeof(identifier))
+        || memcmp(identifier, ktxIdentifier, sizeof(identifier)) != 0
+        || !reader.readBytes(header, sizeof(header)))
+      return false;
+
+    if (header[0] != 0x04030201 || header[1] != GL_HALF_FLOAT || header[4] != GL_RGBA16F
+        || (header[10] != 1 && header[10] != 6) || header[11] == 0 || header[12] != 0)
+      return false;
+
+    outTexture.width = header[6];
+    outTexture.height = header[7];
+    outTexture.numFaces = header[10];
+    outTexture.numMips = header[11];
+    outTexture.images.resize(outTexture.numMips * outTexture.numFaces);
+
+    for (GLuint level = 0; level < outTexture.numMips; level++)
+    {
+      GLuint mipWidth = std::max(outTexture.width >> level, 1u);
+      GLuint mipHeight = std::max(outTexture.height >> level, 1u);
+
+      GLuint imageSize;
+      if (!reader.read(imageSize) || imageSize != mipWidth * mipHeight * 4 * sizeof(GLushort))
+        return false;
+
+      for (GLuint face = 0; face < outTexture.numFaces; face++)
+      {
+        auto& image = outTexture.images[level * outTexture.numFaces + face];
+        image.resize(imageSize);
+        if (!reader.readBytes(image.data(), imageSize))
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Specular prefilter.
+  //----------------------------------------------------------------------------
+  GLuint
+  getNumPrefilterMips(GLuint width)
+  {
+    GLuint numMips = 1;
+    while ((width >> numMips) >= 8)
+      numMips++;
+
+    return numMips;
+  }
+
+  Unique<CubeMap>
+  createPrefilterMap(GLuint width, GLuint height, GLuint numMips)
+  {
+    auto prefilter = createUnique<CubeMap>();
+
+    for (unsigned i = 0; i < 6; i++)
+    {
+      for (GLuint level = 0; level < numMips; level++)
+      {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGBA16F,
+                     std::max(width >> level, 1u), std::max(height >> level, 1u),
+                     0, GL_RGBA, GL_FLOAT, nullptr);
+      }
+      prefilter->width[i]  = width;
+      prefilter->height[i] = height;
+      prefilter->n[i]      = 3;
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, numMips - 1);
+
+    return prefilter;
+  }
+
+  void
+  dispatchPrefilter(ComputeShader &filterShader, CubeMap* source, CubeMap* prefilter,
+                    GLuint numMips, GLuint sampleCount, bool filterSamples)
+  {
+    // A buffer with the parameters required for computing the prefilter.
+    struct
+    {
+      glm::vec2 enviSize;
+      glm::vec2 mipSize;
+      GLfloat roughness;
+      GLfloat resolution;
+      GLuint sampleCount;
+      GLuint filterSamples;
+    } params;
+    ShaderStorageBuffer paramBuff = ShaderStorageBuffer(sizeof(params),
+                                                        BufferType::Dynamic);
+
+    // Bind the cubemap which is to be prefiltered.
+    source->bind(0);
+
+    filterShader.bind();
+    for (GLuint i = 0; i < numMips; i++)
+    {
+      GLuint mipWidth  = std::max<GLuint>(prefilter->width[0] >> i, 1u);
+      GLuint mipHeight = std::max<GLuint>(prefilter->height[0] >> i, 1u);
+
+      float roughness = numMips > 1 ? ((float) i) / ((float) (numMips - 1)) : 0.0f;
+
+      // Bind the level for writing to by the compute shader.
+      glBindImageTexture(1, prefilter->getID(), i, GL_TRUE, 0,
+                         GL_WRITE_ONLY, GL_RGBA16F);
+
+      params.enviSize = glm::vec2((GLfloat) source->width[0],
+                                  (GLfloat) source->height[0]);
+      params.mipSize = glm::vec2((GLfloat) mipWidth, (GLfloat) mipHeight);
+      params.roughness = roughness;
+      params.resolution = source->width[0];
+      // The smoothest level is a copy of the source, every sample is the same.
+      params.sampleCount = i == 0 ? 1 : sampleCount;
+      params.filterSamples = filterSamples ? 1 : 0;
+      paramBuff.setData(0, sizeof(params), &params);
+      paramBuff.bindToPoint(2);
+
+      // Round up so the levels smaller than a work group are still filtered.
+      filterShader.launchCompute(glm::ivec3((mipWidth + 7) / 8, (mipHeight + 7) / 8, 6));
+    }
+  }
+
+  // Read the RGB channels of every level of the bound prefilter map back as
+  // floats.
+  static void
+  readBackPrefilter(GLuint width, GLuint height, GLuint numMips,
+                    std::vector<GLfloat> &outData)
+  {
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    outData.clear();
+    std::vector<GLfloat> image;
+    for (GLuint level = 0; level < numMips; level++)
+    {
+      GLuint mipWidth = std::max(width >> level, 1u);
+      GLuint mipHeight = std::max(height >> level, 1u);
+      image.resize(mipWidth * mipHeight * 3);
+      for (GLuint face = 0; face < 6; face++)
+      {
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB,
+                      GL_FLOAT, image.data());
+        outData.insert(outData.end(), image.begin(), image.end());
+      }
+    }
+  }
+
   EnvironmentMap::EnvironmentMap(const std::string &cubeMeshPath)
     : erMap(nullptr)
     , skybox(nullptr)
-    , irradiance(nullptr)
+    , irradianceSH(nullptr)
     , specPrefilter(nullptr)
     , brdfIntMap(nullptr)
     , currentEnvironment(MapType::Skybox)
@@ -47,9 +317,9 @@ namespace SciRenderer
     {
       this->skybox = Unique<CubeMap>(nullptr);
     }
-    if (this->irradiance != nullptr)
+    if (this->irradianceSH != nullptr)
     {
-      this->irradiance = Unique<CubeMap>(nullptr);
+      this->irradianceSH = Unique<UniformBuffer>(nullptr);
     }
     if (this->specPrefilter != nullptr)
     {
@@ -68,9 +338,9 @@ namespace SciRenderer
     {
       this->skybox = Unique<CubeMap>(nullptr);
     }
-    if (this->irradiance != nullptr)
+    if (this->irradianceSH != nullptr)
     {
-      this->irradiance = Unique<CubeMap>(nullptr);
+      this->irradianceSH = Unique<UniformBuffer>(nullptr);
     }
     if (this->specPrefilter != nullptr)
     {
@@ -96,10 +366,6 @@ namespace SciRenderer
         if (this->skybox != nullptr)
           this->skybox->bind();
         break;
-      case MapType::Irradiance:
-        if (this->irradiance != nullptr)
-          this->irradiance->bind();
-        break;
       case MapType::Prefilter:
         if (this->specPrefilter != nullptr)
           this->specPrefilter->bind();
@@ -130,10 +396,6 @@ namespace SciRenderer
         if (this->skybox != nullptr)
           this->skybox->bind(bindPoint);
         break;
-      case MapType::Irradiance:
-        if (this->irradiance != nullptr)
-          this->irradiance->bind(bindPoint);
-        break;
       case MapType::Prefilter:
         if (this->specPrefilter != nullptr)
           this->specPrefilter->bind(bindPoint);
@@ -145,6 +407,14 @@ namespace SciRenderer
     }
   }
 
+  // Binds the spherical harmonic irradiance coefficients to a uniform block.
+  void
+  EnvironmentMap::bindIrradiance(GLuint bindPoint)
+  {
+    if (this->irradianceSH != nullptr)
+      this->irradianceSH->bindToPoint(bindPoint);
+  }
+
   // Draw the skybox.
   void
   EnvironmentMap::configure(Shared<Camera> camera)
@@ -179,9 +449,6 @@ namespace SciRenderer
       case MapType::Skybox:
         if (this->skybox != nullptr)
           return this->skybox->getID();
-      case MapType::Irradiance:
-        if (this->irradiance != nullptr)
-          return this->irradiance->getID();
       case MapType::Prefilter:
         if (this->specPrefilter != nullptr)
           return this->specPrefilter->getID();
@@ -198,7 +465,11 @@ namespace SciRenderer
   EnvironmentMap::loadEquirectangularMap(const std::string &filepath,
                                          const Texture2DParams &params)
   {
-    this->erMap = Unique<Texture2D>(Texture2D::loadTexture2D(filepath, params, false));
+    // The skybox is converted from the full precision map, never a cooked one.
+    Texture2DParams erParams = params;
+    erParams.compression = TextureCompression::None;
+
+    this->erMap = Unique<Texture2D>(Texture2D::loadTexture2D(filepath, erParams, false));
     this->filepath = filepath;
   }
 
@@ -240,8 +511,31 @@ namespace SciRenderer
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+    // Skyboxes are cached without their mips, they're cheap to rebuild.
+    const std::string conversionPath = "./assets/shaders/compute/equiConversion.cs";
+    std::string cachedPath;
+    if (isHDR)
+    {
+      cachedPath = getPrecomputedPath(this->filepath, conversionPath, "Skybox:1:"
+                                      + std::to_string(width) + "x" + std::to_string(height));
+    }
+
+    HalfFloatTexture cached;
+    if (readKTX(cachedPath, cached) && cached.numFaces == 6 && cached.width == width
+        && cached.height == height)
+    {
+      cached.numMips = 1;
+      uploadTexture(cached);
+      glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      logs->logMessage(LogMessage("Loaded the cached skybox (elapsed time: "
+                                  + std::to_string(elapsed.count()) + " s).", true, true));
+      return;
+    }
+
     // The equirectangular to cubemap compute shader.
-    ComputeShader conversionShader = ComputeShader("./assets/shaders/compute/equiConversion.cs");
+    ComputeShader conversionShader = ComputeShader(conversionPath);
 
     // Buffer to pass the sizes of the image to the compute shader.
     struct
@@ -274,79 +568,136 @@ namespace SciRenderer
                                 + " s).", true, true));
     this->skybox->bind();
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+    if (cachedPath != "")
+    {
+      readBackTexture(width, height, 6, 1, cached);
+      writeKTX(cachedPath, cached);
+    }
   }
 
-  // Generate the diffuse irradiance map.
+  // Project the skybox onto the first nine spherical harmonics. Each work
+  // group of the compute shader reduces a tile of a cubemap face, the partial
+  // sums are read back and added up here.
   void
-  EnvironmentMap::precomputeIrradiance(const GLuint &width, const GLuint &height,
-                                       bool isHDR)
+  EnvironmentMap::precomputeIrradiance(bool isHDR)
   {
     Logger* logs = Logger::getInstance();
 
     auto start = std::chrono::steady_clock::now();
 
-    // The resulting cubemap from the convolution process.
-    this->irradiance = createUnique<CubeMap>();
+    // Nine coefficients can't hold any detail a coarse mip of the skybox
+    // doesn't have, so the projection reads at most 128x128 per face.
+    const GLuint skyboxWidth = this->skybox->width[0];
+    const GLuint faceSize = std::min<GLuint>(skyboxWidth, 128);
+    const GLuint mipLevel = (GLuint) std::log2(skyboxWidth / faceSize);
 
-    // Assign the texture sizes to the cubemap struct.
-    for (unsigned i = 0; i < 6; i++)
+    const std::string projectionPath = "./assets/shaders/compute/shProjection.cs";
+    std::string cachedPath;
+    if (isHDR)
     {
-      this->irradiance->width[i]  = width;
-      this->irradiance->height[i] = height;
-      this->irradiance->n[i]      = 3;
+      cachedPath = getPrecomputedPath(this->filepath, projectionPath, "IrradianceSH:1:"
+                                      + std::to_string(skyboxWidth), ".sh");
     }
 
-    for (unsigned i = 0; i < 6; i++)
+    glm::vec4 coefficients[9];
+    std::vector<unsigned char> blob;
+    if (cachedPath != "" && AssetCache::getInstance()->readBlob(cachedPath, blob)
+        && blob.size() == sizeof(coefficients))
     {
-      if (isHDR)
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA16F,
-                     width, height, 0, GL_RGBA,
-                     GL_FLOAT, nullptr);
-      else
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA,
-                     width, height, 0, GL_RGBA,
-                     GL_UNSIGNED_BYTE, nullptr);
-    }
+      memcpy(coefficients, blob.data(), sizeof(coefficients));
+      this->irradianceSH = createUnique<UniformBuffer>(coefficients, sizeof(coefficients),
+                                                       BufferType::Static);
 
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      logs->logMessage(LogMessage("Loaded the cached irradiance coefficients (elapsed time: "
+                                  + std::to_string(elapsed.count()) + " s).", true, true));
+      return;
+    }
 
-    // Convolution compute shader.
-    ComputeShader convolutionShader = ComputeShader("./assets/shaders/compute/diffuseConv.cs");
+    // Projection compute shader.
+    ComputeShader projectionShader = ComputeShader(projectionPath);
 
     // Buffer to pass the sizes of the image to the compute shader.
-    glm::vec2 dimensions = glm::vec2((GLfloat) width, (GLfloat) height);
+    glm::vec2 dimensions = glm::vec2((GLfloat) faceSize, (GLfloat) faceSize);
     ShaderStorageBuffer sizeBuff = ShaderStorageBuffer(&dimensions,
                                                        2 * sizeof(GLfloat),
                                                        BufferType::Static);
     sizeBuff.bindToPoint(2);
 
-    // Bind the skybox for reading by the compute shader.
-    glBindImageTexture(0, this->skybox->getID(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_RGBA16F);
+    // Nine partial sums per work group.
+    const GLuint groupsPerSide = std::max<GLuint>(faceSize / 8, 1);
+    const GLuint numGroups = groupsPerSide * groupsPerSide * 6;
+    ShaderStorageBuffer partialBuff = ShaderStorageBuffer(numGroups * 9 * sizeof(glm::vec4),
+                                                          BufferType::Dynamic);
+    partialBuff.bindToPoint(3);
 
-    // Bind the irradiance map for writing to by the compute shader.
-    glBindImageTexture(1, this->irradiance->getID(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    // Bind the skybox for reading by the compute shader.
+    glBindImageTexture(0, this->skybox->getID(), mipLevel, GL_TRUE, 0, GL_READ_ONLY, GL_RGBA16F);
 
     // Launch the compute shader.
-    convolutionShader.bind();
-    convolutionShader.launchCompute(glm::ivec3(width / 32, height / 32, 6));
+    projectionShader.bind();
+    projectionShader.launchCompute(glm::ivec3(groupsPerSide, groupsPerSide, 6));
+
+    std::vector<glm::vec4> partials(numGroups * 9);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    partialBuff.getData(0, partials.size() * sizeof(glm::vec4), partials.data());
+
+    // Sum in double precision, there are a few thousand partials.
+    double sums[9][3] = { };
+    double totalWeight = 0.0;
+    for (GLuint group = 0; group < numGroups; group++)
+    {
+      for (GLuint i = 0; i < 9; i++)
+      {
+        const glm::vec4 &partial = partials[9 * group + i];
+        sums[i][0] += partial.r;
+        sums[i][1] += partial.g;
+        sums[i][2] += partial.b;
+      }
+      totalWeight += partials[9 * group].a;
+    }
+
+    // The texel solid angles are approximate, rescale so they cover the
+    // sphere exactly. Then convolve with the clamped cosine lobe (A_l / pi)
+    // and fold in the basis constants, so the shaders only have to evaluate
+    // a polynomial in the normal.
+    const double bandScale[9] = { 1.0, 2.0 / 3.0, 2.0 / 3.0, 2.0 / 3.0, 0.25,
+                                  0.25, 0.25, 0.25, 0.25 };
+    const double basisScale[9] = { 0.282095, 0.488603, 0.488603, 0.488603, 1.092548,
+                                   1.092548, 0.315392, 1.092548, 0.546274 };
+    const double normalization = totalWeight > 0.0 ? 4.0 * M_PI / totalWeight : 0.0;
+    for (GLuint i = 0; i < 9; i++)
+    {
+      double scale = normalization * bandScale[i] * basisScale[i];
+      coefficients[i] = glm::vec4((GLfloat) (sums[i][0] * scale),
+                                  (GLfloat) (sums[i][1] * scale),
+                                  (GLfloat) (sums[i][2] * scale), 0.0f);
+    }
+
+    this->irradianceSH = createUnique<UniformBuffer>(coefficients, sizeof(coefficients),
+                                                     BufferType::Static);
 
     auto end = std::chrono::steady_clock::now();
     std::chrono::duration<double> elapsed = end - start;
 
-    logs->logMessage(LogMessage("Convoluted environment map (elapsed time: "
-                                + std::to_string(elapsed.count()) + " s).", true,
-                                true));
+    logs->logMessage(LogMessage("Projected the environment map onto spherical harmonics"
+                                " (elapsed time: " + std::to_string(elapsed.count())
+                                + " s).", true, true));
+
+    if (cachedPath != "")
+    {
+      auto first = reinterpret_cast<const unsigned char*>(coefficients);
+      AssetCache::getInstance()->writeBlob(cachedPath, std::vector<unsigned char>(first,
+                                           first + sizeof(coefficients)));
+    }
   }
 
   // Generate the specular map components. Computes the pre-filtered environment
   // map first, than integrates the BRDF and stores the result in an LUT.
   void
   EnvironmentMap::precomputeSpecular(const GLuint &width, const GLuint &height,
-                                     bool isHDR)
+                                     bool isHDR, GLuint sampleCount)
   {
     Logger* logs = Logger::getInstance();
 
@@ -358,75 +709,54 @@ namespace SciRenderer
       auto start = std::chrono::steady_clock::now();
 
       // The resulting cubemap from the environment pre-filter.
-      this->specPrefilter = createUnique<CubeMap>();
+      const GLuint numMips = getNumPrefilterMips(width);
+      this->specPrefilter = createPrefilterMap(width, height, numMips);
 
-      for (unsigned i = 0; i < 6; i++)
+      const std::string filterPath = "./assets/shaders/compute/specPrefilter.cs";
+      std::string cachedPath;
+      if (isHDR)
       {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA16F,
-                     width, height, 0, GL_RGBA,
-                     GL_FLOAT, nullptr);
-        this->specPrefilter->width[i]  = width;
-        this->specPrefilter->height[i] = height;
-        this->specPrefilter->n[i]      = 3;
+        cachedPath = getPrecomputedPath(this->filepath, filterPath, "Prefilter:2:"
+          + std::to_string(this->skybox->width[0]) + ":" + std::to_string(width) + "x"
+          + std::to_string(height) + ":" + std::to_string(sampleCount));
       }
 
-      glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-      glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-      glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-      glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-      glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-      glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-      // The specular prefilter compute shader.
-      ComputeShader filterShader = ComputeShader("./assets/shaders/compute/specPrefilter.cs");
-
-      // A buffer with the parameters required for computing the prefilter.
-      struct
+      HalfFloatTexture cached;
+      bool isCached = readKTX(cachedPath, cached) && cached.numFaces == 6
+                   && cached.width == width && cached.height == height
+                   && cached.numMips == numMips;
+      if (isCached)
       {
-        glm::vec2 enviSize;
-        glm::vec2 mipSize;
-        GLfloat roughness;
-        GLfloat resolution;
-      } params;
-      ShaderStorageBuffer paramBuff = ShaderStorageBuffer(sizeof(params),
-                                                          BufferType::Static);
-
-      // Bind the enviroment map which is to be prefiltered.
-      this->skybox->bind(0);
-
-      // Perform the pre-filter for each roughness level.
-      for (GLuint i = 0; i < 5; i++)
+        uploadTexture(cached);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        logs->logMessage(LogMessage("Loaded the cached pre-filtered environment map"
+                                    " (elapsed time: " + std::to_string(elapsed.count())
+                                    + " s).", true, true));
+      }
+      else
       {
-        // Compute the current mip levels.
-        GLuint mipWidth  = (GLuint) ((GLfloat) width * std::pow(0.5f, i));
-        GLuint mipHeight = (GLuint) ((GLfloat) height * std::pow(0.5f, i));
-
-        float roughness = ((float) i) / ((float) (5 - 1));
-
-        // Bind the irradiance map for writing to by the compute shader.
-        glBindImageTexture(1, this->specPrefilter->getID(), i, GL_TRUE, 0,
-                           GL_WRITE_ONLY, GL_RGBA16F);
-
-        params.enviSize = glm::vec2((GLfloat) this->skybox->width[0],
-                                    (GLfloat) this->skybox->height[0]);
-        params.mipSize = glm::vec2((GLfloat) mipWidth, (GLfloat) mipHeight);
-        params.roughness = roughness;
-        params.resolution = this->skybox->width[0];
-        paramBuff.setData(0, sizeof(params), &params);
-        paramBuff.bindToPoint(2);
-
-        // Launch the compute.
-        filterShader.bind();
-        filterShader.launchCompute(glm::ivec3(mipWidth / 32, mipHeight / 32, 6));
+        // The specular prefilter compute shader.
+        ComputeShader filterShader = ComputeShader(filterPath);
+        dispatchPrefilter(filterShader, this->skybox.get(), this->specPrefilter.get(),
+                          numMips, sampleCount, true);
+
+        auto end = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed = end - start;
+
+        logs->logMessage(LogMessage("Pre-filtered environment map with "
+                                    + std::to_string(sampleCount) + " samples over "
+                                    + std::to_string(numMips) + " mips (elapsed time: "
+                                    + std::to_string(elapsed.count()) + " s).", true,
+                                    true));
+
+        if (cachedPath != "")
+        {
+          this->specPrefilter->bind();
+          readBackTexture(width, height, 6, numMips, cached);
+          writeKTX(cachedPath, cached);
+        }
       }
-
-      auto end = std::chrono::steady_clock::now();
-      std::chrono::duration<double> elapsed = end - start;
-
-      logs->logMessage(LogMessage("Pre-filtered environment map (elapsed time: "
-                                  + std::to_string(elapsed.count()) + " s).", true,
-                                  true));
     }
 
     if (this->brdfIntMap == nullptr)
@@ -448,7 +778,25 @@ namespace SciRenderer
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-      ComputeShader integrateBRDF = ComputeShader("./assets/shaders/compute/integrateBRDF.cs");
+      // The LUT is the same for every environment, so it's keyed by its shader.
+      const std::string integrationPath = "./assets/shaders/compute/integrateBRDF.cs";
+      std::string cachedPath = getPrecomputedPath(integrationPath, integrationPath,
+                                                  "Integration:1:512x512");
+
+      HalfFloatTexture cached;
+      if (readKTX(cachedPath, cached) && cached.numFaces == 1 && cached.width == 512
+          && cached.height == 512)
+      {
+        cached.numMips = 1;
+        uploadTexture(cached);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        logs->logMessage(LogMessage("Loaded the cached BRDF lookup texture (elapsed time: "
+                                    + std::to_string(elapsed.count()) + " s).", true, true));
+        return;
+      }
+
+      ComputeShader integrateBRDF = ComputeShader(integrationPath);
 
       // Bind the integration map for writing to by the compute shader.
       glBindImageTexture(3, this->brdfIntMap->getID(), 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA16F);
@@ -463,6 +811,79 @@ namespace SciRenderer
       logs->logMessage(LogMessage("Generated BRDF lookup texture (elapsed time: "
                                   + std::to_string(elapsed.count()) + " s).", true,
                                   true));
+
+      if (cachedPath != "")
+      {
+        this->brdfIntMap->bind();
+        readBackTexture(512, 512, 1, 1, cached);
+        writeKTX(cachedPath, cached);
+      }
+    }
+  }
+
+  // Time each prefilter quality tier and compare it against a brute force
+  // reference, which reads every sample from the base level of the skybox.
+  void
+  EnvironmentMap::benchmarkPrefilter(const GLuint &width)
+  {
+    Logger* logs = Logger::getInstance();
+
+    if (this->skybox == nullptr)
+      return;
+
+    const GLuint referenceSamples = 4096;
+    const GLuint numMips = getNumPrefilterMips(width);
+    ComputeShader filterShader = ComputeShader("./assets/shaders/compute/specPrefilter.cs");
+
+    auto reference = createPrefilterMap(width, width, numMips);
+    dispatchPrefilter(filterShader, this->skybox.get(), reference.get(), numMips,
+                      referenceSamples, false);
+    std::vector<GLfloat> referenceData;
+    reference->bind();
+    readBackPrefilter(width, width, numMips, referenceData);
+
+    // The base level is a copy of the skybox in every tier, leave it out.
+    const size_t baseSize = width * width * 3 * 6;
+
+    struct
+    {
+      const char* name;
+      PrefilterQuality quality;
+    } tiers[] = { { "Fast", PrefilterQuality::Fast },
+                  { "Medium", PrefilterQuality::Medium },
+                  { "High", PrefilterQuality::High } };
+
+    std::vector<GLfloat> filteredData;
+    for (auto& tier : tiers)
+    {
+      GLuint sampleCount = static_cast<GLuint>(tier.quality);
+      auto filtered = createPrefilterMap(width, width, numMips);
+
+      glFinish();
+      auto start = std::chrono::steady_clock::now();
+      dispatchPrefilter(filterShader, this->skybox.get(), filtered.get(), numMips,
+                        sampleCount, true);
+      glFinish();
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      filtered->bind();
+      readBackPrefilter(width, width, numMips, filteredData);
+
+      double squaredError = 0.0;
+      for (size_t i = baseSize; i < filteredData.size(); i++)
+      {
+        double difference = filteredData[i] - referenceData[i];
+        squaredError += difference * difference;
+      }
+      size_t numValues = filteredData.size() - baseSize;
+      double rmse = numValues > 0 ? std::sqrt(squaredError / numValues) : 0.0;
+
+      logs->logMessage(LogMessage("Prefilter tier " + std::string(tier.name) + " ("
+                                  + std::to_string(sampleCount) + " samples): "
+                                  + std::to_string(elapsed.count() * 1000.0)
+                                  + " ms, RMSE " + std::to_string(rmse) + " against "
+                                  + std::to_string(referenceSamples)
+                                  + " unfiltered samples.", true, true));
     }
   }
 }
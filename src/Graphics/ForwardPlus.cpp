@@ -0,0 +1,213 @@
+#include "Graphics/ForwardPlus.h"
+
+namespace SciRenderer
+{
+  // Parameters for the light culling.
+  struct TileCullParams
+  {
+    glm::mat4 view;
+    glm::mat4 invProj;
+    glm::uvec2 renderSize;
+    glm::uvec2 numTiles;
+    GLuint numLights;
+    GLuint numSamples;
+    GLuint padding[2];
+  };
+
+  // Parameters for the ID resolve, shares the parameter buffer.
+  struct IDResolveParams
+  {
+    glm::uvec2 renderSize;
+    GLuint padding[2];
+  };
+
+  ForwardPlus::ForwardPlus(GLuint width, GLuint height, GLuint samples)
+    : width(width)
+    , height(height)
+    , samples(std::max(samples, 1u))
+    , targetFBO(0)
+    , colourTarget(0)
+    , idTarget(0)
+    , depthTarget(0)
+    , lightCapacity(0)
+    , cullShader("./assets/shaders/compute/lightCulling.cs")
+    , idResolveShader("./assets/shaders/compute/resolveIDs.cs")
+    , paramBuffer(sizeof(TileCullParams), BufferType::Dynamic)
+  {
+    this->createTargets();
+  }
+
+  ForwardPlus::~ForwardPlus()
+  {
+    this->deleteTargets();
+  }
+
+  void
+  ForwardPlus::createTargets()
+  {
+    // A single sample is still a multisampled texture, so the shaders and
+    // resolve don't change.
+    auto createTarget = [this](GLuint &texture, GLenum format)
+    {
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture);
+      glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, this->samples, format,
+                                this->width, this->height, GL_TRUE);
+      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+    };
+    createTarget(this->colourTarget, GL_RGBA16F);
+    createTarget(this->idTarget, GL_RGBA16F);
+    createTarget(this->depthTarget, GL_DEPTH_COMPONENT32F);
+
+    glGenFramebuffers(1, &this->targetFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->targetFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D_MULTISAMPLE, this->colourTarget, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
+                           GL_TEXTURE_2D_MULTISAMPLE, this->idTarget, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                           GL_TEXTURE_2D_MULTISAMPLE, this->depthTarget, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Every tile has room for its count and the maximum number of lights.
+    glm::uvec2 numTiles = this->getNumTiles(glm::uvec2(this->width, this->height));
+    this->tileBuffer = createUnique<ShaderStorageBuffer>(numTiles.x * numTiles.y
+                                                         * (MAX_LIGHTS_PER_TILE + 1)
+                                                         * sizeof(GLuint),
+                                                         BufferType::Dynamic);
+  }
+
+  void
+  ForwardPlus::deleteTargets()
+  {
+    glDeleteFramebuffers(1, &this->targetFBO);
+    glDeleteTextures(1, &this->colourTarget);
+    glDeleteTextures(1, &this->idTarget);
+    glDeleteTextures(1, &this->depthTarget);
+  }
+
+  void
+  ForwardPlus::resize(GLuint width, GLuint height, GLuint samples)
+  {
+    samples = std::max(samples, 1u);
+    if (this->width == width && this->height == height && this->samples == samples)
+      return;
+
+    this->width = width;
+    this->height = height;
+    this->samples = samples;
+
+    this->deleteTargets();
+    this->createTargets();
+  }
+
+  glm::uvec2
+  ForwardPlus::getNumTiles(const glm::uvec2 &renderSize)
+  {
+    return (renderSize + glm::uvec2(FORWARD_TILE_SIZE - 1)) / glm::uvec2(FORWARD_TILE_SIZE);
+  }
+
+  void
+  ForwardPlus::begin(const glm::uvec2 &renderSize)
+  {
+    GLfloat colourClear[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    GLfloat idClear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    GLfloat depthClear = 1.0f;
+    glClearNamedFramebufferfv(this->targetFBO, GL_COLOR, 0, colourClear);
+    glClearNamedFramebufferfv(this->targetFBO, GL_COLOR, 1, idClear);
+    glClearNamedFramebufferfv(this->targetFBO, GL_DEPTH, 0, &depthClear);
+
+    GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glNamedFramebufferDrawBuffers(this->targetFBO, 2, drawBuffers);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, this->targetFBO);
+    glViewport(0, 0, renderSize.x, renderSize.y);
+  }
+
+  void
+  ForwardPlus::colourOnly()
+  {
+    glNamedFramebufferDrawBuffer(this->targetFBO, GL_COLOR_ATTACHMENT0);
+  }
+
+  void
+  ForwardPlus::end()
+  {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+
+  void
+  ForwardPlus::cullLights(Shared<Camera> camera, const std::vector<TiledLight> &lights,
+                          const glm::uvec2 &renderSize)
+  {
+    this->timer.begin();
+
+    // Grow the light buffer as needed, it always holds at least one light.
+    GLuint numLights = lights.size();
+    if (numLights > this->lightCapacity || !this->lightBuffer)
+    {
+      this->lightCapacity = std::max(std::max(numLights, 2 * this->lightCapacity), 1u);
+      this->lightBuffer = createUnique<ShaderStorageBuffer>(this->lightCapacity * sizeof(TiledLight),
+                                                            BufferType::Dynamic);
+    }
+    if (numLights > 0)
+      this->lightBuffer->setData(0, numLights * sizeof(TiledLight), lights.data());
+
+    glm::uvec2 numTiles = this->getNumTiles(renderSize);
+
+    TileCullParams params;
+    params.view = camera->getViewMatrix();
+    params.invProj = glm::inverse(camera->getProjMatrix());
+    params.renderSize = renderSize;
+    params.numTiles = numTiles;
+    params.numLights = numLights;
+    params.numSamples = this->samples;
+    this->paramBuffer.setData(0, sizeof(TileCullParams), &params);
+
+    this->paramBuffer.bindToPoint(2);
+    this->bindLights();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, this->depthTarget);
+
+    this->cullShader.launchCompute(glm::ivec3(numTiles.x, numTiles.y, 1));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    this->timer.end();
+  }
+
+  void
+  ForwardPlus::bindLights()
+  {
+    this->lightBuffer->bindToPoint(5);
+    this->tileBuffer->bindToPoint(6);
+  }
+
+  void
+  ForwardPlus::resolve(FrameBuffer &sceneColour, GeometryBuffer &gBuffer,
+                       const glm::uvec2 &renderSize)
+  {
+    glNamedFramebufferReadBuffer(this->targetFBO, GL_COLOR_ATTACHMENT0);
+    glBlitNamedFramebuffer(this->targetFBO, sceneColour.getID(), 0, 0,
+                           renderSize.x, renderSize.y, 0, 0, renderSize.x,
+                           renderSize.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    // The IDs and depth are read by the editor passes after the tone mapping.
+    IDResolveParams params;
+    params.renderSize = renderSize;
+    this->paramBuffer.setData(0, sizeof(IDResolveParams), &params);
+    this->paramBuffer.bindToPoint(2);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, this->idTarget);
+    glBindImageTexture(0, gBuffer.getAttachmentID(FBOTargetParam::Colour4), 0, GL_FALSE, 0,
+                       GL_WRITE_ONLY, GL_RGBA16F);
+
+    glm::uvec2 numGroups = (renderSize + glm::uvec2(7)) / glm::uvec2(8);
+    this->idResolveShader.launchCompute(glm::ivec3(numGroups.x, numGroups.y, 1));
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+                    | GL_FRAMEBUFFER_BARRIER_BIT);
+
+    gBuffer.blitzFromOther(this->targetFBO, GL_NONE, FBOTargetParam::Depth, renderSize);
+  }
+}
@@ -199,12 +199,19 @@ namespace SciRenderer
   FrameBuffer::setDrawBuffers()
   {
     this->bind();
+    // Fragment output location i is written to colour attachment i, missing
+    // attachments are skipped with GL_NONE.
     std::vector<GLenum> totalAttachments;
     for (auto& pair : this->textureAttachments)
     {
-      if (pair.first != FBOTargetParam::Depth && pair.first != FBOTargetParam::Stencil
-          && pair.first != FBOTargetParam::DepthStencil)
-        totalAttachments.push_back(static_cast<GLenum>(pair.first));
+      if (pair.first == FBOTargetParam::Depth || pair.first == FBOTargetParam::Stencil
+          || pair.first == FBOTargetParam::DepthStencil)
+        continue;
+
+      GLuint location = static_cast<GLenum>(pair.first) - GL_COLOR_ATTACHMENT0;
+      if (location >= totalAttachments.size())
+        totalAttachments.resize(location + 1, GL_NONE);
+      totalAttachments[location] = static_cast<GLenum>(pair.first);
     }
     if (totalAttachments.size() >= 1)
       glDrawBuffers(totalAttachments.size(), totalAttachments.data());
@@ -0,0 +1,46 @@
+#include "Graphics/GPUTimer.h"
+
+namespace SciRenderer
+{
+  GPUTimer::GPUTimer()
+    : current(0)
+    , lastTime(0.0f)
+  {
+    glGenQueries(NUM_TIMER_QUERIES, this->startQueries);
+    glGenQueries(NUM_TIMER_QUERIES, this->endQueries);
+    for (unsigned i = 0; i < NUM_TIMER_QUERIES; i++)
+      this->pending[i] = false;
+  }
+
+  GPUTimer::~GPUTimer()
+  {
+    glDeleteQueries(NUM_TIMER_QUERIES, this->startQueries);
+    glDeleteQueries(NUM_TIMER_QUERIES, this->endQueries);
+  }
+
+  void
+  GPUTimer::begin()
+  {
+    // The query was issued NUM_TIMER_QUERIES frames ago, so it's almost
+    // always done by the time it's reused.
+    if (this->pending[this->current])
+    {
+      GLuint64 start = 0;
+      GLuint64 end = 0;
+      glGetQueryObjectui64v(this->startQueries[this->current], GL_QUERY_RESULT, &start);
+      glGetQueryObjectui64v(this->endQueries[this->current], GL_QUERY_RESULT, &end);
+      this->lastTime = (GLfloat) (end - start) / 1e6f;
+      this->pending[this->current] = false;
+    }
+
+    glQueryCounter(this->startQueries[this->current], GL_TIMESTAMP);
+  }
+
+  void
+  GPUTimer::end()
+  {
+    glQueryCounter(this->endQueries[this->current], GL_TIMESTAMP);
+    this->pending[this->current] = true;
+    this->current = (this->current + 1) % NUM_TIMER_QUERIES;
+  }
+}
@@ -26,6 +26,11 @@ namespace SciRenderer
     cSpec.sWrap = TextureWrapParams::ClampEdges;
     cSpec.tWrap = TextureWrapParams::ClampEdges;
     this->geoBuffer.attachTexture2D(cSpec);
+    // The screen space velocity texture.
+    cSpec = FBOCommands::getFloatColourSpec(FBOTargetParam::Colour5);
+    cSpec.sWrap = TextureWrapParams::ClampEdges;
+    cSpec.tWrap = TextureWrapParams::ClampEdges;
+    this->geoBuffer.attachTexture2D(cSpec);
     this->geoBuffer.setDrawBuffers();
 
     this->geoBuffer.attachTexture2D(dSpec);
@@ -61,6 +66,11 @@ namespace SciRenderer
         cSpec.sWrap = TextureWrapParams::ClampEdges;
         cSpec.tWrap = TextureWrapParams::ClampEdges;
         this->geoBuffer.attachTexture2D(cSpec);
+        // The screen space velocity texture.
+        cSpec = FBOCommands::getFloatColourSpec(FBOTargetParam::Colour5);
+        cSpec.sWrap = TextureWrapParams::ClampEdges;
+        cSpec.tWrap = TextureWrapParams::ClampEdges;
+        this->geoBuffer.attachTexture2D(cSpec);
         this->geoBuffer.setDrawBuffers();
         break;
       }
@@ -77,6 +87,11 @@ namespace SciRenderer
         // The lighting materials texture.
         cSpec = FBOCommands::getFloatColourSpec(FBOTargetParam::Colour3);
         this->geoBuffer.attachTexture2D(cSpec);
+        // The screen space velocity texture.
+        cSpec = FBOCommands::getFloatColourSpec(FBOTargetParam::Colour5);
+        cSpec.sWrap = TextureWrapParams::ClampEdges;
+        cSpec.tWrap = TextureWrapParams::ClampEdges;
+        this->geoBuffer.attachTexture2D(cSpec);
         this->geoBuffer.setDrawBuffers();
         break;
       }
@@ -130,6 +145,11 @@ namespace SciRenderer
         cSpec.sWrap = TextureWrapParams::ClampEdges;
         cSpec.tWrap = TextureWrapParams::ClampEdges;
         this->geoBuffer.attachTexture2D(cSpec);
+        // The screen space velocity texture.
+        cSpec = FBOCommands::getFloatColourSpec(FBOTargetParam::Colour5);
+        cSpec.sWrap = TextureWrapParams::ClampEdges;
+        cSpec.tWrap = TextureWrapParams::ClampEdges;
+        this->geoBuffer.attachTexture2D(cSpec);
         this->geoBuffer.setDrawBuffers();
         break;
       }
@@ -146,6 +166,11 @@ namespace SciRenderer
         // The lighting materials texture.
         cSpec = FBOCommands::getFloatColourSpec(FBOTargetParam::Colour3);
         this->geoBuffer.attachTexture2D(cSpec);
+        // The screen space velocity texture.
+        cSpec = FBOCommands::getFloatColourSpec(FBOTargetParam::Colour5);
+        cSpec.sWrap = TextureWrapParams::ClampEdges;
+        cSpec.tWrap = TextureWrapParams::ClampEdges;
+        this->geoBuffer.attachTexture2D(cSpec);
         this->geoBuffer.setDrawBuffers();
         break;
       }
@@ -168,6 +193,26 @@ namespace SciRenderer
     this->geoBuffer.blitzToOther(target, type);
   }
 
+  void
+  GeometryBuffer::blitzFromOther(GLuint sourceID, GLenum sourceAttachment,
+                                 const FBOTargetParam &target, const glm::uvec2 &size)
+  {
+    GLuint targetID = this->geoBuffer.getID();
+    if (target == FBOTargetParam::Depth)
+    {
+      glBlitNamedFramebuffer(sourceID, targetID, 0, 0, size.x, size.y, 0, 0,
+                             size.x, size.y, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+      return;
+    }
+
+    // Only write the one attachment, then restore the draw buffers.
+    glNamedFramebufferReadBuffer(sourceID, sourceAttachment);
+    glNamedFramebufferDrawBuffer(targetID, static_cast<GLenum>(target));
+    glBlitNamedFramebuffer(sourceID, targetID, 0, 0, size.x, size.y, 0, 0,
+                           size.x, size.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    this->geoBuffer.setDrawBuffers();
+  }
+
   void
   GeometryBuffer::bindAttachment(const FBOTargetParam &attachment, GLuint bindPoint)
   {
@@ -1,5 +1,8 @@
 #include "Graphics/GraphicsContext.h"
 
+// Project includes.
+#include "Graphics/Shaders.h"
+
 namespace SciRenderer
 {
   // Generic constructor / destructor pair.
@@ -56,6 +59,9 @@ namespace SciRenderer
                 << "core 4.4 or greater." << std::endl;
       exit(EXIT_FAILURE);
     }
+
+    // Let the driver compile shaders on its own threads.
+    Shader::initParallelCompile();
   }
 
   void
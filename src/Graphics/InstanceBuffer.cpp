@@ -0,0 +1,152 @@
+#include "Graphics/InstanceBuffer.h"
+
+namespace SciRenderer
+{
+  // Slots the buffer starts out with, it doubles when it runs out.
+  static const GLuint initialCapacity = 256;
+
+  InstanceBuffer::InstanceBuffer()
+    : cameraDirty(true)
+    , frame(0)
+    , capacity(initialCapacity)
+    , numUploaded(0)
+  {
+    this->camera = { glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f) };
+    this->buffer = createUnique<ShaderStorageBuffer>(sizeof(GPUCamera) + this->capacity * sizeof(GPUInstance),
+                                                     BufferType::Dynamic);
+  }
+
+  InstanceBuffer::~InstanceBuffer()
+  { }
+
+  void
+  InstanceBuffer::setCamera(const glm::mat4 &viewProj, const glm::mat4 &unjitteredViewProj,
+                            const glm::mat4 &prevViewProj)
+  {
+    GPUCamera newCamera = { viewProj, unjitteredViewProj, prevViewProj };
+    if (memcmp(&newCamera, &this->camera, sizeof(GPUCamera)) == 0)
+      return;
+
+    this->camera = newCamera;
+    this->cameraDirty = true;
+  }
+
+  GLuint
+  InstanceBuffer::update(GLuint id, Mesh* submesh, const glm::mat4 &transform,
+                         bool drawSelectionMask)
+  {
+    glm::uvec4 info = glm::uvec4(id + 1, drawSelectionMask ? 1 : 0, 0, 0);
+
+    auto key = std::make_pair(id, submesh);
+    auto slot = this->slots.find(key);
+    if (slot == this->slots.end())
+    {
+      GLuint index;
+      if (this->freeSlots.empty())
+      {
+        index = this->instances.size();
+        this->instances.emplace_back();
+      }
+      else
+      {
+        index = this->freeSlots.back();
+        this->freeSlots.pop_back();
+      }
+      this->slots[key] = { index, this->frame };
+
+      // New instances have no motion.
+      this->instances[index] = { transform, transform,
+                                 glm::mat4(glm::transpose(glm::inverse(glm::mat3(transform)))),
+                                 info };
+      this->dirtySlots.push_back(index);
+      return index;
+    }
+
+    // The same submesh can be gathered more than once a frame.
+    if (slot->second.lastFrame == this->frame)
+      return slot->second.index;
+    slot->second.lastFrame = this->frame;
+
+    // Static instances are uploaded once more after they stop moving, so
+    // their previous transform catches up.
+    GPUInstance &instance = this->instances[slot->second.index];
+    bool moved = instance.model != transform;
+    if (!moved && instance.prevModel == instance.model && instance.info == info)
+      return slot->second.index;
+
+    instance.prevModel = instance.model;
+    if (moved)
+    {
+      instance.model = transform;
+      instance.normalMat = glm::mat4(glm::transpose(glm::inverse(glm::mat3(transform))));
+    }
+    instance.info = info;
+    this->dirtySlots.push_back(slot->second.index);
+
+    return slot->second.index;
+  }
+
+  void
+  InstanceBuffer::flush()
+  {
+    // Free the slots of the submeshes which weren't drawn this frame.
+    for (auto it = this->slots.begin(); it != this->slots.end();)
+    {
+      if (it->second.lastFrame != this->frame)
+      {
+        this->freeSlots.push_back(it->second.index);
+        it = this->slots.erase(it);
+      }
+      else
+        it++;
+    }
+
+    this->numUploaded = 0;
+    GLuint numInstances = this->instances.size();
+    if (numInstances > this->capacity)
+    {
+      // Grow the buffer and refill it from the CPU copies.
+      this->capacity = std::max(numInstances, 2 * this->capacity);
+      this->buffer = createUnique<ShaderStorageBuffer>(sizeof(GPUCamera) + this->capacity * sizeof(GPUInstance),
+                                                       BufferType::Dynamic);
+      this->buffer->setData(sizeof(GPUCamera), numInstances * sizeof(GPUInstance),
+                            this->instances.data());
+      this->numUploaded = numInstances;
+      this->dirtySlots.clear();
+      this->cameraDirty = true;
+    }
+
+    // Upload runs of consecutive dirty slots together.
+    std::sort(this->dirtySlots.begin(), this->dirtySlots.end());
+    this->dirtySlots.erase(std::unique(this->dirtySlots.begin(), this->dirtySlots.end()),
+                           this->dirtySlots.end());
+    GLuint i = 0;
+    while (i < this->dirtySlots.size())
+    {
+      GLuint first = this->dirtySlots[i];
+      GLuint count = 1;
+      while (i + count < this->dirtySlots.size() && this->dirtySlots[i + count] == first + count)
+        count++;
+
+      this->buffer->setData(sizeof(GPUCamera) + first * sizeof(GPUInstance),
+                            count * sizeof(GPUInstance), &this->instances[first]);
+      this->numUploaded += count;
+      i += count;
+    }
+    this->dirtySlots.clear();
+
+    if (this->cameraDirty)
+    {
+      this->buffer->setData(0, sizeof(GPUCamera), &this->camera);
+      this->cameraDirty = false;
+    }
+
+    this->frame++;
+  }
+
+  void
+  InstanceBuffer::bind()
+  {
+    this->buffer->bindToPoint(1);
+  }
+}
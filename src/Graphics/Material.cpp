@@ -5,8 +5,48 @@
 
 namespace SciRenderer
 {
+  // Maps which can be left out of a shader permutation, and the defines which
+  // leave them out. The bit of a map in the missing map mask is its index.
+  static const std::pair<const char*, const char*> optionalMaps[] =
+  {
+    { "albedoMap", "NO_ALBEDO_MAP" },
+    { "normalMap", "NO_NORMAL_MAP" },
+    { "metallicMap", "NO_METALLIC_MAP" },
+    { "roughnessMap", "NO_ROUGHNESS_MAP" },
+    { "aOcclusionMap", "NO_AO_MAP" }
+  };
+
+  static GLint
+  getOptionalMapIndex(const std::string &samplerName)
+  {
+    for (GLuint i = 0; i < std::size(optionalMaps); i++)
+      if (samplerName == optionalMaps[i].first)
+        return i;
+    return -1;
+  }
+
+  // The placeholders attached to new materials. They sample to the neutral
+  // value of the map, so leaving them out doesn't change the result.
+  static bool
+  isPlaceholder(const std::string &samplerName, const SciRenderer::AssetHandle &handle)
+  {
+    static std::string white = "";
+    static std::string flatNormal = "";
+    if (white == "")
+    {
+      Texture2D::createMonoColour(glm::vec4(1.0f), white);
+      Texture2D::createMonoColour(glm::vec4(0.5f, 0.5f, 1.0f, 1.0f), flatNormal);
+    }
+
+    return handle == (samplerName == "normalMap" ? flatNormal : white);
+  }
+
   Material::Material(MaterialType type)
     : type(type)
+    , transparent(false)
+    , variantBase(nullptr)
+    , variant(nullptr)
+    , variantMaps(0)
   {
     auto shaderCache = AssetManager<Shader>::getManager();
     switch (type)
@@ -30,6 +70,7 @@ namespace SciRenderer
         this->getFloat("uMetallic") = 0.0f;
         this->getFloat("uRoughness") = 0.5f;
         this->getFloat("uAO") = 1.0f;
+        this->getFloat("uOpacity") = 1.0f;
         break;
       }
       case MaterialType::Specular:
@@ -86,8 +127,8 @@ namespace SciRenderer
     {
       case MaterialType::PBR:
       {
-        // Bind the PBR maps first.
-        this->program->addUniformSampler("irradianceMap", 0);
+        // Bind the PBR maps first. Unit 0 is left unused, the diffuse
+        // irradiance is a uniform block now.
       	this->program->addUniformSampler("reflectanceMap", 1);
       	this->program->addUniformSampler("brdfLookUp", 2);
 
@@ -134,6 +175,49 @@ namespace SciRenderer
 
   void
   Material::configure(Shader* overrideProgram)
+  {
+    this->uploadUniforms(overrideProgram, 0);
+  }
+
+  Shader*
+  Material::configureVariant(Shader* baseProgram)
+  {
+    GLuint missingMaps = this->getMissingMaps();
+    if (baseProgram != this->variantBase || missingMaps != this->variantMaps
+        || this->variant == nullptr)
+    {
+      ShaderDefines defines;
+      for (GLuint i = 0; i < std::size(optionalMaps); i++)
+        if (missingMaps & (1 << i))
+          defines[optionalMaps[i].second] = "";
+
+      this->variant = baseProgram->getVariant(defines);
+      this->variantBase = baseProgram;
+      this->variantMaps = missingMaps;
+    }
+
+    this->uploadUniforms(this->variant, missingMaps);
+    return this->variant;
+  }
+
+  GLuint
+  Material::getMissingMaps()
+  {
+    GLuint missingMaps = 0;
+    for (GLuint i = 0; i < std::size(optionalMaps); i++)
+    {
+      auto loc = Utilities::pairGet<std::string, std::string>(this->sampler2Ds,
+                                                              optionalMaps[i].first);
+      if (loc == this->sampler2Ds.end() || loc->second == "None"
+          || isPlaceholder(loc->first, loc->second))
+        missingMaps |= 1 << i;
+    }
+
+    return missingMaps;
+  }
+
+  void
+  Material::uploadUniforms(Shader* program, GLuint skippedMaps)
   {
     auto textureCache = AssetManager<Texture2D>::getManager();
     unsigned int samplerCount = 0;
@@ -142,10 +226,10 @@ namespace SciRenderer
     {
       case MaterialType::PBR:
       {
-        // Bind the PBR maps first.
-        overrideProgram->addUniformSampler("irradianceMap", 0);
-      	overrideProgram->addUniformSampler("reflectanceMap", 1);
-      	overrideProgram->addUniformSampler("brdfLookUp", 2);
+        // Bind the PBR maps first. Unit 0 is left unused, the diffuse
+        // irradiance is a uniform block now.
+      	program->addUniformSampler("reflectanceMap", 1);
+      	program->addUniformSampler("brdfLookUp", 2);
 
         // Increase the sampler count to compensate.
         samplerCount += 3;
@@ -159,12 +243,16 @@ namespace SciRenderer
         break;
     }
 
-    // Loop over 2D textures and assign them.
+    // Loop over 2D textures and assign them, the skipped maps aren't sampled.
     for (auto& pair : this->sampler2Ds)
     {
+      GLint mapIndex = skippedMaps != 0 ? getOptionalMapIndex(pair.first) : -1;
+      if (mapIndex >= 0 && (skippedMaps & (1 << mapIndex)))
+        continue;
+
       Texture2D* sampler = textureCache->getAsset(pair.second);
 
-      overrideProgram->addUniformSampler(pair.first.c_str(), samplerCount);
+      program->addUniformSampler(pair.first.c_str(), samplerCount);
       if (sampler != nullptr)
         sampler->bind(samplerCount);
 
@@ -173,19 +261,19 @@ namespace SciRenderer
 
     // TODO: Do other sampler types (1D textures, 3D textures, cubemaps).
     for (auto& pair : this->floats)
-      overrideProgram->addUniformFloat(pair.first.c_str(), pair.second);
+      program->addUniformFloat(pair.first.c_str(), pair.second);
     for (auto& pair : this->vec2s)
-      overrideProgram->addUniformVector(pair.first.c_str(), pair.second);
+      program->addUniformVector(pair.first.c_str(), pair.second);
     for (auto& pair : this->vec3s)
-      overrideProgram->addUniformVector(pair.first.c_str(), pair.second);
+      program->addUniformVector(pair.first.c_str(), pair.second);
     for (auto& pair : this->vec4s)
-      overrideProgram->addUniformVector(pair.first.c_str(), pair.second);
+      program->addUniformVector(pair.first.c_str(), pair.second);
     for (auto& pair : this->mat3s)
-      overrideProgram->addUniformMatrix(pair.first.c_str(), pair.second, GL_FALSE);
+      program->addUniformMatrix(pair.first.c_str(), pair.second, GL_FALSE);
     for (auto& pair : this->mat4s)
-      overrideProgram->addUniformMatrix(pair.first.c_str(), pair.second, GL_FALSE);
+      program->addUniformMatrix(pair.first.c_str(), pair.second, GL_FALSE);
 
-    overrideProgram->bind();
+    program->bind();
   }
 
   // Search for and attach textures to a sampler.
@@ -0,0 +1,369 @@
+#include "Graphics/MeshOptimizer.h"
+
+namespace SciRenderer
+{
+  //----------------------------------------------------------------------------
+  // Parameters for Forsyth's vertex scoring function. These are the values
+  // recommended in the original article.
+  //----------------------------------------------------------------------------
+  static const GLuint forsythCacheSize = 32;
+  static const GLfloat forsythCacheDecayPower = 1.5f;
+  static const GLfloat forsythLastTriScore = 0.75f;
+  static const GLfloat forsythValenceBoostScale = 2.0f;
+  static const GLfloat forsythValenceBoostPower = 0.5f;
+
+  // Score a vertex given its position in the simulated LRU cache (-1 if not
+  // in the cache) and the number of triangles which still use it.
+  static GLfloat
+  forsythVertexScore(int cachePosition, GLuint remainingTris)
+  {
+    if (remainingTris == 0)
+      return -1.0f;
+
+    GLfloat score = 0.0f;
+    if (cachePosition >= 0)
+    {
+      // The three vertices of the last triangle get a fixed score so the
+      // algorithm doesn't favour strips too heavily.
+      if (cachePosition < 3)
+        score = forsythLastTriScore;
+      else
+      {
+        const GLfloat scaler = 1.0f / (forsythCacheSize - 3);
+        score = 1.0f - (cachePosition - 3) * scaler;
+        score = std::pow(score, forsythCacheDecayPower);
+      }
+    }
+
+    // Boost vertices with few remaining triangles to get rid of lone verts.
+    score += forsythValenceBoostScale
+           * std::pow((GLfloat) remainingTris, -forsythValenceBoostPower);
+
+    return score;
+  }
+
+  void
+  MeshOptimizer::optimizeVertexCache(std::vector<GLuint> &indices,
+                                     GLuint numVertices)
+  {
+    const GLuint numTris = indices.size() / 3;
+    if (numTris < 2 || numVertices == 0)
+      return;
+
+    // Build the vertex-triangle adjacency.
+    std::vector<GLuint> triCounts(numVertices, 0);
+    for (GLuint i = 0; i < numTris * 3; i++)
+      triCounts[indices[i]]++;
+
+    std::vector<GLuint> triOffsets(numVertices + 1, 0);
+    for (GLuint i = 0; i < numVertices; i++)
+      triOffsets[i + 1] = triOffsets[i] + triCounts[i];
+
+    std::vector<GLuint> adjacency(numTris * 3);
+    std::vector<GLuint> fill(triOffsets.begin(), triOffsets.end() - 1);
+    for (GLuint i = 0; i < numTris * 3; i++)
+      adjacency[fill[indices[i]]++] = i / 3;
+
+    // Remaining triangle counts get decremented as triangles are emitted,
+    // adjacency lists are compacted in the same way.
+    std::vector<GLuint> remaining = triCounts;
+    std::vector<GLfloat> vertexScores(numVertices);
+    for (GLuint i = 0; i < numVertices; i++)
+      vertexScores[i] = forsythVertexScore(-1, remaining[i]);
+
+    std::vector<GLfloat> triScores(numTris);
+    std::vector<bool> triEmitted(numTris, false);
+    for (GLuint i = 0; i < numTris; i++)
+    {
+      triScores[i] = vertexScores[indices[3 * i]]
+                   + vertexScores[indices[3 * i + 1]]
+                   + vertexScores[indices[3 * i + 2]];
+    }
+
+    // The simulated LRU cache. Has 3 extra slots for the incoming triangle.
+    std::vector<GLuint> cache;
+    std::vector<GLuint> newCache;
+    cache.reserve(forsythCacheSize + 3);
+    newCache.reserve(forsythCacheSize + 3);
+
+    std::vector<GLuint> outIndices;
+    outIndices.reserve(numTris * 3);
+
+    GLuint scanCursor = 0;
+    int bestTri = -1;
+    GLfloat bestScore = -1.0f;
+    for (GLuint i = 0; i < numTris; i++)
+    {
+      if (triScores[i] > bestScore)
+      {
+        bestScore = triScores[i];
+        bestTri = i;
+      }
+    }
+
+    for (GLuint emitted = 0; emitted < numTris; emitted++)
+    {
+      // Nothing in the cache has remaining triangles, fall back to a linear
+      // scan for the next unemitted triangle.
+      if (bestTri < 0)
+      {
+        while (scanCursor < numTris && triEmitted[scanCursor])
+          scanCursor++;
+        bestTri = scanCursor;
+      }
+
+      // Emit the triangle.
+      triEmitted[bestTri] = true;
+      newCache.clear();
+      for (GLuint j = 0; j < 3; j++)
+      {
+        GLuint vertex = indices[3 * bestTri + j];
+        outIndices.push_back(vertex);
+        newCache.push_back(vertex);
+
+        // Remove the triangle from the vertex's adjacency.
+        GLuint* begin = &adjacency[triOffsets[vertex]];
+        GLuint* end = begin + remaining[vertex];
+        GLuint* pos = std::find(begin, end, (GLuint) bestTri);
+        std::swap(*pos, *(end - 1));
+        remaining[vertex]--;
+      }
+
+      // Push the triangle's vertices to the front of the cache.
+      for (GLuint vertex : cache)
+        if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end())
+          newCache.push_back(vertex);
+
+      // Update the scores of everything which was in the cache.
+      for (GLuint j = 0; j < newCache.size(); j++)
+      {
+        GLuint vertex = newCache[j];
+        int position = j < forsythCacheSize ? j : -1;
+        vertexScores[vertex] = forsythVertexScore(position, remaining[vertex]);
+      }
+
+      // Rescore the triangles touching the cache and find the next best one.
+      bestTri = -1;
+      bestScore = -1.0f;
+      for (GLuint vertex : newCache)
+      {
+        for (GLuint k = 0; k < remaining[vertex]; k++)
+        {
+          GLuint tri = adjacency[triOffsets[vertex] + k];
+          triScores[tri] = vertexScores[indices[3 * tri]]
+                         + vertexScores[indices[3 * tri + 1]]
+                         + vertexScores[indices[3 * tri + 2]];
+
+          if (triScores[tri] > bestScore)
+          {
+            bestScore = triScores[tri];
+            bestTri = tri;
+          }
+        }
+      }
+
+      cache.swap(newCache);
+      if (cache.size() > forsythCacheSize)
+        cache.resize(forsythCacheSize);
+    }
+
+    indices.swap(outIndices);
+  }
+
+  // Simulate a FIFO cache over a single triangle, returns the number of misses.
+  static GLuint
+  fifoCacheTriangle(const GLuint* tri, std::vector<GLuint> &timestamps,
+                    GLuint &time, GLuint cacheSize)
+  {
+    GLuint misses = 0;
+    for (GLuint j = 0; j < 3; j++)
+    {
+      if (time - timestamps[tri[j]] > cacheSize)
+      {
+        timestamps[tri[j]] = time++;
+        misses++;
+      }
+    }
+    return misses;
+  }
+
+  void
+  MeshOptimizer::optimizeOverdraw(std::vector<GLuint> &indices,
+                                  const std::vector<Vertex> &vertices,
+                                  GLfloat threshold)
+  {
+    const GLuint numTris = indices.size() / 3;
+    const GLuint cacheSize = 16;
+    if (numTris < 2)
+      return;
+
+    // Find the hard boundaries, places where the cache optimized order
+    // restarted with a triangle that missed entirely.
+    std::vector<GLuint> hardClusters;
+    {
+      std::vector<GLuint> timestamps(vertices.size(), 0);
+      GLuint time = cacheSize + 1;
+      for (GLuint i = 0; i < numTris; i++)
+      {
+        if (fifoCacheTriangle(&indices[3 * i], timestamps, time, cacheSize) == 3)
+          hardClusters.push_back(i);
+      }
+    }
+    if (hardClusters.empty() || hardClusters[0] != 0)
+      hardClusters.insert(hardClusters.begin(), 0);
+
+    // Split the hard clusters into soft clusters wherever the local ACMR is
+    // within the threshold of the hard cluster's ACMR.
+    std::vector<GLuint> clusters;
+    {
+      std::vector<GLuint> timestamps(vertices.size(), 0);
+      GLuint time = cacheSize + 1;
+      for (GLuint c = 0; c < hardClusters.size(); c++)
+      {
+        GLuint start = hardClusters[c];
+        GLuint end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : numTris;
+
+        GLuint clusterMisses = 0;
+        time += cacheSize + 1;
+        for (GLuint i = start; i < end; i++)
+          clusterMisses += fifoCacheTriangle(&indices[3 * i], timestamps, time, cacheSize);
+        GLfloat clusterThreshold = threshold * ((GLfloat) clusterMisses / (GLfloat) (end - start));
+
+        clusters.push_back(start);
+        time += cacheSize + 1;
+        GLuint misses = 0;
+        GLuint softStart = start;
+        for (GLuint i = start; i < end; i++)
+        {
+          misses += fifoCacheTriangle(&indices[3 * i], timestamps, time, cacheSize);
+          if (i + 1 < end && ((GLfloat) misses / (GLfloat) (i - softStart + 1)) <= clusterThreshold)
+          {
+            clusters.push_back(i + 1);
+            softStart = i + 1;
+            misses = 0;
+            time += cacheSize + 1;
+          }
+        }
+      }
+    }
+
+    // The sort key is the alignment between the cluster's normal and the
+    // offset of the cluster from the mesh centroid. Clusters on the outside
+    // facing away from the center are likely to occlude the others.
+    glm::vec3 meshCentroid = glm::vec3(0.0f);
+    GLfloat meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCentroids(clusters.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(clusters.size(), glm::vec3(0.0f));
+    for (GLuint c = 0; c < clusters.size(); c++)
+    {
+      GLuint end = c + 1 < clusters.size() ? clusters[c + 1] : numTris;
+
+      GLfloat clusterArea = 0.0f;
+      for (GLuint i = clusters[c]; i < end; i++)
+      {
+        glm::vec3 p0 = glm::vec3(vertices[indices[3 * i]].position);
+        glm::vec3 p1 = glm::vec3(vertices[indices[3 * i + 1]].position);
+        glm::vec3 p2 = glm::vec3(vertices[indices[3 * i + 2]].position);
+
+        // Area weighted normal and centroid.
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        GLfloat area = glm::length(normal);
+        glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
+
+        clusterNormals[c] += normal;
+        clusterCentroids[c] += centroid * area;
+        clusterArea += area;
+        meshCentroid += centroid * area;
+        meshArea += area;
+      }
+
+      if (clusterArea > 0.0f)
+        clusterCentroids[c] /= clusterArea;
+    }
+    if (meshArea > 0.0f)
+      meshCentroid /= meshArea;
+
+    std::vector<GLfloat> sortKeys(clusters.size());
+    std::vector<GLuint> clusterOrder(clusters.size());
+    for (GLuint c = 0; c < clusters.size(); c++)
+    {
+      GLfloat length = glm::length(clusterNormals[c]);
+      glm::vec3 normal = length > 0.0f ? clusterNormals[c] / length : glm::vec3(0.0f);
+      sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, normal);
+      clusterOrder[c] = c;
+    }
+
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](GLuint a, GLuint b)
+    {
+      return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<GLuint> outIndices;
+    outIndices.reserve(indices.size());
+    for (GLuint c : clusterOrder)
+    {
+      GLuint end = c + 1 < clusters.size() ? clusters[c + 1] : numTris;
+      outIndices.insert(outIndices.end(), indices.begin() + 3 * clusters[c],
+                        indices.begin() + 3 * end);
+    }
+
+    indices.swap(outIndices);
+  }
+
+  void
+  MeshOptimizer::optimizeVertexFetch(std::vector<Vertex> &vertices,
+                                     std::vector<GLuint> &indices)
+  {
+    const GLuint unmapped = std::numeric_limits<GLuint>::max();
+    std::vector<GLuint> remap(vertices.size(), unmapped);
+
+    std::vector<Vertex> outVertices;
+    outVertices.reserve(vertices.size());
+    for (GLuint &index : indices)
+    {
+      if (remap[index] == unmapped)
+      {
+        remap[index] = outVertices.size();
+        outVertices.push_back(vertices[index]);
+      }
+      index = remap[index];
+    }
+
+    vertices.swap(outVertices);
+  }
+
+  VertexCacheStats
+  MeshOptimizer::analyzeVertexCache(const std::vector<GLuint> &indices,
+                                    GLuint numVertices, GLuint cacheSize)
+  {
+    VertexCacheStats outStats;
+
+    const GLuint numTris = indices.size() / 3;
+    if (numTris == 0 || numVertices == 0)
+      return outStats;
+
+    std::vector<GLuint> timestamps(numVertices, 0);
+    std::vector<bool> referenced(numVertices, false);
+    GLuint time = cacheSize + 1;
+    GLuint misses = 0;
+    GLuint uniqueVertices = 0;
+    for (GLuint i = 0; i < numTris; i++)
+    {
+      misses += fifoCacheTriangle(&indices[3 * i], timestamps, time, cacheSize);
+
+      for (GLuint j = 0; j < 3; j++)
+      {
+        if (!referenced[indices[3 * i + j]])
+        {
+          referenced[indices[3 * i + j]] = true;
+          uniqueVertices++;
+        }
+      }
+    }
+
+    outStats.acmr = (GLfloat) misses / (GLfloat) numTris;
+    outStats.atvr = (GLfloat) misses / (GLfloat) uniqueVertices;
+
+    return outStats;
+  }
+}
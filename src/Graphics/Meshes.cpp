@@ -33,6 +33,15 @@ namespace SciRenderer
     this->vArray->addAttribute(3, AttribType::Vec3, GL_FALSE, sizeof(Vertex), offsetof(Vertex, uv));
     this->vArray->addAttribute(4, AttribType::Vec3, GL_FALSE, sizeof(Vertex), offsetof(Vertex, tangent));
     this->vArray->addAttribute(5, AttribType::Vec3, GL_FALSE, sizeof(Vertex), offsetof(Vertex, bitangent));
+
+    std::vector<glm::vec4> positions;
+    positions.reserve(this->data.size());
+    for (auto& vertex : this->data)
+      positions.push_back(vertex.position);
+
+    this->positionArray = createUnique<VertexArray>(positions.data(), positions.size() * sizeof(glm::vec4), BufferType::Dynamic);
+    this->positionArray->addIndexBuffer(this->indices.data(), this->indices.size(), BufferType::Dynamic);
+    this->positionArray->addAttribute(0, AttribType::Vec4, GL_FALSE, sizeof(glm::vec4), 0);
   }
 
   void
@@ -0,0 +1,340 @@
+#include "Graphics/MipGenerator.h"
+
+// Project includes.
+#include "Core/ThreadPool.h"
+
+// SIMD includes.
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// STL includes.
+#include <functional>
+#include <limits>
+
+namespace SciRenderer
+{
+  // Rows per job when work is split across the thread pool.
+  static const GLuint rowsPerJob = 32;
+
+  // Run job(firstRow, lastRow) over bands of rows on the thread pool. The
+  // calling thread helps out while waiting, so this can be called from jobs.
+  static void
+  parallelRows(GLuint numRows, const std::function<void(GLuint, GLuint)> &job)
+  {
+    if (numRows <= rowsPerJob)
+    {
+      job(0, numRows);
+      return;
+    }
+
+    auto workerGroup = ThreadPool::getInstance(2);
+
+    std::vector<std::future<void>> bands;
+    for (GLuint firstRow = 0; firstRow < numRows; firstRow += rowsPerJob)
+      bands.push_back(workerGroup->push(job, firstRow, std::min(firstRow + rowsPerJob, numRows)));
+
+    for (auto& band : bands)
+      workerGroup->waitFor(band);
+  }
+
+  //----------------------------------------------------------------------------
+  // Filter kernels.
+  //----------------------------------------------------------------------------
+  static GLfloat
+  besselI0(GLfloat x)
+  {
+    GLfloat sum = 1.0f;
+    GLfloat term = 1.0f;
+    for (GLuint k = 1; k < 16; k++)
+    {
+      term *= (x / (2.0f * k)) * (x / (2.0f * k));
+      sum += term;
+    }
+    return sum;
+  }
+
+  // Radius of the filters, in destination texels.
+  static GLfloat
+  getFilterSupport(TextureMipFilter filter)
+  {
+    switch (filter)
+    {
+      case TextureMipFilter::Box: return 0.5f;
+      case TextureMipFilter::Triangle: return 1.0f;
+      case TextureMipFilter::Kaiser: return 2.0f;
+      default: return 0.5f;
+    }
+  }
+
+  // Weight of a texel x destination texels from the center of the filter.
+  static GLfloat
+  evaluateFilter(TextureMipFilter filter, GLfloat x)
+  {
+    x = std::abs(x);
+    switch (filter)
+    {
+      case TextureMipFilter::Box:
+        return x <= 0.5f ? 1.0f : 0.0f;
+      case TextureMipFilter::Triangle:
+        return std::max(1.0f - x, 0.0f);
+      case TextureMipFilter::Kaiser:
+      {
+        // Sinc windowed by a Kaiser window with alpha = 4.
+        const GLfloat support = 2.0f;
+        const GLfloat alpha = 4.0f;
+        if (x >= support)
+          return 0.0f;
+
+        GLfloat sinc = 1.0f;
+        if (x > 1e-5f)
+          sinc = std::sin(M_PI * x) / (M_PI * x);
+
+        GLfloat t = x / support;
+        return sinc * besselI0(alpha * std::sqrt(1.0f - t * t)) / besselI0(alpha);
+      }
+      default:
+        return 0.0f;
+    }
+  }
+
+  // The source texels and weights each destination texel filters along one
+  // axis. Every texel has numTaps taps, the indices are clamped to the edge
+  // of the image.
+  struct FilterTaps
+  {
+    GLuint numTaps;
+    std::vector<GLuint> indices;
+    std::vector<GLfloat> weights;
+  };
+
+  static void
+  computeTaps(TextureMipFilter filter, GLuint sourceSize, GLuint destinationSize,
+              FilterTaps &outTaps)
+  {
+    const GLfloat scale = (GLfloat) sourceSize / (GLfloat) destinationSize;
+    const GLfloat radius = getFilterSupport(filter) * scale;
+    outTaps.numTaps = (GLuint) std::ceil(2.0f * radius) + 1;
+    outTaps.indices.resize(destinationSize * outTaps.numTaps);
+    outTaps.weights.resize(destinationSize * outTaps.numTaps);
+
+    for (GLuint i = 0; i < destinationSize; i++)
+    {
+      GLfloat center = (i + 0.5f) * scale;
+      int first = (int) std::floor(center - radius);
+
+      GLfloat totalWeight = 0.0f;
+      for (GLuint t = 0; t < outTaps.numTaps; t++)
+      {
+        int source = first + (int) t;
+        GLfloat weight = evaluateFilter(filter, (source + 0.5f - center) / scale);
+
+        outTaps.indices[i * outTaps.numTaps + t] = std::min(std::max(source, 0), (int) sourceSize - 1);
+        outTaps.weights[i * outTaps.numTaps + t] = weight;
+        totalWeight += weight;
+      }
+
+      for (GLuint t = 0; t < outTaps.numTaps; t++)
+        outTaps.weights[i * outTaps.numTaps + t] /= totalWeight;
+    }
+  }
+
+  // Weighted sum of RGBA texels, one texel is one SSE register.
+  static inline void
+  accumulateTexels(const GLfloat* const* texels, const GLfloat* weights,
+                   GLuint numTaps, GLfloat* destination)
+  {
+#if defined(__SSE2__)
+    __m128 sum = _mm_setzero_ps();
+    for (GLuint t = 0; t < numTaps; t++)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(texels[t])));
+    _mm_storeu_ps(destination, sum);
+#else
+    GLfloat sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (GLuint t = 0; t < numTaps; t++)
+      for (GLuint c = 0; c < 4; c++)
+        sum[c] += weights[t] * texels[t][c];
+    for (GLuint c = 0; c < 4; c++)
+      destination[c] = sum[c];
+#endif
+  }
+
+  // Separable downsample, horizontally into a temporary level, then
+  // vertically into the destination.
+  static void
+  downsampleLevel(const MipLevel &source, TextureMipFilter filter, MipLevel &destination)
+  {
+    destination.width = std::max(source.width / 2, 1u);
+    destination.height = std::max(source.height / 2, 1u);
+    destination.texels.resize(destination.width * destination.height * 4);
+
+    FilterTaps horTaps, verTaps;
+    computeTaps(filter, source.width, destination.width, horTaps);
+    computeTaps(filter, source.height, destination.height, verTaps);
+
+    std::vector<GLfloat> temp(destination.width * source.height * 4);
+
+    parallelRows(source.height, [&](GLuint firstRow, GLuint lastRow)
+    {
+      std::vector<const GLfloat*> texels(horTaps.numTaps);
+      for (GLuint y = firstRow; y < lastRow; y++)
+      {
+        const GLfloat* row = &source.texels[4 * y * source.width];
+        for (GLuint x = 0; x < destination.width; x++)
+        {
+          for (GLuint t = 0; t < horTaps.numTaps; t++)
+            texels[t] = row + 4 * horTaps.indices[x * horTaps.numTaps + t];
+
+          accumulateTexels(texels.data(), &horTaps.weights[x * horTaps.numTaps],
+                           horTaps.numTaps, &temp[4 * (y * destination.width + x)]);
+        }
+      }
+    });
+
+    parallelRows(destination.height, [&](GLuint firstRow, GLuint lastRow)
+    {
+      std::vector<const GLfloat*> texels(verTaps.numTaps);
+      for (GLuint y = firstRow; y < lastRow; y++)
+      {
+        for (GLuint x = 0; x < destination.width; x++)
+        {
+          for (GLuint t = 0; t < verTaps.numTaps; t++)
+            texels[t] = &temp[4 * (verTaps.indices[y * verTaps.numTaps + t] * destination.width + x)];
+
+          accumulateTexels(texels.data(), &verTaps.weights[y * verTaps.numTaps],
+                           verTaps.numTaps, &destination.texels[4 * (y * destination.width + x)]);
+        }
+      }
+    });
+  }
+
+  //----------------------------------------------------------------------------
+  // Colour space conversions.
+  //----------------------------------------------------------------------------
+  static GLfloat
+  srgbToLinear(GLfloat value)
+  {
+    if (value <= 0.04045f)
+      return value / 12.92f;
+    return std::pow((value + 0.055f) / 1.055f, 2.4f);
+  }
+
+  static GLfloat
+  linearToSRGB(GLfloat value)
+  {
+    if (value <= 0.0031308f)
+      return value * 12.92f;
+    return 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+  }
+
+  // Apply a conversion to the colour channels of a level, alpha is linear.
+  static void
+  convertColour(MipLevel &level, GLfloat (*conversion)(GLfloat))
+  {
+    parallelRows(level.height, [&](GLuint firstRow, GLuint lastRow)
+    {
+      for (GLuint i = firstRow * level.width; i < lastRow * level.width; i++)
+        for (GLuint c = 0; c < 3; c++)
+          level.texels[4 * i + c] = conversion(level.texels[4 * i + c]);
+    });
+  }
+
+  // Negative lobes of the filters can push values out of range.
+  static void
+  clampLevel(MipLevel &level, bool isHDR)
+  {
+    const GLfloat maxValue = isHDR ? std::numeric_limits<GLfloat>::max() : 1.0f;
+    for (auto& texel : level.texels)
+      texel = std::min(std::max(texel, 0.0f), maxValue);
+  }
+
+  //----------------------------------------------------------------------------
+  // Mip generation.
+  //----------------------------------------------------------------------------
+  void
+  MipGenerator::expandToRGBA(const void* pixels, GLuint width, GLuint height, int n,
+                             bool isHDR, MipLevel &outLevel)
+  {
+    outLevel.width = width;
+    outLevel.height = height;
+    outLevel.texels.resize(width * height * 4);
+
+    parallelRows(height, [&](GLuint firstRow, GLuint lastRow)
+    {
+      for (GLuint i = firstRow * width; i < lastRow * width; i++)
+      {
+        for (int c = 0; c < 4; c++)
+        {
+          GLfloat value = (c == 3) ? 1.0f : 0.0f;
+          if (c < n)
+          {
+            if (isHDR)
+              value = static_cast<const float*>(pixels)[n * i + c];
+            else
+              value = static_cast<const unsigned char*>(pixels)[n * i + c] / 255.0f;
+          }
+          outLevel.texels[4 * i + c] = value;
+        }
+      }
+    });
+  }
+
+  void
+  MipGenerator::generateMips(MipLevel &&baseLevel, TextureMipFilter filter,
+                             bool isSRGB, bool isHDR,
+                             const std::function<void(GLuint, const MipLevel&)> &onLevel)
+  {
+    const bool isGammaEncoded = isSRGB && !isHDR;
+
+    MipLevel current = std::move(baseLevel);
+    onLevel(0, current);
+
+    // Filter in linear space, each level is downsampled from the linear
+    // version of the previous one. The encoded copy of a level only lives
+    // until it's handed out.
+    if (isGammaEncoded)
+      convertColour(current, srgbToLinear);
+
+    GLuint index = 0;
+    while (current.width > 1 || current.height > 1)
+    {
+      MipLevel nextLevel;
+      downsampleLevel(current, filter, nextLevel);
+      clampLevel(nextLevel, isHDR);
+      current = std::move(nextLevel);
+      index++;
+
+      if (isGammaEncoded)
+      {
+        MipLevel encoded = current;
+        convertColour(encoded, linearToSRGB);
+        onLevel(index, encoded);
+      }
+      else
+        onLevel(index, current);
+    }
+  }
+
+  void
+  MipGenerator::packLevel(const MipLevel &level, int channels, bool isHDR,
+                          void* destination)
+  {
+    parallelRows(level.height, [&](GLuint firstRow, GLuint lastRow)
+    {
+      for (GLuint i = firstRow * level.width; i < lastRow * level.width; i++)
+      {
+        for (int c = 0; c < channels; c++)
+        {
+          GLfloat value = level.texels[4 * i + c];
+          if (isHDR)
+            static_cast<float*>(destination)[channels * i + c] = value;
+          else
+          {
+            static_cast<unsigned char*>(destination)[channels * i + c]
+              = (unsigned char) std::round(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+          }
+        }
+      }
+    });
+  }
+}
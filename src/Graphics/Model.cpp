@@ -1,140 +1,402 @@
 #include "Graphics/Model.h"
 
 // Project includes.
+#include "Core/AssetCache.h"
 #include "Core/AssetManager.h"
 #include "Core/ThreadPool.h"
 #include "Core/Logs.h"
 #include "Core/Events.h"
 #include "Graphics/Material.h"
+#include "Graphics/MeshOptimizer.h"
 
 namespace SciRenderer
 {
-  std::queue<std::pair<Model*, ModelMaterial*>> Model::asyncModelQueue;
-  std::mutex Model::asyncModelMutex;
+  std::queue<StreamedSubmesh> Model::asyncMeshQueue;
+  std::mutex Model::asyncMeshMutex;
 
-  void
-  Model::bulkGenerateMaterials()
+  // Cooked models are the converted submeshes in node traversal order, with
+  // their names, bounds, vertices and indices.
+  static const GLuint cookedModelMagic = 0x4C444F4D;
+
+  // The path of the cooked model in the asset cache, empty if the source
+  // can't be read. Bump the version whenever the conversion changes.
+  static std::string
+  getCookedModelPath(const std::string &filepath, ModelImportFlags flags)
+  {
+    auto cache = AssetCache::getInstance();
+    std::string key = cache->getKey(filepath, "Model:1:" + std::to_string(flags));
+    if (key == "")
+      return "";
+
+    return cache->getPath(key, ".mesh");
+  }
+
+  static bool
+  readCookedModel(const std::string &cookedPath, Model* parent,
+                  std::vector<Shared<Mesh>> &outMeshes)
+  {
+    std::vector<unsigned char> blob;
+    if (cookedPath == "" || !AssetCache::getInstance()->readBlob(cookedPath, blob))
+      return false;
+
+    BlobReader reader(blob);
+    GLuint magic, numMeshes;
+    if (!reader.read(magic) || magic != cookedModelMagic || !reader.read(numMeshes))
+      return false;
+
+    for (GLuint i = 0; i < numMeshes; i++)
+    {
+      std::string meshName;
+      glm::vec3 meshMin, meshMax;
+      GLuint numVertices, numIndices;
+      if (!reader.readString(meshName) || !reader.read(meshMin) || !reader.read(meshMax)
+          || !reader.read(numVertices) || !reader.read(numIndices))
+        return false;
+
+      if (reader.remaining() < (size_t) numVertices * sizeof(Vertex) + (size_t) numIndices * sizeof(GLuint))
+        return false;
+
+      std::vector<Vertex> meshVertices(numVertices);
+      std::vector<GLuint> meshIndices(numIndices);
+      reader.readBytes(meshVertices.data(), numVertices * sizeof(Vertex));
+      reader.readBytes(meshIndices.data(), numIndices * sizeof(GLuint));
+
+      auto outMesh = createShared<Mesh>(meshName, meshVertices, meshIndices, parent);
+      outMesh->getMinPos() = meshMin;
+      outMesh->getMaxPos() = meshMax;
+      outMeshes.push_back(outMesh);
+    }
+
+    return reader.remaining() == 0;
+  }
+
+  static void
+  writeCookedModel(const std::string &cookedPath, const std::vector<Shared<Mesh>> &meshes)
   {
-    // This occasionally segfaults... TODO: Figure out a better solution.
-    std::lock_guard<std::mutex> imageGuard(asyncModelMutex);
+    BlobWriter writer;
+    writer.write(cookedModelMagic);
+
+    GLuint numMeshes = 0;
+    for (auto& mesh : meshes)
+      numMeshes += mesh ? 1 : 0;
+    writer.write(numMeshes);
+
+    for (auto& mesh : meshes)
+    {
+      if (!mesh)
+        continue;
+
+      writer.writeString(mesh->getName());
+      writer.write(mesh->getMinPos());
+      writer.write(mesh->getMaxPos());
+      writer.write<GLuint>(mesh->getData().size());
+      writer.write<GLuint>(mesh->getIndices().size());
+      writer.writeBytes(mesh->getData().data(), mesh->getData().size() * sizeof(Vertex));
+      writer.writeBytes(mesh->getIndices().data(), mesh->getIndices().size() * sizeof(GLuint));
+    }
+
+    AssetCache::getInstance()->writeBlob(cookedPath, writer.bytes);
+  }
+
+  GLuint
+  Model::bulkGenerateMaterials(GLuint uploadBudget)
+  {
+    std::lock_guard<std::mutex> meshGuard(asyncMeshMutex);
 
     Logger* logs = Logger::getInstance();
 
-    while (!asyncModelQueue.empty())
+    // Upload the submeshes which finished streaming in. At least one submesh
+    // is uploaded per frame while there's budget left, so meshes larger than
+    // the budget still load.
+    GLuint uploadedBytes = 0;
+    while (!asyncMeshQueue.empty())
     {
-      auto& model = asyncModelQueue.front().first;
-      auto& materials = asyncModelQueue.front().second;
-      auto& submeshes = model->getSubmeshes();
-      auto& submaterials = materials->getStorage();
+      auto& streamed = asyncMeshQueue.front();
+
+      if (streamed.submesh)
+      {
+        GLuint meshBytes = streamed.submesh->getData().size() * sizeof(Vertex)
+                         + streamed.submesh->getIndices().size() * sizeof(GLuint);
+        if (uploadBudget == 0 || (uploadedBytes > 0 && uploadedBytes + meshBytes > uploadBudget))
+          break;
+
+        streamed.submesh->generateVAO();
+        uploadedBytes += meshBytes;
+
+        auto& meshName = streamed.submesh->getName();
+        streamed.model->subMeshes.push_back(std::pair(meshName, streamed.submesh));
+        streamed.materials->attachMesh(meshName, MaterialType::PBR);
+      }
 
-      if (submaterials.size() == 0)
+      // Stop drawing the proxy once all of the submeshes are in.
+      streamed.model->numStreamedMeshes++;
+      if (streamed.model->numStreamedMeshes == streamed.model->numStreamingMeshes)
       {
-        for (auto& pair : submeshes)
-          materials->attachMesh(pair.first, MaterialType::PBR);
+        streamed.model->loaded = true;
+        logs->logMessage(LogMessage("Model streamed in from path "
+                                    + streamed.model->filepath));
       }
 
-      asyncModelQueue.pop();
+      asyncMeshQueue.pop();
     }
+
+    return uploadedBytes;
   }
 
   void
   Model::asyncLoadModel(const std::string &filepath, const std::string &name,
-                        ModelMaterial* materialContainer)
+                        ModelMaterial* materialContainer, ModelImportFlags flags)
   {
     // Fetch the thread pool.
     auto workerGroup = ThreadPool::getInstance(2);
 
     auto loaderImpl = [](const std::string &filepath, const std::string &name,
-                         ModelMaterial* materialContainer)
+                         ModelMaterial* materialContainer, ModelImportFlags flags)
     {
       auto modelAssets = AssetManager<Model>::getManager();
+      auto eventDispatcher = EventDispatcher::getInstance();
 
-      if (!modelAssets->hasAsset(name))
-      {
-        Model* loadable = new Model();
-        loadable->loadModel(filepath);
+      if (modelAssets->hasAsset(name))
+        return;
+
+      eventDispatcher->queueEvent(new GuiEvent(GuiEventType::StartSpinnerEvent, filepath));
+
+      Model* loadable = new Model();
 
+      // Cooked models skip assimp entirely, all of their submeshes are queued
+      // for uploading at once.
+      std::string cookedPath = getCookedModelPath(filepath, flags);
+      std::vector<Shared<Mesh>> cooked;
+      if (readCookedModel(cookedPath, loadable, cooked))
+      {
+        loadable->filepath = filepath;
+        loadable->importFlags = flags;
+        for (auto& mesh : cooked)
+        {
+          loadable->minPos = glm::min(loadable->minPos, mesh->getMinPos());
+          loadable->maxPos = glm::max(loadable->maxPos, mesh->getMaxPos());
+        }
+        loadable->numStreamingMeshes = cooked.size();
+        loadable->loaded = cooked.empty();
         modelAssets->attachAsset(name, loadable);
 
-        std::lock_guard<std::mutex> imageGuard(asyncModelMutex);
-        asyncModelQueue.push({ loadable, materialContainer });
+        {
+          std::lock_guard<std::mutex> meshGuard(asyncMeshMutex);
+          for (auto& mesh : cooked)
+            asyncMeshQueue.push({ loadable, materialContainer, mesh });
+        }
+
+        eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
+        return;
+      }
+      cooked.clear();
+
+      Assimp::Importer importer;
+      const aiScene* scene = loadable->importScene(importer, filepath, flags);
+      if (!scene)
+      {
+        delete loadable;
+        eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
+        return;
+      }
+
+      std::vector<aiMesh*> meshes;
+      loadable->processNode(scene->mRootNode, scene, meshes);
+
+      // Quick pass over the positions to get the bounds, so a proxy can be
+      // drawn while the submeshes stream in.
+      for (auto mesh : meshes)
+      {
+        for (GLuint i = 0; i < mesh->mNumVertices; i++)
+        {
+          glm::vec3 position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y,
+                                         mesh->mVertices[i].z);
+          loadable->minPos = glm::min(loadable->minPos, position);
+          loadable->maxPos = glm::max(loadable->maxPos, position);
+        }
       }
+      loadable->numStreamingMeshes = meshes.size();
+      loadable->loaded = meshes.empty();
+      modelAssets->attachAsset(name, loadable);
+
+      // Convert each submesh as its own job and hand it to the main thread for
+      // uploading as soon as its ready.
+      auto workerGroup = ThreadPool::getInstance(2);
+      std::vector<std::future<void>> conversions;
+      conversions.reserve(meshes.size());
+      cooked.resize(meshes.size(), nullptr);
+      for (GLuint i = 0; i < meshes.size(); i++)
+      {
+        conversions.emplace_back(workerGroup->push([loadable, materialContainer, scene, &meshes, &cooked](GLuint index)
+        {
+          auto converted = loadable->processMesh(meshes[index], scene);
+          cooked[index] = converted;
+
+          std::lock_guard<std::mutex> meshGuard(asyncMeshMutex);
+          asyncMeshQueue.push({ loadable, materialContainer, converted });
+        }, i));
+      }
+
+      // The importer owns the scene, so wait for the conversions to finish.
+      for (auto& conversion : conversions)
+        workerGroup->waitFor(conversion);
+
+      if (cookedPath != "")
+        writeCookedModel(cookedPath, cooked);
+
+      eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
     };
 
-    workerGroup->push(loaderImpl, filepath, name, materialContainer);
+    workerGroup->push(loaderImpl, filepath, name, materialContainer, flags);
   }
 
   Model::Model()
     : loaded(false)
+    , importFlags(ModelImportFlags_Default)
+    , numStreamingMeshes(0)
+    , numStreamedMeshes(0)
     , minPos(std::numeric_limits<float>::max())
-    , maxPos(std::numeric_limits<float>::min())
+    , maxPos(std::numeric_limits<float>::lowest())
   { }
 
   Model::~Model()
   { }
 
-  void
-  Model::loadModel(const std::string &filepath)
+  // Import the file with assimp. Returns nullptr on failure.
+  const aiScene*
+  Model::importScene(Assimp::Importer &importer, const std::string &filepath,
+                     ModelImportFlags flags)
   {
     Logger* logs = Logger::getInstance();
-    auto eventDispatcher = EventDispatcher::getInstance();
-    eventDispatcher->queueEvent(new GuiEvent(GuiEventType::StartSpinnerEvent, filepath));
 
-    auto flags = aiProcess_CalcTangentSpace | aiProcess_GenNormals
-               | aiProcess_JoinIdenticalVertices | aiProcess_Triangulate
-               | aiProcess_GenUVCoords | aiProcess_SortByPType;
+    this->importFlags = flags;
 
-    Assimp::Importer importer;
+    unsigned int aiFlags = aiProcess_Triangulate | aiProcess_SortByPType;
+    if (flags & ModelImportFlags_GenNormals)
+      aiFlags |= aiProcess_GenNormals;
+    if (flags & ModelImportFlags_GenTangents)
+      aiFlags |= aiProcess_CalcTangentSpace;
+    if (flags & ModelImportFlags_JoinVertices)
+      aiFlags |= aiProcess_JoinIdenticalVertices;
+    if (flags & ModelImportFlags_GenUVs)
+      aiFlags |= aiProcess_GenUVCoords;
 
-    const aiScene* scene = importer.ReadFile(filepath, flags);
-    if (!scene)
+    const aiScene* scene = importer.ReadFile(filepath, aiFlags);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
       logs->logMessage(LogMessage("Model failed to load at the path " + filepath +
                                   ", with the error: " + importer.GetErrorString()
                                   + ".", true, true));
-      eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
-      return;
+      return nullptr;
     }
-    else if (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+
+    this->filepath = filepath;
+
+    return scene;
+  }
+
+  void
+  Model::loadModel(const std::string &filepath, ModelImportFlags flags)
+  {
+    Logger* logs = Logger::getInstance();
+    auto eventDispatcher = EventDispatcher::getInstance();
+    eventDispatcher->queueEvent(new GuiEvent(GuiEventType::StartSpinnerEvent, filepath));
+
+    // Use the cooked model if it's in the asset cache, otherwise import and
+    // convert the source and cook it for the next load.
+    std::string cookedPath = getCookedModelPath(filepath, flags);
+    std::vector<Shared<Mesh>> converted;
+    if (readCookedModel(cookedPath, this, converted))
+    {
+      this->filepath = filepath;
+      this->importFlags = flags;
+    }
+    else if (!this->convertScene(filepath, flags, converted))
     {
-      logs->logMessage(LogMessage("Model failed to load at the path " + filepath +
-                                  ", with the error: " + importer.GetErrorString()
-                                  + ".", true, true));
       eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
       return;
     }
+    else if (cookedPath != "")
+      writeCookedModel(cookedPath, converted);
 
-    this->filepath = filepath;
+    // Merge the submeshes and their bounds, in node traversal order.
+    for (auto& mesh : converted)
+    {
+      if (!mesh)
+        continue;
 
-    this->processNode(scene->mRootNode, scene);
+      this->minPos = glm::min(this->minPos, mesh->getMinPos());
+      this->maxPos = glm::max(this->maxPos, mesh->getMaxPos());
+      this->subMeshes.push_back(std::pair(mesh->getName(), mesh));
+    }
     this->loaded = true;
     eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
     logs->logMessage(LogMessage("Model loaded at path " + filepath));
   }
 
+  // Import the file with assimp and convert its submeshes in parallel on the
+  // thread pool, in node traversal order. Returns false if the import fails.
+  bool
+  Model::convertScene(const std::string &filepath, ModelImportFlags flags,
+                      std::vector<Shared<Mesh>> &outMeshes)
+  {
+    Assimp::Importer importer;
+    const aiScene* scene = this->importScene(importer, filepath, flags);
+    if (!scene)
+      return false;
+
+    // Gather the meshes and convert them independently on the thread pool.
+    // The loading thread helps out while waiting so this can't deadlock when
+    // called from a worker.
+    std::vector<aiMesh*> meshes;
+    this->processNode(scene->mRootNode, scene, meshes);
+
+    std::vector<Shared<Mesh>> converted(meshes.size(), nullptr);
+    if (meshes.size() == 1)
+      converted[0] = this->processMesh(meshes[0], scene);
+    else
+    {
+      auto workerGroup = ThreadPool::getInstance(2);
+
+      std::vector<std::future<void>> conversions;
+      conversions.reserve(meshes.size());
+      for (GLuint i = 0; i < meshes.size(); i++)
+      {
+        conversions.emplace_back(workerGroup->push([this, &meshes, &converted, scene](GLuint index)
+        {
+          converted[index] = this->processMesh(meshes[index], scene);
+        }, i));
+      }
+
+      for (auto& conversion : conversions)
+        workerGroup->waitFor(conversion);
+    }
+
+    outMeshes = std::move(converted);
+    return true;
+  }
+
   // Recursively process all the nodes in the mesh.
   void
-  Model::processNode(aiNode* node, const aiScene* scene)
+  Model::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*> &meshes)
   {
     for (GLuint i = 0; i < node->mNumMeshes; i++)
-    {
-      aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-      this->processMesh(mesh, scene);
-    }
+      meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
 
     for (GLuint i = 0; i < node->mNumChildren; i++)
-      this->processNode(node->mChildren[i], scene);
+      this->processNode(node->mChildren[i], scene, meshes);
   }
 
-  // Process each individual mesh.
-  void
+  // Process each individual mesh. This runs on the worker threads, so it
+  // mustn't modify the model.
+  Shared<Mesh>
   Model::processMesh(aiMesh* mesh, const aiScene* scene)
   {
     std::vector<Vertex> meshVertices;
     std::vector<GLuint> meshIndicies;
 
     glm::vec3 meshMin = glm::vec3(std::numeric_limits<float>::max());
-    glm::vec3 meshMax = glm::vec3(std::numeric_limits<float>::min());;
+    glm::vec3 meshMax = glm::vec3(std::numeric_limits<float>::lowest());
     // Get the positions.
     if (mesh->HasPositions())
     {
@@ -159,10 +421,8 @@ namespace SciRenderer
     else
     {
       // Nothing that can be done for this mesh as it has no data.
-      return;
+      return nullptr;
     }
-    this->minPos = glm::min(this->minPos, meshMin);
-    this->maxPos = glm::max(this->maxPos, meshMax);
 
     if (mesh->HasNormals())
     {
@@ -223,6 +483,15 @@ namespace SciRenderer
         meshVertices[i].bitangent = temp2;
       }
     }
+    else
+    {
+      // Tangent generation was skipped for this asset.
+      for (GLuint i = 0; i < mesh->mNumVertices; i++)
+      {
+        meshVertices[i].tangent = glm::vec3(0.0f);
+        meshVertices[i].bitangent = glm::vec3(0.0f);
+      }
+    }
 
     // Fetch the indicies.
     for (GLuint i = 0; i < mesh->mNumFaces; i++)
@@ -234,9 +503,34 @@ namespace SciRenderer
     }
 
     std::string meshName = std::string(mesh->mName.C_Str());
-    this->subMeshes.push_back(std::pair
-      (meshName, createShared<Mesh>(meshName, meshVertices, meshIndicies, this)));
-    this->subMeshes.back().second->getMinPos() = meshMin;
-    this->subMeshes.back().second->getMaxPos() = meshMax;
+
+    // Optimize the triangle order for the post-transform cache and overdraw,
+    // then the vertex order for fetch locality. Only triangle lists are
+    // touched, SortByPType splits out points and lines.
+    if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE
+        && this->importFlags & ModelImportFlags_OptimizeMeshes)
+    {
+      auto before = MeshOptimizer::analyzeVertexCache(meshIndicies, meshVertices.size());
+
+      MeshOptimizer::optimizeVertexCache(meshIndicies, meshVertices.size());
+      MeshOptimizer::optimizeOverdraw(meshIndicies, meshVertices);
+      MeshOptimizer::optimizeVertexFetch(meshVertices, meshIndicies);
+
+      auto after = MeshOptimizer::analyzeVertexCache(meshIndicies, meshVertices.size());
+
+      Logger* logs = Logger::getInstance();
+      logs->logMessage(LogMessage("Optimized submesh " + meshName + " ("
+                                  + std::to_string(meshIndicies.size() / 3)
+                                  + " triangles). ACMR: " + std::to_string(before.acmr)
+                                  + " -> " + std::to_string(after.acmr) + ", ATVR: "
+                                  + std::to_string(before.atvr) + " -> "
+                                  + std::to_string(after.atvr) + ".", true, false));
+    }
+
+    auto outMesh = createShared<Mesh>(meshName, meshVertices, meshIndicies, this);
+    outMesh->getMinPos() = meshMin;
+    outMesh->getMaxPos() = meshMax;
+
+    return outMesh;
   }
 }
@@ -0,0 +1,205 @@
+#include "Graphics/OcclusionCuller.h"
+
+namespace SciRenderer
+{
+  // Parameters for building a level of the pyramid.
+  struct PyramidParams
+  {
+    glm::ivec2 inputSize;
+    glm::ivec2 outputSize;
+    GLuint firstLevel;
+    GLuint padding[3];
+  };
+
+  // Parameters for the culling pass.
+  struct CullParams
+  {
+    glm::mat4 viewProj;
+    glm::vec2 pyramidSize;
+    GLuint numDraws;
+    GLuint phase;
+    GLuint numLevels;
+    GLuint padding[3];
+  };
+
+  OcclusionCuller::OcclusionCuller()
+    : pyramidID(0)
+    , pyramidSize(0)
+    , numLevels(0)
+    , numDraws(0)
+    , capacity(0)
+    , paramBuffer(sizeof(CullParams), BufferType::Dynamic)
+    , pyramidShader("./assets/shaders/compute/hiZBuild.cs")
+    , cullShader("./assets/shaders/compute/occlusionCull.cs")
+  {
+    // The gbuffer depth compares against a reference by default, this samples
+    // the raw depth instead.
+    glGenSamplers(1, &this->depthSampler);
+    glSamplerParameteri(this->depthSampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glSamplerParameteri(this->depthSampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glSamplerParameteri(this->depthSampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glSamplerParameteri(this->depthSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(this->depthSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+
+  OcclusionCuller::~OcclusionCuller()
+  {
+    if (this->pyramidID != 0)
+      glDeleteTextures(1, &this->pyramidID);
+    glDeleteSamplers(1, &this->depthSampler);
+  }
+
+  void
+  OcclusionCuller::setDraws(const std::vector<std::pair<glm::vec3, glm::vec3>> &bounds,
+                            const std::vector<GLuint> &indexCounts,
+                            const std::vector<GLuint> &baseInstances)
+  {
+    GLuint newNumDraws = indexCounts.size();
+    bool resetVisibility = newNumDraws != this->numDraws;
+    this->numDraws = newNumDraws;
+    if (this->numDraws == 0)
+      return;
+
+    if (this->numDraws > this->capacity)
+    {
+      this->capacity = std::max(this->numDraws, 2 * this->capacity);
+      this->boundsBuffer = createUnique<ShaderStorageBuffer>(this->capacity * 2 * sizeof(glm::vec4),
+                                                             BufferType::Dynamic);
+      this->commandBuffer = createUnique<ShaderStorageBuffer>(this->capacity * sizeof(DrawElementsCommand),
+                                                              BufferType::Dynamic);
+      this->visibilityBuffer = createUnique<ShaderStorageBuffer>(this->capacity * sizeof(GLuint),
+                                                                 BufferType::Dynamic);
+      resetVisibility = true;
+    }
+
+    std::vector<glm::vec4> boundsData;
+    boundsData.reserve(2 * this->numDraws);
+    for (auto& pair : bounds)
+    {
+      boundsData.emplace_back(pair.first, 1.0f);
+      boundsData.emplace_back(pair.second, 1.0f);
+    }
+    this->boundsBuffer->setData(0, boundsData.size() * sizeof(glm::vec4), boundsData.data());
+
+    std::vector<DrawElementsCommand> commands(this->numDraws);
+    for (GLuint i = 0; i < this->numDraws; i++)
+      commands[i] = { indexCounts[i], 0, 0, 0, baseInstances[i] };
+    this->commandBuffer->setData(0, commands.size() * sizeof(DrawElementsCommand),
+                                 commands.data());
+
+    // Without a matching history everything is drawn in the first phase.
+    if (resetVisibility)
+    {
+      std::vector<GLuint> visibility(this->numDraws, 1);
+      this->visibilityBuffer->setData(0, visibility.size() * sizeof(GLuint),
+                                      visibility.data());
+    }
+  }
+
+  void
+  OcclusionCuller::cullFirstPhase()
+  {
+    if (this->numDraws == 0)
+      return;
+
+    this->dispatchCull(0, glm::mat4(1.0f));
+  }
+
+  void
+  OcclusionCuller::cullSecondPhase(GLuint depthID, const glm::vec2 &depthSize,
+                                   const glm::mat4 &viewProj)
+  {
+    if (this->numDraws == 0)
+      return;
+
+    this->timer.begin();
+    this->buildPyramid(depthID, depthSize);
+    this->dispatchCull(1, viewProj);
+    this->timer.end();
+  }
+
+  void
+  OcclusionCuller::bindCommands()
+  {
+    if (this->commandBuffer)
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->commandBuffer->getID());
+  }
+
+  void
+  OcclusionCuller::buildPyramid(GLuint depthID, const glm::vec2 &depthSize)
+  {
+    glm::uvec2 size = glm::uvec2(depthSize);
+    if (size != this->pyramidSize)
+    {
+      if (this->pyramidID != 0)
+        glDeleteTextures(1, &this->pyramidID);
+
+      this->pyramidSize = size;
+      this->numLevels = (GLuint) std::floor(std::log2(std::max(size.x, size.y))) + 1;
+
+      glGenTextures(1, &this->pyramidID);
+      glBindTexture(GL_TEXTURE_2D, this->pyramidID);
+      glTexStorage2D(GL_TEXTURE_2D, this->numLevels, GL_RG32F, size.x, size.y);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    ShaderStorageBuffer levelParams = ShaderStorageBuffer(sizeof(PyramidParams),
+                                                          BufferType::Dynamic);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthID);
+    glBindSampler(0, this->depthSampler);
+
+    glm::ivec2 inputSize = glm::ivec2(size);
+    for (GLuint i = 0; i < this->numLevels; i++)
+    {
+      glm::ivec2 outputSize = i == 0 ? inputSize : glm::max(inputSize / 2, glm::ivec2(1));
+
+      PyramidParams params;
+      params.inputSize = inputSize;
+      params.outputSize = outputSize;
+      params.firstLevel = i == 0 ? 1 : 0;
+      levelParams.setData(0, sizeof(PyramidParams), &params);
+      levelParams.bindToPoint(2);
+
+      if (i > 0)
+        glBindImageTexture(0, this->pyramidID, i - 1, GL_FALSE, 0, GL_READ_ONLY, GL_RG32F);
+      glBindImageTexture(1, this->pyramidID, i, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+
+      this->pyramidShader.launchCompute(glm::ivec3((outputSize.x + 7) / 8,
+                                                   (outputSize.y + 7) / 8, 1));
+      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+      inputSize = outputSize;
+    }
+
+    glBindSampler(0, 0);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  }
+
+  void
+  OcclusionCuller::dispatchCull(GLuint phase, const glm::mat4 &viewProj)
+  {
+    CullParams params;
+    params.viewProj = viewProj;
+    params.pyramidSize = glm::vec2(this->pyramidSize);
+    params.numDraws = this->numDraws;
+    params.phase = phase;
+    params.numLevels = this->numLevels;
+    this->paramBuffer.setData(0, sizeof(CullParams), &params);
+
+    this->paramBuffer.bindToPoint(2);
+    this->boundsBuffer->bindToPoint(3);
+    this->commandBuffer->bindToPoint(4);
+    this->visibilityBuffer->bindToPoint(5);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, this->pyramidID);
+
+    this->cullShader.launchCompute(glm::ivec3((this->numDraws + 63) / 64, 1, 1));
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+}
@@ -0,0 +1,306 @@
+#include "Graphics/ReflectionProbes.h"
+
+// Project includes.
+#include "Graphics/EnvironmentMap.h"
+
+// STL includes.
+#include <unordered_set>
+
+namespace SciRenderer
+{
+  // The view frustum is split into 16x9 tiles and 24 exponential depth slices.
+  static const glm::uvec3 clusterDims = glm::uvec3(16, 9, 24);
+  static const GLuint numClusters = clusterDims.x * clusterDims.y * clusterDims.z;
+
+  ReflectionProbes::ReflectionProbes(const GLuint &probeSize)
+    : probeSize(probeSize)
+    , numMips(getNumPrefilterMips(probeSize))
+    , filterShader("./assets/shaders/compute/specPrefilter.cs")
+    , clusterGrid(clusterDims)
+    , numBaked(0)
+    , probeBuffer(MAX_REFLECTION_PROBES * sizeof(GPUProbe), BufferType::Dynamic)
+    , clusterBuffer(numClusters * sizeof(glm::uvec2), BufferType::Dynamic)
+    , indexBuffer(numClusters * MAX_PROBES_PER_CLUSTER * sizeof(GLuint), BufferType::Dynamic)
+  {
+    // The prefiltered probes, six layers per probe.
+    glGenTextures(1, &this->probeArrayID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, this->probeArrayID);
+    glTexStorage3D(GL_TEXTURE_CUBE_MAP_ARRAY, this->numMips, GL_RGBA16F, probeSize,
+                   probeSize, 6 * MAX_REFLECTION_PROBES);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+
+    // The capture target. It needs a full mip chain so the prefilter can read
+    // samples from the matching mip.
+    this->capture = createUnique<CubeMap>();
+    for (unsigned i = 0; i < 6; i++)
+    {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA16F, probeSize,
+                   probeSize, 0, GL_RGBA, GL_FLOAT, nullptr);
+      this->capture->width[i]  = probeSize;
+      this->capture->height[i] = probeSize;
+      this->capture->n[i]      = 3;
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+    this->filtered = createPrefilterMap(probeSize, probeSize, this->numMips);
+
+    glGenRenderbuffers(1, &this->captureDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->captureDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, probeSize, probeSize);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &this->captureFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->captureFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+                              this->captureDepth);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Hand out the low layers first.
+    for (GLuint i = MAX_REFLECTION_PROBES; i > 0; i--)
+      this->freeLayers.push_back(i - 1);
+  }
+
+  ReflectionProbes::~ReflectionProbes()
+  {
+    glDeleteTextures(1, &this->probeArrayID);
+    glDeleteFramebuffers(1, &this->captureFBO);
+    glDeleteRenderbuffers(1, &this->captureDepth);
+  }
+
+  void
+  ReflectionProbes::submit(const ReflectionProbe &probe)
+  {
+    this->frameProbes.push_back(probe);
+  }
+
+  bool
+  ReflectionProbes::update(ReflectionProbe &outDirtyProbe)
+  {
+    std::unordered_set<GLuint> submitted;
+    for (auto& probe : this->frameProbes)
+    {
+      submitted.insert(probe.id);
+
+      auto loc = this->slots.find(probe.id);
+      if (loc == this->slots.end())
+      {
+        // Probes past the size of the array are left out.
+        if (this->freeLayers.empty())
+          continue;
+
+        this->slots[probe.id] = { this->freeLayers.back(), probe.position, false, true };
+        this->freeLayers.pop_back();
+      }
+      else if (probe.dirty || loc->second.bakedPosition != probe.position)
+        loc->second.dirty = true;
+    }
+
+    // Free the slots of probes which were removed.
+    for (auto it = this->slots.begin(); it != this->slots.end();)
+    {
+      if (submitted.find(it->first) == submitted.end())
+      {
+        this->freeLayers.push_back(it->second.layer);
+        it = this->slots.erase(it);
+      }
+      else
+        ++it;
+    }
+
+    for (auto& probe : this->frameProbes)
+    {
+      auto loc = this->slots.find(probe.id);
+      if (loc != this->slots.end() && loc->second.dirty)
+      {
+        outDirtyProbe = probe;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void
+  ReflectionProbes::markAllDirty()
+  {
+    for (auto& pair : this->slots)
+      pair.second.dirty = true;
+  }
+
+  void
+  ReflectionProbes::bindCaptureFace(GLuint face)
+  {
+    glBindFramebuffer(GL_FRAMEBUFFER, this->captureFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                           this->capture->getID(), 0);
+    glViewport(0, 0, this->probeSize, this->probeSize);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  }
+
+  void
+  ReflectionProbes::endCapture(const ReflectionProbe &probe, GLuint sampleCount)
+  {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    auto loc = this->slots.find(probe.id);
+    if (loc == this->slots.end())
+      return;
+
+    this->capture->bind();
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+    dispatchPrefilter(this->filterShader, this->capture.get(), this->filtered.get(),
+                      this->numMips, sampleCount, true);
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    // Copy every level into the probe's six layers of the array.
+    for (GLuint level = 0; level < this->numMips; level++)
+    {
+      GLuint mipSize = std::max(this->probeSize >> level, 1u);
+      glCopyImageSubData(this->filtered->getID(), GL_TEXTURE_CUBE_MAP, level, 0, 0, 0,
+                         this->probeArrayID, GL_TEXTURE_CUBE_MAP_ARRAY, level, 0, 0,
+                         6 * loc->second.layer, mipSize, mipSize, 6);
+    }
+
+    loc->second.bakedPosition = probe.position;
+    loc->second.baked = true;
+    loc->second.dirty = false;
+  }
+
+  void
+  ReflectionProbes::buildClusters(Shared<Camera> camera)
+  {
+    // The baked probes, smallest volumes first so they take priority over
+    // the probes they're nested in.
+    struct VisibleProbe
+    {
+      GPUProbe data;
+      glm::vec3 viewCenter;
+      GLfloat radius;
+      GLfloat volume;
+    };
+    std::vector<VisibleProbe> visible;
+
+    glm::mat4 view = camera->getViewMatrix();
+    for (auto& probe : this->frameProbes)
+    {
+      auto loc = this->slots.find(probe.id);
+      if (loc == this->slots.end() || !loc->second.baked)
+        continue;
+
+      VisibleProbe visibleProbe;
+      visibleProbe.data.position = glm::vec4(probe.position, (GLfloat) probe.shape);
+      visibleProbe.data.extents = glm::vec4(probe.extents, std::max(probe.blendDistance, 0.001f));
+      visibleProbe.data.info = glm::uvec4(loc->second.layer, 0, 0, 0);
+      visibleProbe.viewCenter = glm::vec3(view * glm::vec4(probe.position, 1.0f));
+      if (probe.shape == ProbeShape::Sphere)
+      {
+        visibleProbe.radius = probe.extents.x;
+        visibleProbe.volume = 4.0f / 3.0f * M_PI * std::pow(probe.extents.x, 3.0f);
+      }
+      else
+      {
+        visibleProbe.radius = glm::length(probe.extents);
+        visibleProbe.volume = 8.0f * probe.extents.x * probe.extents.y * probe.extents.z;
+      }
+      visible.push_back(visibleProbe);
+    }
+    this->frameProbes.clear();
+
+    std::sort(visible.begin(), visible.end(), [](const VisibleProbe &a, const VisibleProbe &b)
+    {
+      return a.volume < b.volume;
+    });
+
+    this->numBaked = visible.size();
+    if (visible.empty())
+      return;
+
+    std::vector<GPUProbe> probeData;
+    for (auto& probe : visible)
+      probeData.push_back(probe.data);
+    this->probeBuffer.setData(0, probeData.size() * sizeof(GPUProbe), probeData.data());
+
+    // Corners of the tiles on the near plane, in view space.
+    glm::mat4 invProj = glm::inverse(camera->getProjMatrix());
+    const GLfloat near = camera->getNear();
+    const GLfloat far = camera->getFar();
+    auto unproject = [&invProj](GLfloat x, GLfloat y)
+    {
+      glm::vec4 point = invProj * glm::vec4(x, y, -1.0f, 1.0f);
+      return glm::vec3(point) / point.w;
+    };
+
+    std::vector<glm::uvec2> clusters(numClusters, glm::uvec2(0));
+    std::vector<GLuint> indices;
+    for (GLuint z = 0; z < clusterDims.z; z++)
+    {
+      GLfloat sliceNear = near * std::pow(far / near, (GLfloat) z / (GLfloat) clusterDims.z);
+      GLfloat sliceFar = near * std::pow(far / near, (GLfloat) (z + 1) / (GLfloat) clusterDims.z);
+
+      for (GLuint y = 0; y < clusterDims.y; y++)
+      {
+        for (GLuint x = 0; x < clusterDims.x; x++)
+        {
+          glm::vec3 tileMin = unproject(2.0f * x / clusterDims.x - 1.0f,
+                                        2.0f * y / clusterDims.y - 1.0f);
+          glm::vec3 tileMax = unproject(2.0f * (x + 1) / clusterDims.x - 1.0f,
+                                        2.0f * (y + 1) / clusterDims.y - 1.0f);
+
+          // Points on the near plane scale out along their view rays.
+          glm::vec3 corners[4] = { tileMin * (sliceNear / near), tileMax * (sliceNear / near),
+                                   tileMin * (sliceFar / near), tileMax * (sliceFar / near) };
+          glm::vec3 minPos = corners[0];
+          glm::vec3 maxPos = corners[0];
+          for (unsigned i = 1; i < 4; i++)
+          {
+            minPos = glm::min(minPos, corners[i]);
+            maxPos = glm::max(maxPos, corners[i]);
+          }
+
+          GLuint offset = indices.size();
+          GLuint count = 0;
+          for (GLuint i = 0; i < visible.size() && count < MAX_PROBES_PER_CLUSTER; i++)
+          {
+            glm::vec3 closest = glm::clamp(visible[i].viewCenter, minPos, maxPos);
+            glm::vec3 toCenter = closest - visible[i].viewCenter;
+            if (glm::dot(toCenter, toCenter) > visible[i].radius * visible[i].radius)
+              continue;
+
+            indices.push_back(i);
+            count++;
+          }
+
+          clusters[x + clusterDims.x * (y + clusterDims.y * z)] = glm::uvec2(offset, count);
+        }
+      }
+    }
+
+    this->clusterBuffer.setData(0, clusters.size() * sizeof(glm::uvec2), clusters.data());
+    if (!indices.empty())
+      this->indexBuffer.setData(0, indices.size() * sizeof(GLuint), indices.data());
+  }
+
+  void
+  ReflectionProbes::bind(GLuint textureUnit)
+  {
+    this->probeBuffer.bindToPoint(5);
+    this->clusterBuffer.bindToPoint(6);
+    this->indexBuffer.bindToPoint(7);
+
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, this->probeArrayID);
+  }
+}
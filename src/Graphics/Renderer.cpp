@@ -2,6 +2,7 @@
 
 // Project includes.
 #include "Core/AssetManager.h"
+#include "Graphics/TextureStreamer.h"
 
 namespace SciRenderer
 {
@@ -11,13 +12,26 @@ namespace SciRenderer
   namespace Renderer3D
   {
     // Forward declaration for passes.
+    void gatherDraws(std::vector<GeometryDraw> &draws);
+    void updateInstances(std::vector<GeometryDraw> &draws);
     void geometryPass();
+    void forwardPass();
+    void queueProxy(Model* data, const glm::mat4 &transform, GLfloat id,
+                    bool drawSelectionMask, std::vector<GeometryDraw> &draws);
+    void requestTextureMips(Material* material, const glm::vec3 &min,
+                            const glm::vec3 &max);
+    void probePass();
     void shadowPass();
+    void aoPass();
     void lightingPass();
+    void transparencyPass();
+    void taaPass();
+    void bindSceneColour(GLuint textureUnit);
     void postProcessPass(Shared<FrameBuffer> frontBuffer);
 
     // Draw the data given, forward rendering style.
     void draw(VertexArray* data, Shader* program);
+    void drawInstance(VertexArray* data, Shader* program, GLuint instance);
     void drawEnvironment();
 
     RendererStorage* storage;
@@ -78,6 +92,11 @@ namespace SciRenderer
 
       storage->width = width;
       storage->height = height;
+      storage->renderScale = 1.0f;
+      storage->renderWidth = width;
+      storage->renderHeight = height;
+      std::fill(storage->scaleHistory, storage->scaleHistory + RENDER_SCALE_HISTORY, 1.0f);
+      storage->scaleHistoryOffset = 0;
 
       storage->gBuffer.resize(width, height);
 
@@ -90,20 +109,44 @@ namespace SciRenderer
       // Shaders for the various passes.
       storage->shadowShader = shaderCache->getAsset("shadow_shader");
       storage->geometryShader = shaderCache->getAsset("geometry_pass_shader");
+      storage->depthPrePassShader = shaderCache->getAsset("depth_prepass_shader");
       storage->ambientShader = shaderCache->getAsset("deferred_ambient");
-      storage->directionalShaderShadowed = shaderCache->getAsset("deferred_directional_shadowed");
       storage->directionalShader = shaderCache->getAsset("deferred_directional");
+      storage->directionalShaderShadowed = storage->directionalShader->getVariant({ { "SHADOWED", "" } });
       storage->horBlur = shaderCache->getAsset("post_hor_gaussian_blur");
       storage->verBlur = shaderCache->getAsset("post_ver_gaussian_blur");
       storage->hdrPostShader = shaderCache->getAsset("post_hdr");
       storage->outlineShader = shaderCache->getAsset("post_entity_outline");
       storage->gridShader = shaderCache->getAsset("post_grid");
+      storage->probeCaptureShader = shaderCache->getAsset("probe_capture");
+      storage->transparentShader = shaderCache->getAsset("transparent_shader");
+      storage->oitCompositeShader = shaderCache->getAsset("oit_composite");
+      storage->forwardPlusShader = shaderCache->getAsset("forward_plus");
+
+      storage->reflectionProbes = createUnique<ReflectionProbes>();
+      storage->ambientOcclusion = createUnique<AmbientOcclusion>(width, height);
+      storage->temporalAA = createUnique<TemporalAA>(width, height);
+      storage->autoExposure = createUnique<AutoExposure>();
+      storage->bloom = createUnique<Bloom>(width, height);
+      storage->transparency = createUnique<Transparency>(width, height);
+      storage->forwardPlus = createUnique<ForwardPlus>(width, height, state->msaaSamples);
+      storage->instances = createUnique<InstanceBuffer>();
+      storage->prevViewProj = glm::mat4(1.0f);
+      storage->occlusionCuller = createUnique<OcclusionCuller>();
+
+      // Flat grey material for streaming proxies.
+      storage->proxyMaterial = createUnique<Material>(MaterialType::PBR);
+      storage->proxyMaterial->getVec3("uAlbedo") = glm::vec3(0.5f);
+      storage->proxyMaterial->getFloat("uRoughness") = 1.0f;
     }
 
     // Shutdown the renderer.
     void
     shutdown()
     {
+      // The upload ring is mapped, it has to go before the context does.
+      Texture2D::shutdownUploads();
+
       delete storage;
       delete state;
       delete stats;
@@ -114,6 +157,47 @@ namespace SciRenderer
     RendererState* getState() { return state; }
     RendererStats* getStats() { return stats; }
 
+    glm::uvec2
+    getRenderSize()
+    {
+      return glm::uvec2(storage->renderWidth, storage->renderHeight);
+    }
+
+    // Pick the render resolution of this frame from the GPU time of the last
+    // frames. Most of the cost is per pixel, so the scale moves with the square
+    // root of the time ratio. The buffers are allocated at full resolution and
+    // only a corner of them is rendered to, changing the scale never
+    // reallocates them.
+    static void
+    updateRenderScale()
+    {
+      GLfloat scale = 1.0f;
+      if (state->dynamicResolution && !storage->isForward)
+      {
+        scale = storage->renderScale;
+        GLfloat frameTime = storage->frameTimer.getTime();
+        if (frameTime > 0.0f)
+        {
+          // The timer results are a few frames late, only move part of the
+          // way there so the scale doesn't oscillate.
+          GLfloat target = scale * std::sqrt(state->targetFrameTime / frameTime);
+          scale += 0.1f * (target - scale);
+        }
+        scale = std::clamp(scale, 0.5f, 1.0f);
+      }
+      storage->renderScale = scale;
+
+      // Snap to multiples of 8 pixels, so small changes in the scale don't
+      // change the size every frame.
+      GLuint renderWidth = ((GLuint) (scale * storage->width) + 4) / 8 * 8;
+      GLuint renderHeight = ((GLuint) (scale * storage->height) + 4) / 8 * 8;
+      storage->renderWidth = std::clamp(renderWidth, 1u, storage->width);
+      storage->renderHeight = std::clamp(renderHeight, 1u, storage->height);
+
+      storage->scaleHistory[storage->scaleHistoryOffset] = scale;
+      storage->scaleHistoryOffset = (storage->scaleHistoryOffset + 1) % RENDER_SCALE_HISTORY;
+    }
+
     // Generic begin and end for the renderer.
     void
     begin(GLuint width, GLuint height, Shared<Camera> sceneCam, bool isForward)
@@ -124,14 +208,30 @@ namespace SciRenderer
       // Resize the framebuffer at the start of a frame, if required.
       storage->isForward = isForward;
       storage->drawEdge = false;
+      storage->captureQueue.clear();
 
       if (storage->width != width || storage->height != height)
       {
         storage->gBuffer.resize(width, height);
         storage->lightingPass.resize(width, height);
+        storage->ambientOcclusion->resize(width, height);
+        storage->temporalAA->resize(width, height);
+        storage->bloom->resize(width, height);
+        storage->transparency->resize(width, height);
         storage->width = width;
         storage->height = height;
       }
+      updateRenderScale();
+
+      // Jitter the scene geometry for temporal anti-aliasing. The forward
+      // renderer has no velocity buffer to resolve with.
+      if (state->temporalAA && !isForward)
+        sceneCam->setJitter(storage->temporalAA->nextJitter(getRenderSize()));
+      else
+      {
+        sceneCam->setJitter(glm::vec2(0.0f));
+        storage->temporalAA->resetHistory();
+      }
 
       // Reset the stats each frame.
       stats->drawCalls = 0;
@@ -141,20 +241,12 @@ namespace SciRenderer
       stats->numPointLights = 0;
       stats->numSpotLights = 0;
 
+      // The multisampled targets only follow the size in the forward path.
       if (isForward)
-      {
-        storage->lightingPass.clear();
-        storage->lightingPass.bind();
-        storage->lightingPass.setViewport();
+        storage->forwardPlus->resize(width, height, state->msaaSamples);
 
-        storage->currentEnvironment->bind(MapType::Irradiance, 0);
-        storage->currentEnvironment->bind(MapType::Prefilter, 1);
-        storage->currentEnvironment->bind(MapType::Integration, 2);
-      }
-      else
-      {
-        storage->renderQueue.clear();
-      }
+      storage->renderQueue.clear();
+      storage->transparentQueue.clear();
     }
 
     void
@@ -162,18 +254,48 @@ namespace SciRenderer
     {
       if (storage->isForward)
       {
-        drawEnvironment();
-        storage->lightingPass.unbind();
+        storage->frameTimer.begin();
+
+        forwardPass();
+
+        transparencyPass();
+
+        // The lights are used by the forward and transparency passes, the
+        // shadows are only drawn in the deferred path.
+        storage->directionalQueue.clear();
+        storage->pointQueue.clear();
+        storage->spotQueue.clear();
+        storage->shadowQueue.clear();
+
+        postProcessPass(frontBuffer);
+
+        storage->frameTimer.end();
       }
       else
       {
+        storage->frameTimer.begin();
+
+        probePass();
+
         geometryPass();
 
         shadowPass();
 
+        aoPass();
+
         lightingPass();
 
+        transparencyPass();
+
+        // The directional lights are used by the lighting and transparency
+        // passes.
+        storage->directionalQueue.clear();
+
+        taaPass();
+
         postProcessPass(frontBuffer);
+
+        storage->frameTimer.end();
       }
     }
 
@@ -190,6 +312,21 @@ namespace SciRenderer
       program->unbind();
     }
 
+    // Draw a submesh which reads its transforms from a slot of the instance
+    // buffer.
+    void
+    drawInstance(VertexArray* data, Shader* program, GLuint instance)
+    {
+      data->bind();
+      program->bind();
+
+      RendererCommands::drawPrimativesBaseInstance(PrimativeType::Triangle,
+                                                   data->numToRender(), instance);
+
+      data->unbind();
+      program->unbind();
+    }
+
     // Draw an environment map to the screen. Draws all the submeshes associated
     // with the cube model.
     void
@@ -220,6 +357,7 @@ namespace SciRenderer
         storage->renderQueue.emplace_back(data, &materials, model, id, drawSelectionMask);
 
       storage->shadowQueue.emplace_back(data, model);
+      storage->captureQueue.emplace_back(data, &materials, model);
     }
 
     void
@@ -253,16 +391,186 @@ namespace SciRenderer
       stats->numSpotLights++;
     }
 
+    void
+    submit(ReflectionProbe probe, const glm::mat4 &model)
+    {
+      // Probes are only blended in the deferred ambient pass.
+      if (storage->isForward)
+        return;
+
+      ReflectionProbe temp = probe;
+      temp.position = glm::vec3(model * glm::vec4(probe.position, 1.0f));
+
+      storage->reflectionProbes->submit(temp);
+    }
+
     //--------------------------------------------------------------------------
     // Deferred geometry pass.
     //--------------------------------------------------------------------------
-    void geometryPass()
+    // Upload the material of a submesh to the permutation of a program for its
+    // maps. Untextured materials draw with a permutation which skips the
+    // fetches. The transforms are in the instance buffer. Returns the
+    // permutation to draw with.
+    static Shader*
+    configureDraw(const GeometryDraw &draw, Shader* baseProgram)
     {
-      storage->gBuffer.beginGeoPass();
+      Material* material = draw.material;
+      material->getVec3("camera.position") = storage->sceneCam->getCamPos();
+
+      return material->configureVariant(baseProgram);
+    }
+
+    // Upload the environment intensity and the first four directional lights
+    // to a program which shades forward.
+    static void
+    setForwardLights(Shader* program)
+    {
+      program->addUniformFloat("intensity", storage->currentEnvironment->getIntensity());
+
+      GLuint numDirLights = 0;
+      for (auto& light : storage->directionalQueue)
+      {
+        if (numDirLights == 4)
+          break;
+
+        std::string index = "[" + std::to_string(numDirLights) + "]";
+        program->addUniformVector(("lDirection" + index).c_str(), light.direction);
+        program->addUniformVector(("lColour" + index).c_str(), light.colour);
+        program->addUniformFloat(("lIntensity" + index).c_str(), light.intensity);
+        numDirLights++;
+      }
+      program->addUniformUInt("numDirLights", numDirLights);
+    }
+
+    // Draw a submesh into the gbuffer. Uses the indirect command of the draw
+    // when it's given one.
+    static void
+    drawGeometry(const GeometryDraw &draw, GLint commandIndex = -1)
+    {
+      Shader* program = configureDraw(draw, storage->geometryShader);
+
+      VertexArray* vao = draw.submesh->getVAO();
+      if (commandIndex < 0)
+      {
+        drawInstance(vao, program, draw.instance);
+        return;
+      }
+
+      vao->bind();
+      program->bind();
+      RendererCommands::drawPrimativesIndirect(PrimativeType::Triangle,
+                                               commandIndex * sizeof(DrawElementsCommand));
+      vao->unbind();
+      program->unbind();
+    }
+
+    // Draw the depth of a submesh from its position only stream.
+    static void
+    drawDepth(const GeometryDraw &draw, GLint commandIndex = -1)
+    {
+      Shader* program = storage->depthPrePassShader;
+
+      VertexArray* vao = draw.submesh->getPositionVAO();
+      if (commandIndex < 0)
+      {
+        drawInstance(vao, program, draw.instance);
+        return;
+      }
+
+      vao->bind();
+      program->bind();
+      RendererCommands::drawPrimativesIndirect(PrimativeType::Triangle,
+                                               commandIndex * sizeof(DrawElementsCommand));
+      vao->unbind();
+      program->unbind();
+    }
+
+    // Draw the queued submeshes, with the depth pre-pass and occlusion culling
+    // if they're enabled.
+    static void
+    drawGeometryQueue(std::vector<GeometryDraw> &draws)
+    {
+      // Draw with the pre-pass shader or the gbuffer shader. Pre-pass draws
+      // only write depth, the gbuffer draws after a pre-pass only shade the
+      // fragments which are visible.
+      auto drawAll = [&draws](bool depthOnly, bool indirect)
+      {
+        for (GLuint i = 0; i < draws.size(); i++)
+        {
+          GLint commandIndex = indirect ? (GLint) i : -1;
+          if (depthOnly)
+            drawDepth(draws[i], commandIndex);
+          else
+            drawGeometry(draws[i], commandIndex);
+        }
+      };
+
+      if (state->depthPrePass)
+        RendererCommands::disableColourMask();
+
+      if (!state->occlusionCull)
+        drawAll(state->depthPrePass, false);
+      else
+      {
+        std::vector<std::pair<glm::vec3, glm::vec3>> bounds;
+        std::vector<GLuint> indexCounts;
+        std::vector<GLuint> baseInstances;
+        for (auto& draw : draws)
+        {
+          bounds.emplace_back(draw.min, draw.max);
+          indexCounts.push_back(draw.submesh->getIndices().size());
+          baseInstances.push_back(draw.instance);
+        }
+
+        // First phase, the draws visible last frame.
+        storage->occlusionCuller->setDraws(bounds, indexCounts, baseInstances);
+        storage->occlusionCuller->cullFirstPhase();
+        storage->occlusionCuller->bindCommands();
+        drawAll(state->depthPrePass, true);
+
+        // Second phase, the draws which aren't hidden behind the first.
+        glm::mat4 viewProj = storage->sceneCam->getProjMatrix() * storage->sceneCam->getViewMatrix();
+        storage->occlusionCuller->cullSecondPhase(storage->gBuffer.getAttachmentID(FBOTargetParam::Depth),
+                                                  glm::vec2(getRenderSize()), viewProj);
+        storage->occlusionCuller->bindCommands();
+        drawAll(state->depthPrePass, true);
+      }
+
+      if (state->depthPrePass)
+      {
+        RendererCommands::enableColourMask();
+        RendererCommands::disableDepthMask();
+        RendererCommands::depthFunction(DepthFunctions::Equal);
+
+        // Re-enable every draw which is visible after both phases.
+        if (state->occlusionCull)
+        {
+          storage->occlusionCuller->cullFirstPhase();
+          storage->occlusionCuller->bindCommands();
+        }
+        drawAll(false, state->occlusionCull);
+
+        RendererCommands::depthFunction(DepthFunctions::Less);
+        RendererCommands::enableDepthMask();
+      }
 
+      if (state->occlusionCull)
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // Gather the submeshes which survive frustum culling. Transparent
+    // submeshes go to the transparency pass instead.
+    void
+    gatherDraws(std::vector<GeometryDraw> &draws)
+    {
       for (auto& drawable : storage->renderQueue)
       {
         auto& [data, materials, transform, id, drawSelectionMask] = drawable;
+
+        // Draw a bounding box proxy while the model is streaming in.
+        if (!data->isLoaded())
+          queueProxy(data, transform, id, drawSelectionMask, draws);
+
         for (auto& pair : data->getSubmeshes())
         {
           // Cull the submesh if it isn't in the frustum.
@@ -280,40 +588,272 @@ namespace SciRenderer
             material = materials->getMaterial(pair.first);
           }
 
-          Shader* program = storage->geometryShader;
+          requestTextureMips(material, min, max);
 
-          material->getVec3("camera.position") = storage->sceneCam->getCamPos();
-          material->getMat3("normalMat") = glm::transpose(glm::inverse(glm::mat3(transform)));
-          material->getMat4("model") = transform;
-          material->getMat4("mVP") = storage->sceneCam->getProjMatrix() * storage->sceneCam->getViewMatrix() * transform;
-          material->getFloat("uID") = id + 1.0f;
-          if (drawSelectionMask)
+          if (!pair.second->hasVAO())
           {
-            // Enable edge detection for selected mesh outlines.
-            storage->drawEdge = true;
-            material->getVec3("uMaskColour") = glm::vec3(1.0f);
+            pair.second->generateVAO();
+            if (!pair.second->hasVAO())
+              continue;
           }
-          else
-            material->getVec3("uMaskColour") = glm::vec3(0.0f);
 
-          material->configure(program);
+          // Enable edge detection for selected mesh outlines.
+          if (drawSelectionMask)
+            storage->drawEdge = true;
 
-          if (pair.second->hasVAO())
-            Renderer3D::draw(pair.second->getVAO(), program);
-          else
-          {
-            pair.second->generateVAO();
-            if (pair.second->hasVAO())
-              Renderer3D::draw(pair.second->getVAO(), program);
-          }
+          // The transformed corners aren't ordered under rotations.
+          auto& queue = material->isTransparent() ? storage->transparentQueue : draws;
+          queue.push_back({ pair.second.get(), material, transform, 0, id,
+                            drawSelectionMask, glm::min(min, max), glm::max(min, max) });
 
           stats->drawCalls++;
           stats->numVertices += pair.second->getData().size();
           stats->numTriangles += pair.second->getIndices().size() / 3;
         }
       }
+    }
+
+    // Point the draws of this frame, opaque and transparent, at their slots in
+    // the instance buffer and upload the slots which changed. Submeshes which
+    // weren't drawn last frame have no motion.
+    void
+    updateInstances(std::vector<GeometryDraw> &draws)
+    {
+      for (auto& draw : draws)
+      {
+        draw.instance = storage->instances->update(draw.id, draw.submesh, draw.transform,
+                                                   draw.drawSelectionMask);
+      }
+      for (auto& draw : storage->transparentQueue)
+      {
+        draw.instance = storage->instances->update(draw.id, draw.submesh, draw.transform,
+                                                   draw.drawSelectionMask);
+      }
+
+      glm::mat4 viewProj = storage->sceneCam->getProjMatrix() * storage->sceneCam->getViewMatrix();
+      storage->instances->setCamera(storage->sceneCam->getJitteredProjMatrix() * storage->sceneCam->getViewMatrix(),
+                                    viewProj, storage->prevViewProj);
+      storage->instances->flush();
+      storage->instances->bind();
+
+      storage->prevViewProj = viewProj;
+    }
+
+    void geometryPass()
+    {
+      storage->geometryTimer.begin();
+      storage->gBuffer.beginGeoPass();
+      RendererCommands::setViewport(glm::ivec2(getRenderSize()));
+
+      std::vector<GeometryDraw> draws;
+      gatherDraws(draws);
+      updateInstances(draws);
+
+      drawGeometryQueue(draws);
 
       storage->gBuffer.endGeoPass();
+      storage->geometryTimer.end();
+    }
+
+    //--------------------------------------------------------------------------
+    // Forward+ pass. A depth pre-pass, tiled light culling from its depth and
+    // a single shading pass of the visible fragments, multisampled.
+    //--------------------------------------------------------------------------
+    void
+    forwardPass()
+    {
+      storage->geometryTimer.begin();
+
+      std::vector<GeometryDraw> draws;
+      gatherDraws(draws);
+      updateInstances(draws);
+
+      glm::uvec2 renderSize = getRenderSize();
+      storage->forwardPlus->begin(renderSize);
+
+      // Depth pre-pass.
+      RendererCommands::disableColourMask();
+      for (auto& draw : draws)
+        drawDepth(draw);
+      RendererCommands::enableColourMask();
+
+      // List the point and spot lights of each tile.
+      std::vector<TiledLight> lights;
+      lights.reserve(storage->pointQueue.size() + storage->spotQueue.size());
+      for (auto& light : storage->pointQueue)
+      {
+        lights.push_back({ glm::vec4(light.position, light.radius),
+                           glm::vec4(light.colour, light.intensity),
+                           glm::vec4(0.0f), glm::vec4(0.0f) });
+      }
+      for (auto& light : storage->spotQueue)
+      {
+        lights.push_back({ glm::vec4(light.position, light.radius),
+                           glm::vec4(light.colour, light.intensity),
+                           glm::vec4(light.direction, 1.0f),
+                           glm::vec4(light.innerCutoff, light.outerCutoff, 0.0f, 0.0f) });
+      }
+      storage->forwardPlus->cullLights(storage->sceneCam, lights, renderSize);
+
+      // Shade the fragments which passed the pre-pass.
+      RendererCommands::disableDepthMask();
+      RendererCommands::depthFunction(DepthFunctions::Equal);
+
+      storage->currentEnvironment->bindIrradiance(4);
+      storage->currentEnvironment->bind(MapType::Prefilter, 1);
+      storage->currentEnvironment->bind(MapType::Integration, 2);
+      storage->forwardPlus->bindLights();
+
+      GLuint numTilesX = storage->forwardPlus->getNumTiles(renderSize).x;
+      for (auto& draw : draws)
+      {
+        // Lighting, these aren't material properties.
+        Shader* program = configureDraw(draw, storage->forwardPlusShader);
+        setForwardLights(program);
+        program->addUniformUInt("numTilesX", numTilesX);
+
+        drawInstance(draw.submesh->getVAO(), program, draw.instance);
+      }
+
+      RendererCommands::depthFunction(DepthFunctions::Less);
+      RendererCommands::enableDepthMask();
+
+      storage->forwardPlus->colourOnly();
+      drawEnvironment();
+      storage->forwardPlus->end();
+
+      storage->forwardPlus->resolve(storage->lightingPass, storage->gBuffer, renderSize);
+      storage->geometryTimer.end();
+    }
+
+    // Ask the texture streamer for the mips of the material's textures, based
+    // on how many pixels the submesh bounds cover on screen.
+    void
+    requestTextureMips(Material* material, const glm::vec3 &min, const glm::vec3 &max)
+    {
+      auto textureCache = AssetManager<Texture2D>::getManager();
+      auto streamer = TextureStreamer::getInstance();
+
+      glm::vec3 center = (min + max) / 2.0f;
+      GLfloat radius = glm::length(max - min) / 2.0f;
+      GLfloat distance = glm::length(center - storage->sceneCam->getCamPos()) - radius;
+      distance = std::max(distance, storage->sceneCam->getNear());
+
+      GLfloat tanHalfFOV = std::tan(glm::radians(storage->sceneCam->getHorFOV()) / 2.0f);
+      GLfloat screenSize = (radius / (distance * tanHalfFOV)) * (GLfloat) storage->renderHeight;
+
+      for (auto& pair : material->getSampler2Ds())
+      {
+        Texture2D* texture = textureCache->getAsset(pair.second);
+        if (texture && texture->isStreamed())
+          streamer->requestScreenSize(texture, screenSize);
+      }
+    }
+
+    // Queue a box covering the model's bounds for the gbuffer, using the cube
+    // of the environment map.
+    void
+    queueProxy(Model* data, const glm::mat4 &transform, GLfloat id,
+               bool drawSelectionMask, std::vector<GeometryDraw> &draws)
+    {
+      glm::vec3 center = (data->getMinPos() + data->getMaxPos()) / 2.0f;
+      glm::vec3 extents = data->getMaxPos() - data->getMinPos();
+      glm::mat4 proxyTransform = transform * glm::translate(center) * glm::scale(extents);
+
+      glm::vec3 min = glm::vec3(transform * glm::vec4(data->getMinPos(), 1.0f));
+      glm::vec3 max = glm::vec3(transform * glm::vec4(data->getMaxPos(), 1.0f));
+
+      if (drawSelectionMask)
+        storage->drawEdge = true;
+
+      for (auto& pair : storage->currentEnvironment->getCubeMesh()->getSubmeshes())
+      {
+        if (!pair.second->hasVAO())
+          pair.second->generateVAO();
+
+        // The proxy material is shared, it's configured right before drawing.
+        draws.push_back({ pair.second.get(), storage->proxyMaterial.get(), proxyTransform,
+                          0, (GLuint) id, drawSelectionMask,
+                          glm::min(min, max), glm::max(min, max) });
+
+        stats->drawCalls++;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    // Reflection probe pass. Captures the scene around a dirty probe and
+    // prefilters it into the probe array. At most one probe is baked per
+    // frame so moving probes around doesn't stall the editor.
+    //--------------------------------------------------------------------------
+    void
+    probePass()
+    {
+      ReflectionProbe probe;
+      if (!storage->reflectionProbes->update(probe))
+        return;
+
+      const glm::vec3 faceDirections[6] =
+      {
+        { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+        { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }
+      };
+      const glm::vec3 faceUps[6] =
+      {
+        { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },
+        { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }
+      };
+      glm::mat4 captureProj = glm::perspective(glm::radians(90.0f), 1.0f,
+                                               storage->sceneCam->getNear(),
+                                               storage->sceneCam->getFar());
+
+      // Diffuse lighting from the environment and the directional lights.
+      Shader* program = storage->probeCaptureShader;
+      storage->currentEnvironment->bindIrradiance(4);
+      setForwardLights(program);
+
+      Shader* skyboxProgram = storage->currentEnvironment->getCubeProg();
+      for (GLuint face = 0; face < 6; face++)
+      {
+        storage->reflectionProbes->bindCaptureFace(face);
+
+        glm::mat4 captureView = glm::lookAt(probe.position, probe.position + faceDirections[face],
+                                            faceUps[face]);
+        glm::mat4 captureVP = captureProj * captureView;
+
+        for (auto& drawable : storage->captureQueue)
+        {
+          auto& [data, materials, transform] = drawable;
+          for (auto& pair : data->getSubmeshes())
+          {
+            Material* material = materials->getMaterial(pair.first);
+            if (!material || !pair.second->hasVAO())
+              continue;
+
+            material->getMat3("normalMat") = glm::transpose(glm::inverse(glm::mat3(transform)));
+            material->getMat4("model") = transform;
+            material->getMat4("mVP") = captureVP * transform;
+            material->configure(program);
+
+            Renderer3D::draw(pair.second->getVAO(), program);
+            stats->drawCalls++;
+          }
+        }
+
+        // The skybox fills in everything behind the scene.
+        RendererCommands::depthFunction(DepthFunctions::LEq);
+        skyboxProgram->addUniformMatrix("vP", captureProj * glm::mat4(glm::mat3(captureView)), GL_FALSE);
+        skyboxProgram->addUniformSampler("skybox", 0);
+        skyboxProgram->addUniformFloat("roughness", 0.0f);
+        storage->currentEnvironment->bind(MapType::Skybox, 0);
+        for (auto& pair : storage->currentEnvironment->getCubeMesh()->getSubmeshes())
+        {
+          if (pair.second->hasVAO())
+            Renderer3D::draw(pair.second->getVAO(), skyboxProgram);
+        }
+        RendererCommands::depthFunction(DepthFunctions::Less);
+      }
+
+      storage->reflectionProbes->endCapture(probe, state->prefilterSamples);
     }
 
     //--------------------------------------------------------------------------
@@ -538,6 +1078,22 @@ namespace SciRenderer
       storage->shadowQueue.clear();
     }
 
+    //--------------------------------------------------------------------------
+    // Screen-space ambient occlusion pass, using the gbuffer positions and
+    // normals.
+    //--------------------------------------------------------------------------
+    void
+    aoPass()
+    {
+      if (state->aoMode == AOMode::Off)
+        return;
+
+      storage->gBuffer.bindAttachment(FBOTargetParam::Colour0, 3);
+      storage->gBuffer.bindAttachment(FBOTargetParam::Colour1, 4);
+      storage->ambientOcclusion->compute(storage->sceneCam, getRenderSize(),
+                                         state->aoMode, state->aoRadius, state->aoPower);
+    }
+
     //--------------------------------------------------------------------------
     // Deferred lighting pass.
     //--------------------------------------------------------------------------
@@ -547,13 +1103,13 @@ namespace SciRenderer
       RendererCommands::disable(RendererFunction::DepthTest);
       storage->lightingPass.clear();
       storage->lightingPass.bind();
-      storage->lightingPass.setViewport();
+      RendererCommands::setViewport(glm::ivec2(getRenderSize()));
 
       //------------------------------------------------------------------------
       // Ambient lighting subpass.
       //------------------------------------------------------------------------
       // Environment maps.
-      storage->currentEnvironment->bind(MapType::Irradiance, 0);
+      storage->currentEnvironment->bindIrradiance(4);
       storage->currentEnvironment->bind(MapType::Prefilter, 1);
       storage->currentEnvironment->bind(MapType::Integration, 2);
       // Gbuffer textures.
@@ -563,9 +1119,21 @@ namespace SciRenderer
       storage->gBuffer.bindAttachment(FBOTargetParam::Colour3, 6);
       // Screen size.
       storage->ambientShader->addUniformVector("screenSize", storage->lightingPass.getSize());
+      storage->ambientShader->addUniformVector("renderSize", glm::vec2(getRenderSize()));
       storage->ambientShader->addUniformFloat("intensity", storage->currentEnvironment->getIntensity());
       // Camera position.
       storage->ambientShader->addUniformVector("camera.position", storage->sceneCam->getCamPos());
+      // Reflection probes, listed per cluster.
+      storage->reflectionProbes->buildClusters(storage->sceneCam);
+      storage->reflectionProbes->bind(7);
+      storage->ambientShader->addUniformUInt("numProbes", storage->reflectionProbes->getNumBaked());
+      storage->ambientShader->addUniformVector("clusterGrid", glm::vec3(storage->reflectionProbes->getClusterGrid()));
+      storage->ambientShader->addUniformVector("clusterDepth", glm::vec2(storage->sceneCam->getNear(),
+                                                                         storage->sceneCam->getFar()));
+      storage->ambientShader->addUniformMatrix("cameraView", storage->sceneCam->getViewMatrix(), GL_FALSE);
+      // Scene ambient occlusion.
+      storage->ambientOcclusion->bind(8);
+      storage->ambientShader->addUniformUInt("useSceneAO", state->aoMode != AOMode::Off ? 1 : 0);
 
       draw(&storage->fsq, storage->ambientShader);
 
@@ -626,8 +1194,6 @@ namespace SciRenderer
         }
       }
 
-      storage->directionalQueue.clear();
-
       //------------------------------------------------------------------------
       // Point lighting subpass.
       //------------------------------------------------------------------------
@@ -649,6 +1215,89 @@ namespace SciRenderer
       storage->lightingPass.unbind();
     }
 
+    //--------------------------------------------------------------------------
+    // Transparency pass. Shades the transparent submeshes forward against the
+    // opaque depth and composites them over the lit scene, so the cost scales
+    // with the transparent pixels.
+    //--------------------------------------------------------------------------
+    void
+    transparencyPass()
+    {
+      storage->transparency->setMode(state->oitMode);
+      if (storage->transparentQueue.empty())
+        return;
+
+      storage->transparencyTimer.begin();
+      OITMode mode = state->oitMode;
+      storage->transparency->begin(mode, storage->gBuffer, getRenderSize());
+
+      // Environment maps.
+      storage->currentEnvironment->bindIrradiance(4);
+      storage->currentEnvironment->bind(MapType::Prefilter, 1);
+      storage->currentEnvironment->bind(MapType::Integration, 2);
+      storage->instances->bind();
+
+      Shader* baseProgram = storage->transparentShader;
+      if (mode == OITMode::LinkedList)
+        baseProgram = baseProgram->getVariant({ { "LINKED_LIST", "" } });
+
+      for (auto& draw : storage->transparentQueue)
+      {
+        // Lighting, these aren't material properties.
+        Shader* program = configureDraw(draw, baseProgram);
+        setForwardLights(program);
+
+        drawInstance(draw.submesh->getVAO(), program, draw.instance);
+      }
+
+      storage->transparency->end(mode);
+
+      // Composite over the lit scene.
+      Shader* compositeProgram = storage->oitCompositeShader;
+      if (mode == OITMode::LinkedList)
+        compositeProgram = compositeProgram->getVariant({ { "LINKED_LIST", "" } });
+
+      storage->lightingPass.bind();
+      RendererCommands::setViewport(glm::ivec2(getRenderSize()));
+      RendererCommands::disable(RendererFunction::DepthTest);
+      Transparency::setCompositeBlending();
+      storage->transparency->bindResults(mode);
+
+      draw(&storage->fsq, compositeProgram);
+
+      RendererCommands::disable(RendererFunction::Blending);
+      RendererCommands::enable(RendererFunction::DepthTest);
+      storage->lightingPass.unbind();
+
+      storage->transparentQueue.clear();
+      storage->transparencyTimer.end();
+    }
+
+    //--------------------------------------------------------------------------
+    // Temporal anti-aliasing pass. Blends the lit scene with the reprojected
+    // history of the previous frames.
+    //--------------------------------------------------------------------------
+    void
+    taaPass()
+    {
+      if (!state->temporalAA)
+        return;
+
+      storage->lightingPass.bindTextureID(FBOTargetParam::Colour0, 0);
+      storage->gBuffer.bindAttachment(FBOTargetParam::Colour5, 1);
+      storage->temporalAA->resolve(storage->sceneCam, getRenderSize());
+    }
+
+    // Bind the lit scene, anti-aliased if TAA is enabled.
+    void
+    bindSceneColour(GLuint textureUnit)
+    {
+      if (state->temporalAA)
+        storage->temporalAA->bind(textureUnit);
+      else
+        storage->lightingPass.bindTextureID(FBOTargetParam::Colour0, textureUnit);
+    }
+
     //--------------------------------------------------------------------------
     // Post processing pass. TODO: Move most of these to the editor window and a
     // separate scene renderer?
@@ -656,6 +1305,27 @@ namespace SciRenderer
     void
     postProcessPass(Shared<FrameBuffer> frontBuffer)
     {
+      // Upscale the rendered corner of the buffers to the whole screen.
+      glm::vec2 uvScale = glm::vec2(getRenderSize()) / storage->lightingPass.getSize();
+
+      //------------------------------------------------------------------------
+      // Auto-exposure and bloom, from the HDR scene.
+      //------------------------------------------------------------------------
+      if (state->autoExposure)
+      {
+        bindSceneColour(0);
+        storage->autoExposure->compute(getRenderSize(), state->exposureCompensation,
+                                       state->adaptationSpeed);
+      }
+      else
+        storage->autoExposure->resetHistory();
+
+      if (state->bloom)
+      {
+        bindSceneColour(0);
+        storage->bloom->compute(getRenderSize());
+      }
+
       frontBuffer->clear();
       frontBuffer->bind();
       frontBuffer->setViewport();
@@ -664,11 +1334,22 @@ namespace SciRenderer
       // HDR post processing pass. Also streams the entity IDs to the editor
       // buffer.
       //------------------------------------------------------------------------
+      storage->toneMapTimer.begin();
       storage->hdrPostShader->addUniformVector("screenSize", frontBuffer->getSize());
-      storage->lightingPass.bindTextureID(FBOTargetParam::Colour0, 0);
+      storage->hdrPostShader->addUniformVector("uvScale", uvScale);
+      storage->hdrPostShader->addUniformUInt("useAutoExposure", state->autoExposure ? 1 : 0);
+      storage->hdrPostShader->addUniformFloat("fixedExposure", std::exp2(state->exposureCompensation));
+      storage->hdrPostShader->addUniformUInt("useBloom", state->bloom ? 1 : 0);
+      storage->hdrPostShader->addUniformFloat("bloomIntensity", state->bloomIntensity);
+      storage->hdrPostShader->addUniformFloat("bloomLevels", (GLfloat) storage->bloom->getNumMips());
+      storage->hdrPostShader->addUniformVector("bloomScale", storage->bloom->getResultScale());
+      bindSceneColour(0);
       storage->gBuffer.bindAttachment(FBOTargetParam::Colour4, 1);
+      storage->bloom->bind(2);
+      storage->autoExposure->bind(3);
 
       draw(&storage->fsq, storage->hdrPostShader);
+      storage->toneMapTimer.end();
 
       RendererCommands::enable(RendererFunction::Blending);
       RendererCommands::blendEquation(BlendEquation::Additive);
@@ -682,6 +1363,8 @@ namespace SciRenderer
       {
         storage->gridShader->addUniformMatrix("invViewProj", glm::inverse(storage->sceneCam->getProjMatrix() * storage->sceneCam->getViewMatrix()), GL_FALSE);
         storage->gridShader->addUniformMatrix("viewProj", storage->sceneCam->getProjMatrix() * storage->sceneCam->getViewMatrix(), GL_FALSE);
+        storage->gridShader->addUniformVector("screenSize", frontBuffer->getSize());
+        storage->gridShader->addUniformVector("uvScale", uvScale);
         storage->gBuffer.bindAttachment(FBOTargetParam::Depth, 0);
         draw(&storage->fsq, storage->gridShader);
       }
@@ -693,6 +1376,7 @@ namespace SciRenderer
       if (storage->drawEdge)
       {
         storage->outlineShader->addUniformVector("screenSize", frontBuffer->getSize());
+        storage->outlineShader->addUniformVector("uvScale", uvScale);
         storage->gBuffer.bindAttachment(FBOTargetParam::Colour4, 0);
 
         draw(&storage->fsq, storage->outlineShader);
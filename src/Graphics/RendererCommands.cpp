@@ -26,6 +26,18 @@ namespace SciRenderer
     glDepthMask(GL_FALSE);
   }
 
+  void
+  RendererCommands::enableColourMask()
+  {
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  }
+
+  void
+  RendererCommands::disableColourMask()
+  {
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  }
+
   void
   RendererCommands::blendEquation(const BlendEquation &equation)
   {
@@ -39,6 +51,13 @@ namespace SciRenderer
     glBlendFunc(static_cast<GLenum>(source), static_cast<GLenum>(target));
   }
 
+  void
+  RendererCommands::blendFunction(GLuint drawBuffer, const BlendFunction &source,
+                                  const BlendFunction &target)
+  {
+    glBlendFunci(drawBuffer, static_cast<GLenum>(source), static_cast<GLenum>(target));
+  }
+
   void
   RendererCommands::depthFunction(const DepthFunctions &function)
   {
@@ -76,4 +95,19 @@ namespace SciRenderer
   {
     glDrawElements(static_cast<GLenum>(primative), count, GL_UNSIGNED_INT, indices);
   }
+
+  void
+  RendererCommands::drawPrimativesBaseInstance(PrimativeType primative, GLuint count,
+                                               GLuint baseInstance)
+  {
+    glDrawElementsInstancedBaseInstance(static_cast<GLenum>(primative), count,
+                                        GL_UNSIGNED_INT, nullptr, 1, baseInstance);
+  }
+
+  void
+  RendererCommands::drawPrimativesIndirect(PrimativeType primative, GLuint commandOffset)
+  {
+    glDrawElementsIndirect(static_cast<GLenum>(primative), GL_UNSIGNED_INT,
+                           (const void*) (uintptr_t) commandOffset);
+  }
 }
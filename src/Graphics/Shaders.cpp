@@ -3,44 +3,293 @@
 #include "Graphics/Shaders.h"
 
 // Project includes.
+#include "Core/AssetCache.h"
 #include "Core/Logs.h"
 
+// STL includes.
+#include <filesystem>
+#include <sstream>
+#include <unordered_set>
+
 namespace SciRenderer
 {
+	//----------------------------------------------------------------------------
+	// Program binary cache.
+	//----------------------------------------------------------------------------
+	namespace ProgramCache
+	{
+		static Stats cacheStats = { 0, 0, 0.0 };
+
+		// Identifies the driver the binaries were built by.
+		static const std::string&
+		getDriverString()
+		{
+			static std::string driver = "";
+			if (driver == "")
+			{
+				driver = std::string((const char*) glGetString(GL_VENDOR)) + ":"
+					+ std::string((const char*) glGetString(GL_RENDERER)) + ":"
+					+ std::string((const char*) glGetString(GL_VERSION));
+			}
+
+			return driver;
+		}
+
+		std::string
+		getPath(const std::string &sources, const std::string &defines)
+		{
+			auto cache = AssetCache::getInstance();
+			std::string settings = "Program:1:" + defines + ":" + getDriverString();
+			std::string key = cache->getDataKey(sources, settings);
+			return cache->getPath(key, ".glbin");
+		}
+
+		GLuint
+		loadProgram(const std::string &path)
+		{
+			GLint numFormats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+			if (numFormats == 0)
+				return 0;
+
+			std::vector<unsigned char> blob;
+			if (!AssetCache::getInstance()->readBlob(path, blob))
+				return 0;
+
+			BlobReader reader(blob);
+			GLenum format;
+			if (!reader.read(format) || reader.remaining() == 0)
+				return 0;
+
+			// Drivers reject binaries from older versions of themselves.
+			GLuint program = glCreateProgram();
+			glProgramBinary(program, format, reader.current(), reader.remaining());
+
+			GLint result;
+			glGetProgramiv(program, GL_LINK_STATUS, &result);
+			if (result != GL_TRUE)
+			{
+				glDeleteProgram(program);
+				return 0;
+			}
+
+			cacheStats.numLoaded++;
+			return program;
+		}
+
+		void
+		saveProgram(GLuint program, const std::string &path)
+		{
+			GLint result;
+			glGetProgramiv(program, GL_LINK_STATUS, &result);
+			if (result != GL_TRUE)
+				return;
+
+			GLint length = 0;
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length <= 0)
+				return;
+
+			std::vector<unsigned char> binary(length);
+			GLenum format;
+			glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+			BlobWriter writer;
+			writer.write(format);
+			writer.writeBytes(binary.data(), binary.size());
+			AssetCache::getInstance()->writeBlob(path, writer.bytes);
+		}
+
+		Stats&
+		getStats()
+		{
+			return cacheStats;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+	// Shader preprocessor.
+	//----------------------------------------------------------------------------
+	// Expand #include "file" directives. Each file is only included once, which
+	// also guards against include cycles.
+	static std::string
+	expandIncludes(const std::string &source, const std::filesystem::path &directory,
+								 std::unordered_set<std::string> &included)
+	{
+		std::istringstream stream(source);
+		std::string result = "";
+		std::string line;
+		GLuint lineNumber = 0;
+		while (std::getline(stream, line))
+		{
+			lineNumber++;
+			size_t start = line.find_first_not_of(" \t");
+			if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+			{
+				result += line + "\n";
+				continue;
+			}
+
+			// Includes are replaced with a blank line if they can't be expanded.
+			size_t open = line.find('"', start);
+			size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+			if (close == std::string::npos)
+			{
+				Logger::getInstance()->logMessage(LogMessage("Malformed shader include: "
+																										 + line, true, true));
+				result += "\n";
+				continue;
+			}
+
+			auto includePath = (directory / line.substr(open + 1, close - open - 1)).lexically_normal();
+			if (included.count(includePath.string()) != 0)
+			{
+				result += "\n";
+				continue;
+			}
+			included.insert(includePath.string());
+
+			std::ifstream file(includePath);
+			if (!file.is_open())
+			{
+				Logger::getInstance()->logMessage(LogMessage("Can't open shader include: "
+																										 + includePath.string(), true, true));
+				result += "\n";
+				continue;
+			}
+			std::stringstream contents;
+			contents << file.rdbuf();
+
+			// Keep compiler errors after the include on the right line.
+			result += expandIncludes(contents.str(), includePath.parent_path(), included);
+			result += "#line " + std::to_string(lineNumber + 1) + "\n";
+		}
+
+		return result;
+	}
+
+	ShaderDefines Shader::globalDefines = ShaderDefines();
+
+	void
+	Shader::setGlobalDefine(const std::string &name, const std::string &value)
+	{
+		Shader::globalDefines[name] = value;
+	}
+
+	std::string
+	Shader::getPermutationKey(const ShaderDefines &defines)
+	{
+		std::string key = "";
+		for (auto& [name, value] : defines)
+			key += name + "=" + value + ";";
+		return key;
+	}
+
+	std::string
+	Shader::preprocess(const std::string &source, const std::string &filepath)
+	{
+		ShaderDefines allDefines = Shader::globalDefines;
+		for (auto& [name, value] : this->defines)
+			allDefines[name] = value;
+
+		std::string defineBlock = "";
+		for (auto& [name, value] : allDefines)
+			defineBlock += "#define " + name + " " + value + "\n";
+
+		std::unordered_set<std::string> included;
+		std::string expanded = expandIncludes(source,
+			std::filesystem::path(filepath).parent_path(), included);
+
+		// The version directive has to come first, the defines go right after it.
+		size_t version = expanded.find("#version");
+		if (version == std::string::npos)
+			return defineBlock + expanded;
+
+		size_t versionEnd = expanded.find('\n', version);
+		if (versionEnd == std::string::npos)
+			return expanded + "\n" + defineBlock;
+
+		GLuint nextLine = std::count(expanded.begin(), expanded.begin() + versionEnd, '\n') + 2;
+		return expanded.substr(0, versionEnd + 1) + defineBlock
+				 + "#line " + std::to_string(nextLine) + "\n"
+				 + expanded.substr(versionEnd + 1);
+	}
+
+	// Get or build a permutation of the shader.
+	Shader*
+	Shader::getVariant(const ShaderDefines &defines)
+	{
+		ShaderDefines variantDefines = this->defines;
+		for (auto& [name, value] : defines)
+			variantDefines[name] = value;
+
+		std::string key = Shader::getPermutationKey(variantDefines);
+		if (key == Shader::getPermutationKey(this->defines))
+			return this;
+
+		auto variant = this->variants.find(key);
+		if (variant != this->variants.end())
+			return variant->second.get();
+
+		Shader* newVariant = new Shader(this->vertPath, this->fragPath, variantDefines);
+		this->variants.emplace(key, Unique<Shader>(newVariant));
+		return newVariant;
+	}
+
+	bool Shader::parallelCompile = false;
+
+	// Load KHR_parallel_shader_compile (or the ARB version) by hand, the loader
+	// was generated without it.
+	void
+	Shader::initParallelCompile()
+	{
+		typedef void (APIENTRYP MaxCompilerThreadsProc)(GLuint count);
+
+		GLint numExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+		for (GLint i = 0; i < numExtensions; i++)
+		{
+			std::string extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+			if (extension != "GL_KHR_parallel_shader_compile"
+					&& extension != "GL_ARB_parallel_shader_compile")
+				continue;
+
+			const char* procName = extension == "GL_KHR_parallel_shader_compile"
+				? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB";
+			auto maxCompilerThreads = (MaxCompilerThreadsProc) glfwGetProcAddress(procName);
+			if (!maxCompilerThreads)
+				continue;
+
+			// Let the driver pick the number of threads.
+			maxCompilerThreads(0xFFFFFFFF);
+			Shader::parallelCompile = true;
+			break;
+		}
+
+		Logger::getInstance()->logMessage(LogMessage(Shader::parallelCompile
+			? "Parallel shader compilation enabled."
+			: "Parallel shader compilation unsupported, shaders will compile serially.",
+			true, true));
+	}
+
 	// Constructor and destructor.
 	Shader::Shader()
+		: pending(false)
 	{
 		this->progID = glCreateProgram();
 		this->vertID = glCreateShader(GL_VERTEX_SHADER);
 		this->fragID = glCreateShader(GL_FRAGMENT_SHADER);
 	}
 
-	Shader::Shader(const std::string &vertPath, const std::string &fragPath)
+	Shader::Shader(const std::string &vertPath, const std::string &fragPath,
+								 const ShaderDefines &defines)
 		: vertPath(vertPath)
 		, fragPath(fragPath)
+		, pending(false)
+		, defines(defines)
 	{
 		// Build the shader from source.
-		this->buildShader(GL_VERTEX_SHADER, vertPath.c_str());
-		this->buildShader(GL_FRAGMENT_SHADER, fragPath.c_str());
-		this->buildProgram(this->vertID, this->fragID, 0);
-		glUseProgram(this->progID);
-
-		// Reflect the shader and gather a list of uniforms.
-		this->shaderInfoString = this->dumpProgram();
-
-		char name[256];
-		GLsizei length;
-		GLint size;
-		GLenum type;
-		int uniforms;
-
-		// Generates a list of uniforms based on their name and type.
-		glGetProgramiv(this->progID, GL_ACTIVE_UNIFORMS, &uniforms);
-		for (unsigned i = 0; i < uniforms; i++)
-		{
-			glGetActiveUniform(this->progID, i, 256, &length, &size, &type, name);
-			this->uniforms.push_back({ name, enumToUniform(type) });
-		}
+		this->buildCachedProgram(true);
 	}
 
 	Shader::~Shader()
@@ -59,83 +308,31 @@ namespace SciRenderer
 		glDeleteShader(this->fragID);
 
 		// Build the shader from source.
-		this->buildShader(GL_VERTEX_SHADER, this->vertPath.c_str());
-		this->buildShader(GL_FRAGMENT_SHADER, this->fragPath.c_str());
-		this->buildProgram(this->vertID, this->fragID, 0);
-		glUseProgram(this->progID);
-
-		// Reflect the shader and gather a list of uniforms.
-		this->shaderInfoString = this->dumpProgram();
-
-		char name[256];
-		GLsizei length;
-		GLint size;
-		GLenum type;
-		int uniforms;
+		this->buildCachedProgram(true);
 
-		// Generates a list of uniforms based on their name and type.
-		this->uniforms.clear();
-		glGetProgramiv(this->progID, GL_ACTIVE_UNIFORMS, &uniforms);
-		for (unsigned i = 0; i < uniforms; i++)
-		{
-			glGetActiveUniform(this->progID, i, 256, &length, &size, &type, name);
-			this->uniforms.push_back({ name, enumToUniform(type) });
-		}
+		for (auto& [key, variant] : this->variants)
+			variant->rebuild();
 	}
 
 	void
 	Shader::rebuildFromString()
 	{
-		this->buildShaderSource(GL_VERTEX_SHADER, this->vertSource);
-		this->buildShaderSource(GL_FRAGMENT_SHADER, this->fragSource);
-		this->buildProgram(this->vertID, this->fragID, 0);
-		glUseProgram(this->progID);
-
-		// Reflect the shader and gather a list of uniforms.
-		this->shaderInfoString = this->dumpProgram();
-
-		char name[256];
-		GLsizei length;
-		GLint size;
-		GLenum type;
-		int uniforms;
+		this->buildCachedProgram(false);
 
-		// Generates a list of uniforms based on their name and type.
-		this->uniforms.clear();
-		glGetProgramiv(this->progID, GL_ACTIVE_UNIFORMS, &uniforms);
-		for (unsigned i = 0; i < uniforms; i++)
-		{
-			glGetActiveUniform(this->progID, i, 256, &length, &size, &type, name);
-			this->uniforms.push_back({ name, enumToUniform(type) });
-		}
+		for (auto& [key, variant] : this->variants)
+			variant->rebuildFromString(this->vertSource, this->fragSource);
 	}
 
 	void
 	Shader::rebuildFromString(const std::string &vertSource,
 														const std::string &fragSource)
 	{
-		this->buildShaderSource(GL_VERTEX_SHADER, vertSource);
-		this->buildShaderSource(GL_FRAGMENT_SHADER, fragSource);
-		this->buildProgram(this->vertID, this->fragID, 0);
-		glUseProgram(this->progID);
-
-		// Reflect the shader and gather a list of uniforms.
-		this->shaderInfoString = this->dumpProgram();
-
-		char name[256];
-		GLsizei length;
-		GLint size;
-		GLenum type;
-		int uniforms;
+		this->vertSource = vertSource;
+		this->fragSource = fragSource;
+		this->buildCachedProgram(false);
 
-		// Generates a list of uniforms based on their name and type.
-		this->uniforms.clear();
-		glGetProgramiv(this->progID, GL_ACTIVE_UNIFORMS, &uniforms);
-		for (unsigned i = 0; i < uniforms; i++)
-		{
-			glGetActiveUniform(this->progID, i, 256, &length, &size, &type, name);
-			this->uniforms.push_back({ name, enumToUniform(type) });
-		}
+		for (auto& [key, variant] : this->variants)
+			variant->rebuildFromString(vertSource, fragSource);
 	}
 
 	// Build and validate a shader program. TODO: Move away from C to C++.
@@ -144,39 +341,27 @@ namespace SciRenderer
 	{
 		Logger* logs = Logger::getInstance();
 
-		GLuint shaderID;
 		char *source;
-		int result;
-		char *buffer;
 
-		shaderID = glCreateShader(type);
 		source = readShaderFile(filename);
 		if (source == 0)
 			return;
 
-		glShaderSource(shaderID, 1, (const  GLchar**) &source, 0);
-		glCompileShader(shaderID);
-		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
-		if (result != GL_TRUE)
-		{
-			glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &result);
-			buffer = new char[result];
-			glGetShaderInfoLog(shaderID, result, 0, buffer);
-			logs->logMessage(LogMessage(std::string("Shader compiler error at: ")
-																	+ std::string(filename) + std::string("\n")
-																	+ std::string(buffer), true, true));
-			delete buffer;
-		}
+		// Sources are kept as written so the editor never sees expanded includes.
+		std::string strSource = std::string(source);
+		delete[] source;
+
+		GLuint shaderID = this->compileShader(type, this->preprocess(strSource, filename));
 
 		switch (type)
 		{
 			case GL_VERTEX_SHADER:
 				this->vertID = shaderID;
-				this->vertSource = std::string(source);
+				this->vertSource = strSource;
 				break;
 			case GL_FRAGMENT_SHADER:
 				this->fragID = shaderID;
-				this->fragSource = std::string(source);
+				this->fragSource = strSource;
 				break;
 			default:
 				logs->logMessage(LogMessage("Shader type unknown!", true, true));
@@ -190,37 +375,18 @@ namespace SciRenderer
 	{
 		Logger* logs = Logger::getInstance();
 
-		GLuint shaderID;
-		int result;
-		char* buffer;
-
-		shaderID = glCreateShader(type);
-		char* source = (char*) strSource.c_str();
-		if (source == 0)
-			return;
-
-		glShaderSource(shaderID, 1, (const  GLchar**) &source, 0);
-		glCompileShader(shaderID);
-		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
-		if (result != GL_TRUE)
-		{
-			glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &result);
-			buffer = new char[result];
-			glGetShaderInfoLog(shaderID, result, 0, buffer);
-			logs->logMessage(LogMessage(std::string("Shader compiler error: ")
-																	+ std::string(buffer), true, true));
-			delete buffer;
-		}
+		std::string filepath = type == GL_VERTEX_SHADER ? this->vertPath : this->fragPath;
+		GLuint shaderID = this->compileShader(type, this->preprocess(strSource, filepath));
 
 		switch (type)
 		{
 			case GL_VERTEX_SHADER:
 				this->vertID = shaderID;
-				this->vertSource = std::string(source);
+				this->vertSource = strSource;
 				break;
 			case GL_FRAGMENT_SHADER:
 				this->fragID = shaderID;
-				this->fragSource = std::string(source);
+				this->fragSource = strSource;
 				break;
 			default:
 				logs->logMessage(LogMessage("Shader type unknown!", true, true));
@@ -228,12 +394,24 @@ namespace SciRenderer
 		}
 	}
 
+	// Submit a preprocessed source to the driver. The compile status is checked
+	// once the program is first used, so the driver can compile in the
+	// background.
+	GLuint
+	Shader::compileShader(int type, const std::string &source)
+	{
+		GLuint shaderID = glCreateShader(type);
+		const GLchar* sourcePtr = source.c_str();
+		glShaderSource(shaderID, 1, &sourcePtr, 0);
+		glCompileShader(shaderID);
+
+		return shaderID;
+	}
+
 	// Link the shader program together. TODO: Move away from C to C++.
 	void
 	Shader::buildProgram(GLuint first, ...)
 	{
-		int result;
-		char *buffer;
 		va_list argptr;
 		int shader;
 		int vs = 0;
@@ -267,18 +445,144 @@ namespace SciRenderer
 		if (fs == 0)
 			printf("no fragment shader\n");
 
+		// Linking is also asynchronous, see finishBuild().
+		glProgramParameteri(this->progID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 		glLinkProgram(this->progID);
-		glGetProgramiv(this->progID, GL_LINK_STATUS, &result);
+	}
+
+	// Build the program, from the cache if it was built before. The build is
+	// only submitted here, it's finished when the program is first used.
+	void
+	Shader::buildCachedProgram(bool fromFiles)
+	{
+		auto start = std::chrono::steady_clock::now();
+		auto& stats = ProgramCache::getStats();
+
+		if (fromFiles)
+		{
+			char* source = readShaderFile(this->vertPath.c_str());
+			this->vertSource = source ? std::string(source) : "";
+			delete[] source;
+
+			source = readShaderFile(this->fragPath.c_str());
+			this->fragSource = source ? std::string(source) : "";
+			delete[] source;
+		}
 
+		// Binaries are keyed by the preprocessed sources, so editing an include
+		// invalidates every program using it.
+		std::string vertCode = this->preprocess(this->vertSource, this->vertPath);
+		std::string fragCode = this->preprocess(this->fragSource, this->fragPath);
+
+		std::string path = ProgramCache::getPath(vertCode + '\0' + fragCode,
+																						 Shader::getPermutationKey(this->defines));
+		this->progID = ProgramCache::loadProgram(path);
+		if (this->progID != 0)
+		{
+			// Nothing was compiled.
+			this->vertID = 0;
+			this->fragID = 0;
+		}
+		else
+		{
+			this->vertID = this->compileShader(GL_VERTEX_SHADER, vertCode);
+			this->fragID = this->compileShader(GL_FRAGMENT_SHADER, fragCode);
+			this->buildProgram(this->vertID, this->fragID, 0);
+
+			this->binaryPath = path;
+			stats.numCompiled++;
+		}
+		this->pending = true;
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		stats.buildTime += elapsed.count();
+	}
+
+	// Poll the driver without blocking. Without the parallel compile extension
+	// there's nothing to poll, the program is ready once it's waited on.
+	bool
+	Shader::isReady()
+	{
+		if (!this->pending || !Shader::parallelCompile)
+			return true;
+
+		GLint complete = GL_FALSE;
+		glGetProgramiv(this->progID, GL_COMPLETION_STATUS_KHR, &complete);
+		return complete == GL_TRUE;
+	}
+
+	// Wait for the driver to finish the program, log any errors, store the
+	// binary and reflect the uniforms.
+	void
+	Shader::finishBuild()
+	{
+		if (!this->pending)
+			return;
+		this->pending = false;
+
+		auto start = std::chrono::steady_clock::now();
+		Logger* logs = Logger::getInstance();
+
+		// Programs loaded from binaries have no shaders to check.
+		this->checkShader(this->vertID, this->vertPath);
+		this->checkShader(this->fragID, this->fragPath);
+
+		int result;
+		glGetProgramiv(this->progID, GL_LINK_STATUS, &result);
 		if (result != GL_TRUE)
 		{
-			printf("program link error\n");
 			glGetProgramiv(this->progID, GL_INFO_LOG_LENGTH, &result);
-			buffer = new char[result];
+			char* buffer = new char[result];
 			glGetProgramInfoLog(this->progID, result, 0, buffer);
-			printf("%s\n",buffer);
-			delete buffer;
+			logs->logMessage(LogMessage(std::string("Program link error: ")
+																	+ std::string(buffer), true, true));
+			delete[] buffer;
 		}
+		else if (this->binaryPath != "")
+			ProgramCache::saveProgram(this->progID, this->binaryPath);
+		this->binaryPath = "";
+
+		// Reflect the shader and gather a list of uniforms.
+		this->shaderInfoString = this->dumpProgram();
+
+		char name[256];
+		GLsizei length;
+		GLint size;
+		GLenum type;
+		int uniforms;
+
+		// Generates a list of uniforms based on their name and type.
+		this->uniforms.clear();
+		glGetProgramiv(this->progID, GL_ACTIVE_UNIFORMS, &uniforms);
+		for (unsigned i = 0; i < uniforms; i++)
+		{
+			glGetActiveUniform(this->progID, i, 256, &length, &size, &type, name);
+			this->uniforms.push_back({ name, enumToUniform(type) });
+		}
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		ProgramCache::getStats().buildTime += elapsed.count();
+	}
+
+	// Log the compile errors of a shader, if there are any.
+	void
+	Shader::checkShader(GLuint shaderID, const std::string &filename)
+	{
+		if (shaderID == 0)
+			return;
+
+		int result;
+		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
+		if (result == GL_TRUE)
+			return;
+
+		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &result);
+		char* buffer = new char[result];
+		glGetShaderInfoLog(shaderID, result, 0, buffer);
+		Logger::getInstance()->logMessage(LogMessage(std::string("Shader compiler error at: ")
+																								 + filename + std::string("\n")
+																								 + std::string(buffer), true, true));
+		delete[] buffer;
 	}
 
 	// Saves the vertex and fragment shader source code to the files they were
@@ -384,6 +688,7 @@ namespace SciRenderer
 	void
 	Shader::bind()
 	{
+		this->finishBuild();
 		glUseProgram(this->progID);
 	}
 
@@ -0,0 +1,144 @@
+#include "Graphics/TemporalAA.h"
+
+namespace SciRenderer
+{
+  // The parameters of the resolve pass.
+  struct TAAParams
+  {
+    glm::mat4 prevViewProj;
+    glm::mat4 invViewProj;
+    glm::vec2 screenSize;
+    GLfloat blend;
+    GLuint historyValid;
+    glm::vec2 historyScale;
+  };
+
+  // Radical inverse of an index in a base, the Halton sequence.
+  static GLfloat
+  halton(GLuint index, GLuint base)
+  {
+    GLfloat result = 0.0f;
+    GLfloat fraction = 1.0f;
+    while (index > 0)
+    {
+      fraction /= (GLfloat) base;
+      result += fraction * (GLfloat) (index % base);
+      index /= base;
+    }
+    return result;
+  }
+
+  TemporalAA::TemporalAA(GLuint width, GLuint height)
+    : width(width)
+    , height(height)
+    , current(0)
+    , frameIndex(0)
+    , prevViewProj(glm::mat4(1.0f))
+    , prevRenderSize(glm::uvec2(width, height))
+    , historyValid(false)
+    , resolveShader("./assets/shaders/compute/taaResolve.cs")
+    , paramBuffer(sizeof(TAAParams), BufferType::Dynamic)
+  {
+    this->history[0] = 0;
+    this->history[1] = 0;
+    this->createTextures();
+  }
+
+  TemporalAA::~TemporalAA()
+  {
+    this->deleteTextures();
+  }
+
+  void
+  TemporalAA::createTextures()
+  {
+    glGenTextures(2, this->history);
+    for (unsigned i = 0; i < 2; i++)
+    {
+      glBindTexture(GL_TEXTURE_2D, this->history[i]);
+      glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, this->width, this->height);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    this->historyValid = false;
+  }
+
+  void
+  TemporalAA::deleteTextures()
+  {
+    glDeleteTextures(2, this->history);
+  }
+
+  void
+  TemporalAA::resize(GLuint width, GLuint height)
+  {
+    if (this->width == width && this->height == height)
+      return;
+
+    this->width = width;
+    this->height = height;
+
+    this->deleteTextures();
+    this->createTextures();
+  }
+
+  glm::vec2
+  TemporalAA::nextJitter(const glm::uvec2 &renderSize)
+  {
+    // Skip the first sample of the sequence, it's zero in both bases.
+    GLuint index = (this->frameIndex % TAA_JITTER_SAMPLES) + 1;
+    glm::vec2 offset = glm::vec2(halton(index, 2), halton(index, 3)) - glm::vec2(0.5f);
+
+    // From pixels to normalized device coordinates.
+    return 2.0f * offset / glm::vec2(renderSize);
+  }
+
+  void
+  TemporalAA::resolve(Shared<Camera> camera, const glm::uvec2 &renderSize)
+  {
+    this->timer.begin();
+
+    // Velocities are computed without the jitter, so are the reprojections.
+    glm::mat4 viewProj = camera->getProjMatrix() * camera->getViewMatrix();
+
+    TAAParams params;
+    params.prevViewProj = this->prevViewProj;
+    params.invViewProj = glm::inverse(viewProj);
+    params.screenSize = glm::vec2(renderSize);
+    params.blend = 0.1f;
+    params.historyValid = this->historyValid ? 1 : 0;
+    // The history covers last frame's render size.
+    params.historyScale = glm::vec2(this->prevRenderSize)
+                        / glm::vec2((GLfloat) this->width, (GLfloat) this->height);
+    this->paramBuffer.setData(0, sizeof(TAAParams), &params);
+    this->paramBuffer.bindToPoint(2);
+
+    GLuint previous = this->current;
+    this->current = 1 - this->current;
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, this->history[previous]);
+    glBindImageTexture(0, this->history[this->current], 0, GL_FALSE, 0,
+                       GL_WRITE_ONLY, GL_RGBA16F);
+    this->resolveShader.launchCompute(glm::ivec3((renderSize.x + 7) / 8,
+                                                 (renderSize.y + 7) / 8, 1));
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    this->timer.end();
+
+    this->prevViewProj = viewProj;
+    this->prevRenderSize = renderSize;
+    this->historyValid = true;
+    this->frameIndex++;
+  }
+
+  void
+  TemporalAA::bind(GLuint textureUnit)
+  {
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D, this->history[this->current]);
+  }
+}
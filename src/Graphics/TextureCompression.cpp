@@ -0,0 +1,771 @@
+#include "Graphics/TextureCompression.h"
+
+// Project includes.
+#include "Core/AssetCache.h"
+
+// STL includes.
+#include <filesystem>
+#include <limits>
+
+// S3TC is an extension, the loader only has the core BPTC and RGTC formats.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace SciRenderer
+{
+  //----------------------------------------------------------------------------
+  // Block encoding helpers.
+  //----------------------------------------------------------------------------
+  // Interpolation weights of the 4 bit BC6H and BC7 indices.
+  static const GLuint bptcWeights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38,
+                                          43, 47, 51, 55, 60, 64 };
+
+  // Writes bits into a block least significant bit first, which is how the
+  // BC6H and BC7 fields are laid out.
+  struct BlockWriter
+  {
+    unsigned char* out;
+    GLuint bit;
+
+    BlockWriter(unsigned char* out)
+      : out(out)
+      , bit(0)
+    {
+      memset(out, 0, 16);
+    }
+
+    void write(GLuint value, GLuint numBits)
+    {
+      for (GLuint i = 0; i < numBits; i++)
+      {
+        if ((value >> i) & 1)
+          this->out[this->bit >> 3] |= 1 << (this->bit & 7);
+        this->bit++;
+      }
+    }
+  };
+
+  static GLfloat
+  clampf(GLfloat value, GLfloat minValue, GLfloat maxValue)
+  {
+    return std::min(std::max(value, minValue), maxValue);
+  }
+
+  // Convert a non-negative float to the bits of a half, clamped to the
+  // largest finite half.
+  static GLuint
+  floatToHalf(GLfloat value)
+  {
+    if (!(value > 0.0f))
+      return 0;
+
+    GLuint bits;
+    memcpy(&bits, &value, sizeof(GLuint));
+
+    int exponent = (int) ((bits >> 23) & 0xFF) - 127 + 15;
+    GLuint mantissa = bits & 0x7FFFFF;
+
+    if (exponent >= 31)
+      return 0x7BFF;
+
+    // Denormals.
+    if (exponent <= 0)
+    {
+      if (exponent < -10)
+        return 0;
+      mantissa |= 0x800000;
+      GLuint shift = 14 - exponent;
+      return (mantissa + (1 << (shift - 1))) >> shift;
+    }
+
+    GLuint half = (exponent << 10) + ((mantissa + 0x1000) >> 13);
+    return std::min(half, 0x7BFFu);
+  }
+
+  // Find the endpoints of a block. Starts from the bounding box of the texels
+  // and flips the box diagonal for channels which are anti-correlated with
+  // the channel of largest extent, then insets the endpoints slightly.
+  static void
+  getEndpoints(const GLfloat block[16][4], GLuint numChannels,
+               GLfloat minColour[4], GLfloat maxColour[4])
+  {
+    GLfloat mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (GLuint c = 0; c < numChannels; c++)
+    {
+      minColour[c] = block[0][c];
+      maxColour[c] = block[0][c];
+      for (GLuint i = 0; i < 16; i++)
+      {
+        minColour[c] = std::min(minColour[c], block[i][c]);
+        maxColour[c] = std::max(maxColour[c], block[i][c]);
+        mean[c] += block[i][c] / 16.0f;
+      }
+    }
+
+    GLuint mainChannel = 0;
+    for (GLuint c = 1; c < numChannels; c++)
+    {
+      if (maxColour[c] - minColour[c] > maxColour[mainChannel] - minColour[mainChannel])
+        mainChannel = c;
+    }
+
+    for (GLuint c = 0; c < numChannels; c++)
+    {
+      if (c == mainChannel)
+        continue;
+
+      GLfloat covariance = 0.0f;
+      for (GLuint i = 0; i < 16; i++)
+        covariance += (block[i][c] - mean[c]) * (block[i][mainChannel] - mean[mainChannel]);
+
+      if (covariance < 0.0f)
+        std::swap(minColour[c], maxColour[c]);
+    }
+
+    for (GLuint c = 0; c < numChannels; c++)
+    {
+      GLfloat inset = (maxColour[c] - minColour[c]) / 16.0f;
+      minColour[c] += inset;
+      maxColour[c] -= inset;
+    }
+  }
+
+  static GLuint
+  packRGB565(const GLfloat colour[4])
+  {
+    GLuint r = (GLuint) std::round(clampf(colour[0], 0.0f, 255.0f) * 31.0f / 255.0f);
+    GLuint g = (GLuint) std::round(clampf(colour[1], 0.0f, 255.0f) * 63.0f / 255.0f);
+    GLuint b = (GLuint) std::round(clampf(colour[2], 0.0f, 255.0f) * 31.0f / 255.0f);
+    return (r << 11) | (g << 5) | b;
+  }
+
+  static void
+  unpackRGB565(GLuint packed, GLfloat colour[3])
+  {
+    GLuint r = (packed >> 11) & 0x1F;
+    GLuint g = (packed >> 5) & 0x3F;
+    GLuint b = packed & 0x1F;
+    colour[0] = (GLfloat) ((r << 3) | (r >> 2));
+    colour[1] = (GLfloat) ((g << 2) | (g >> 4));
+    colour[2] = (GLfloat) ((b << 3) | (b >> 2));
+  }
+
+  // BC1, two 565 endpoints and 2 bit indices. Always uses the 4 colour mode.
+  static void
+  encodeBC1(const GLfloat block[16][4], unsigned char* out)
+  {
+    GLfloat minColour[4], maxColour[4];
+    getEndpoints(block, 3, minColour, maxColour);
+
+    GLuint c0 = packRGB565(maxColour);
+    GLuint c1 = packRGB565(minColour);
+    if (c0 < c1)
+      std::swap(c0, c1);
+
+    GLfloat palette[4][3];
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (GLuint c = 0; c < 3; c++)
+    {
+      palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+      palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+    }
+
+    // c0 == c1 selects the 3 colour mode, all indices must be 0 then.
+    GLuint indices = 0;
+    if (c0 != c1)
+    {
+      for (GLuint i = 0; i < 16; i++)
+      {
+        GLuint best = 0;
+        GLfloat bestError = std::numeric_limits<GLfloat>::max();
+        for (GLuint j = 0; j < 4; j++)
+        {
+          GLfloat error = 0.0f;
+          for (GLuint c = 0; c < 3; c++)
+            error += (block[i][c] - palette[j][c]) * (block[i][c] - palette[j][c]);
+
+          if (error < bestError)
+          {
+            bestError = error;
+            best = j;
+          }
+        }
+        indices |= best << (2 * i);
+      }
+    }
+
+    out[0] = c0 & 0xFF;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF;
+    out[3] = c1 >> 8;
+    for (GLuint i = 0; i < 4; i++)
+      out[4 + i] = (indices >> (8 * i)) & 0xFF;
+  }
+
+  // BC4, a single channel with two 8 bit endpoints and 3 bit indices. Always
+  // uses the 8 value mode.
+  static void
+  encodeBC4(const GLfloat block[16][4], GLuint channel, unsigned char* out)
+  {
+    GLfloat minValue = block[0][channel];
+    GLfloat maxValue = block[0][channel];
+    for (GLuint i = 1; i < 16; i++)
+    {
+      minValue = std::min(minValue, block[i][channel]);
+      maxValue = std::max(maxValue, block[i][channel]);
+    }
+
+    GLuint r0 = (GLuint) std::round(clampf(maxValue, 0.0f, 255.0f));
+    GLuint r1 = (GLuint) std::round(clampf(minValue, 0.0f, 255.0f));
+
+    GLfloat palette[8];
+    palette[0] = (GLfloat) r0;
+    palette[1] = (GLfloat) r1;
+    for (GLuint i = 2; i < 8; i++)
+      palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1]) / 7.0f;
+
+    uint64_t indices = 0;
+    if (r0 > r1)
+    {
+      for (GLuint i = 0; i < 16; i++)
+      {
+        GLuint best = 0;
+        GLfloat bestError = std::numeric_limits<GLfloat>::max();
+        for (GLuint j = 0; j < 8; j++)
+        {
+          GLfloat error = std::abs(block[i][channel] - palette[j]);
+          if (error < bestError)
+          {
+            bestError = error;
+            best = j;
+          }
+        }
+        indices |= ((uint64_t) best) << (3 * i);
+      }
+    }
+
+    out[0] = r0;
+    out[1] = r1;
+    for (GLuint i = 0; i < 6; i++)
+      out[2 + i] = (indices >> (8 * i)) & 0xFF;
+  }
+
+  // Quantize a BC7 mode 6 endpoint to 7 bits per channel and a shared p-bit.
+  static void
+  quantizeBC7Endpoint(const GLfloat colour[4], GLuint outEndpoint[4], GLuint &outPBit)
+  {
+    GLfloat bestError = std::numeric_limits<GLfloat>::max();
+    for (GLuint p = 0; p < 2; p++)
+    {
+      GLuint endpoint[4];
+      GLfloat error = 0.0f;
+      for (GLuint c = 0; c < 4; c++)
+      {
+        GLfloat value = clampf(colour[c], 0.0f, 255.0f);
+        endpoint[c] = (GLuint) clampf(std::round((value - p) / 2.0f), 0.0f, 127.0f);
+        GLfloat decoded = (GLfloat) ((endpoint[c] << 1) | p);
+        error += (decoded - value) * (decoded - value);
+      }
+
+      if (error < bestError)
+      {
+        bestError = error;
+        outPBit = p;
+        for (GLuint c = 0; c < 4; c++)
+          outEndpoint[c] = endpoint[c];
+      }
+    }
+  }
+
+  // BC7 mode 6, a single subset with 7777.1 RGBA endpoints and 4 bit indices.
+  static void
+  encodeBC7(const GLfloat block[16][4], unsigned char* out)
+  {
+    GLfloat minColour[4], maxColour[4];
+    getEndpoints(block, 4, minColour, maxColour);
+
+    GLuint endpoints[2][4];
+    GLuint pBits[2];
+    quantizeBC7Endpoint(minColour, endpoints[0], pBits[0]);
+    quantizeBC7Endpoint(maxColour, endpoints[1], pBits[1]);
+
+    GLuint decoded[2][4];
+    for (GLuint e = 0; e < 2; e++)
+      for (GLuint c = 0; c < 4; c++)
+        decoded[e][c] = (endpoints[e][c] << 1) | pBits[e];
+
+    GLuint indices[16];
+    for (GLuint i = 0; i < 16; i++)
+    {
+      indices[i] = 0;
+      GLfloat bestError = std::numeric_limits<GLfloat>::max();
+      for (GLuint j = 0; j < 16; j++)
+      {
+        GLfloat error = 0.0f;
+        for (GLuint c = 0; c < 4; c++)
+        {
+          GLuint value = ((64 - bptcWeights[j]) * decoded[0][c]
+                       + bptcWeights[j] * decoded[1][c] + 32) >> 6;
+          error += (block[i][c] - value) * (block[i][c] - value);
+        }
+
+        if (error < bestError)
+        {
+          bestError = error;
+          indices[i] = j;
+        }
+      }
+    }
+
+    // The most significant bit of the anchor index is implicitly 0.
+    if (indices[0] >= 8)
+    {
+      std::swap(endpoints[0], endpoints[1]);
+      std::swap(pBits[0], pBits[1]);
+      for (GLuint i = 0; i < 16; i++)
+        indices[i] = 15 - indices[i];
+    }
+
+    BlockWriter writer(out);
+    writer.write(1 << 6, 7);
+    for (GLuint c = 0; c < 4; c++)
+    {
+      writer.write(endpoints[0][c], 7);
+      writer.write(endpoints[1][c], 7);
+    }
+    writer.write(pBits[0], 1);
+    writer.write(pBits[1], 1);
+    writer.write(indices[0], 3);
+    for (GLuint i = 1; i < 16; i++)
+      writer.write(indices[i], 4);
+  }
+
+  // Unquantize a 10 bit unsigned BC6H endpoint.
+  static GLuint
+  unquantizeBC6H(GLuint value)
+  {
+    if (value == 0)
+      return 0;
+    if (value == 1023)
+      return 0xFFFF;
+    return ((value << 16) + 0x8000) >> 10;
+  }
+
+  // BC6H (unsigned) mode 11, a single region with 10 bit RGB endpoints and 4
+  // bit indices. The endpoints are found in the unquantized domain, which is
+  // the half bits scaled by 64 / 31, so the interpolation is close to linear
+  // in the logarithm of the texel values.
+  static void
+  encodeBC6H(const GLfloat block[16][4], unsigned char* out)
+  {
+    GLfloat halves[16][4];
+    GLfloat unquantized[16][4];
+    for (GLuint i = 0; i < 16; i++)
+    {
+      for (GLuint c = 0; c < 3; c++)
+      {
+        halves[i][c] = (GLfloat) floatToHalf(block[i][c]);
+        unquantized[i][c] = halves[i][c] * 64.0f / 31.0f;
+      }
+      halves[i][3] = 0.0f;
+      unquantized[i][3] = 0.0f;
+    }
+
+    GLfloat minColour[4], maxColour[4];
+    getEndpoints(unquantized, 3, minColour, maxColour);
+
+    GLuint endpoints[2][3];
+    GLuint decoded[2][3];
+    for (GLuint c = 0; c < 3; c++)
+    {
+      endpoints[0][c] = (GLuint) clampf(std::round((minColour[c] - 32.0f) / 64.0f), 0.0f, 1023.0f);
+      endpoints[1][c] = (GLuint) clampf(std::round((maxColour[c] - 32.0f) / 64.0f), 0.0f, 1023.0f);
+      decoded[0][c] = unquantizeBC6H(endpoints[0][c]);
+      decoded[1][c] = unquantizeBC6H(endpoints[1][c]);
+    }
+
+    GLuint indices[16];
+    for (GLuint i = 0; i < 16; i++)
+    {
+      indices[i] = 0;
+      GLfloat bestError = std::numeric_limits<GLfloat>::max();
+      for (GLuint j = 0; j < 16; j++)
+      {
+        GLfloat error = 0.0f;
+        for (GLuint c = 0; c < 3; c++)
+        {
+          GLuint value = ((64 - bptcWeights[j]) * decoded[0][c]
+                       + bptcWeights[j] * decoded[1][c] + 32) >> 6;
+          GLfloat half = (GLfloat) ((value * 31) >> 6);
+          error += (halves[i][c] - half) * (halves[i][c] - half);
+        }
+
+        if (error < bestError)
+        {
+          bestError = error;
+          indices[i] = j;
+        }
+      }
+    }
+
+    if (indices[0] >= 8)
+    {
+      std::swap(endpoints[0], endpoints[1]);
+      for (GLuint i = 0; i < 16; i++)
+        indices[i] = 15 - indices[i];
+    }
+
+    BlockWriter writer(out);
+    writer.write(0x03, 5);
+    for (GLuint e = 0; e < 2; e++)
+      for (GLuint c = 0; c < 3; c++)
+        writer.write(endpoints[e][c], 10);
+    writer.write(indices[0], 3);
+    for (GLuint i = 1; i < 16; i++)
+      writer.write(indices[i], 4);
+  }
+
+  //----------------------------------------------------------------------------
+  // Level encoding.
+  //----------------------------------------------------------------------------
+  // Encode a level into blocks. Blocks which hang over the edge of the level
+  // repeat the last row or column. The encoders work on LDR texels in
+  // [0, 255].
+  static void
+  encodeLevel(const MipLevel &level, bool isHDR, TextureCompression format,
+              std::vector<unsigned char> &outBlocks)
+  {
+    const GLfloat scale = isHDR ? 1.0f : 255.0f;
+    const GLuint blockSize = TextureCooker::getBlockSize(format);
+    const GLuint blocksX = (level.width + 3) / 4;
+    const GLuint blocksY = (level.height + 3) / 4;
+    outBlocks.resize(blocksX * blocksY * blockSize);
+
+    GLfloat block[16][4];
+    for (GLuint by = 0; by < blocksY; by++)
+    {
+      for (GLuint bx = 0; bx < blocksX; bx++)
+      {
+        for (GLuint i = 0; i < 16; i++)
+        {
+          GLuint x = std::min(4 * bx + (i % 4), level.width - 1);
+          GLuint y = std::min(4 * by + (i / 4), level.height - 1);
+          for (GLuint c = 0; c < 4; c++)
+            block[i][c] = scale * level.texels[4 * (y * level.width + x) + c];
+        }
+
+        unsigned char* out = &outBlocks[(by * blocksX + bx) * blockSize];
+        switch (format)
+        {
+          case TextureCompression::BC1:
+            encodeBC1(block, out);
+            break;
+          case TextureCompression::BC3:
+            encodeBC4(block, 3, out);
+            encodeBC1(block, out + 8);
+            break;
+          case TextureCompression::BC4:
+            encodeBC4(block, 0, out);
+            break;
+          case TextureCompression::BC5:
+            encodeBC4(block, 0, out);
+            encodeBC4(block, 1, out + 8);
+            break;
+          case TextureCompression::BC6H:
+            encodeBC6H(block, out);
+            break;
+          case TextureCompression::BC7:
+            encodeBC7(block, out);
+            break;
+          default:
+            break;
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // DDS containers.
+  //----------------------------------------------------------------------------
+  static const GLuint ddsMagic = 0x20534444; // "DDS "
+  static const GLuint ddsFourCCDX10 = 0x30315844; // "DX10"
+
+  static GLuint
+  getDXGIFormat(TextureCompression format)
+  {
+    switch (format)
+    {
+      case TextureCompression::BC1: return 71;
+      case TextureCompression::BC3: return 77;
+      case TextureCompression::BC4: return 80;
+      case TextureCompression::BC5: return 83;
+      case TextureCompression::BC6H: return 95;
+      case TextureCompression::BC7: return 98;
+      default: return 0;
+    }
+  }
+
+  static TextureCompression
+  getFormatFromDXGI(GLuint dxgiFormat)
+  {
+    switch (dxgiFormat)
+    {
+      case 71: return TextureCompression::BC1;
+      case 77: return TextureCompression::BC3;
+      case 80: return TextureCompression::BC4;
+      case 83: return TextureCompression::BC5;
+      case 95: return TextureCompression::BC6H;
+      case 98: return TextureCompression::BC7;
+      default: return TextureCompression::None;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Texture cooking.
+  //----------------------------------------------------------------------------
+  TextureCompression
+  TextureCooker::resolveFormat(TextureCompression requested, int n, bool isHDR)
+  {
+    if (requested == TextureCompression::None)
+      return TextureCompression::None;
+
+    // BC6H is the only HDR format, and it can only hold RGB.
+    if (isHDR)
+    {
+      if (n >= 3 && (requested == TextureCompression::Auto
+                     || requested == TextureCompression::BC6H))
+        return TextureCompression::BC6H;
+      return TextureCompression::None;
+    }
+
+    if (requested == TextureCompression::BC6H)
+      return TextureCompression::None;
+
+    if (requested == TextureCompression::Auto)
+    {
+      if (n == 1)
+        return TextureCompression::BC4;
+      else if (n == 2)
+        return TextureCompression::BC5;
+      else
+        return TextureCompression::BC7;
+    }
+
+    return requested;
+  }
+
+  GLenum
+  TextureCooker::getGLFormat(TextureCompression format)
+  {
+    switch (format)
+    {
+      case TextureCompression::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      case TextureCompression::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      case TextureCompression::BC4: return GL_COMPRESSED_RED_RGTC1;
+      case TextureCompression::BC5: return GL_COMPRESSED_RG_RGTC2;
+      case TextureCompression::BC6H: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+      case TextureCompression::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+      default: return 0;
+    }
+  }
+
+  GLuint
+  TextureCooker::getBlockSize(TextureCompression format)
+  {
+    switch (format)
+    {
+      case TextureCompression::BC1:
+      case TextureCompression::BC4:
+        return 8;
+      case TextureCompression::BC3:
+      case TextureCompression::BC5:
+      case TextureCompression::BC6H:
+      case TextureCompression::BC7:
+        return 16;
+      default:
+        return 0;
+    }
+  }
+
+  int
+  TextureCooker::getNumChannels(TextureCompression format)
+  {
+    switch (format)
+    {
+      case TextureCompression::BC4: return 1;
+      case TextureCompression::BC5: return 2;
+      case TextureCompression::BC1:
+      case TextureCompression::BC6H:
+        return 3;
+      default:
+        return 4;
+    }
+  }
+
+  GLuint
+  TextureCooker::getNumMips(GLuint width, GLuint height)
+  {
+    GLuint numMips = 1;
+    while (width > 1 || height > 1)
+    {
+      width = std::max(width / 2, 1u);
+      height = std::max(height / 2, 1u);
+      numMips++;
+    }
+    return numMips;
+  }
+
+  GLuint
+  TextureCooker::getLevelSize(TextureCompression format, GLuint width, GLuint height,
+                              GLuint level)
+  {
+    width = std::max(width >> level, 1u);
+    height = std::max(height >> level, 1u);
+    return ((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+  }
+
+  bool
+  TextureCooker::cookImage(MipLevel &&baseLevel, TextureMipFilter filter, bool isSRGB,
+                           bool isHDR, TextureCompression format, CompressedImage &outImage)
+  {
+    if (baseLevel.texels.empty() || getBlockSize(format) == 0
+        || isHDR != (format == TextureCompression::BC6H))
+      return false;
+
+    outImage.format = format;
+    outImage.width = baseLevel.width;
+    outImage.height = baseLevel.height;
+    outImage.firstMip = 0;
+    outImage.mips.resize(getNumMips(baseLevel.width, baseLevel.height));
+
+    MipGenerator::generateMips(std::move(baseLevel), filter, isSRGB, isHDR,
+                               [&](GLuint index, const MipLevel &level)
+    {
+      encodeLevel(level, isHDR, format, outImage.mips[index]);
+    });
+
+    return true;
+  }
+
+  std::string
+  TextureCooker::getCookedPath(const std::string &sourcePath, const Texture2DParams &params)
+  {
+    auto cache = AssetCache::getInstance();
+
+    // Bump the version whenever the cooker's output changes.
+    std::string settings = "Texture2D:1:" + std::to_string(static_cast<int>(params.compression))
+                         + ":" + std::to_string(static_cast<int>(params.mipFilter))
+                         + ":" + std::to_string(params.isSRGB);
+
+    std::string key = cache->getKey(sourcePath, settings);
+    if (key == "")
+      return "";
+
+    if (params.compression == TextureCompression::None)
+      return cache->getPath(key, ".mips");
+    else
+      return cache->getPath(key, ".dds");
+  }
+
+  // The headers are written as little endian words, like the rest of the
+  // engine this assumes a little endian host.
+  bool
+  TextureCooker::writeDDS(const std::string &filepath, const CompressedImage &image)
+  {
+    if (image.mips.empty() || getDXGIFormat(image.format) == 0)
+      return false;
+
+    GLuint header[32];
+    memset(header, 0, sizeof(header));
+    header[0] = ddsMagic;
+    header[1] = 124;
+    // Caps, height, width, pixel format, mip count and linear size.
+    header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+    header[3] = image.height;
+    header[4] = image.width;
+    header[5] = image.mips[0].size();
+    header[7] = image.mips.size();
+    // Pixel format, the real format is in the DX10 header.
+    header[19] = 32;
+    header[20] = 0x4;
+    header[21] = ddsFourCCDX10;
+    // Complex texture with mipmaps.
+    header[27] = 0x8 | 0x1000 | 0x400000;
+
+    // DXGI format, 2D texture, no flags, one array slice, unknown alpha mode.
+    GLuint dx10Header[5] = { getDXGIFormat(image.format), 3, 0, 1, 0 };
+
+    // Write to a temporary file first so a partially written file is never
+    // picked up by another load.
+    auto cache = AssetCache::getInstance();
+    std::string tempPath = cache->getTempPath(filepath);
+    std::ofstream output(tempPath, std::ios::binary);
+    if (!output.is_open())
+      return false;
+
+    output.write(reinterpret_cast<const char*>(header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(dx10Header), sizeof(dx10Header));
+    for (auto& mip : image.mips)
+      output.write(reinterpret_cast<const char*>(mip.data()), mip.size());
+    output.close();
+
+    if (!output)
+    {
+      std::error_code error;
+      std::filesystem::remove(tempPath, error);
+      return false;
+    }
+
+    return cache->commitFile(tempPath, filepath);
+  }
+
+  bool
+  TextureCooker::readDDS(const std::string &filepath, CompressedImage &outImage,
+                         GLuint firstMip, GLuint lastMip)
+  {
+    std::ifstream input(filepath, std::ios::binary);
+    if (!input.is_open())
+      return false;
+
+    GLuint header[32];
+    GLuint dx10Header[5];
+    input.read(reinterpret_cast<char*>(header), sizeof(header));
+    input.read(reinterpret_cast<char*>(dx10Header), sizeof(dx10Header));
+    if (!input || header[0] != ddsMagic || header[21] != ddsFourCCDX10)
+      return false;
+
+    outImage.format = getFormatFromDXGI(dx10Header[0]);
+    outImage.height = header[3];
+    outImage.width = header[4];
+    GLuint numMips = std::max(header[7], 1u);
+    if (outImage.format == TextureCompression::None || outImage.width == 0
+        || outImage.height == 0)
+      return false;
+
+    lastMip = std::min(lastMip, numMips);
+    if (firstMip >= lastMip)
+      return false;
+
+    // Skip the levels before the first requested one.
+    std::streamoff skip = 0;
+    for (GLuint i = 0; i < firstMip; i++)
+      skip += getLevelSize(outImage.format, outImage.width, outImage.height, i);
+    input.seekg(skip, std::ios::cur);
+
+    outImage.firstMip = firstMip;
+    outImage.mips.resize(lastMip - firstMip);
+    for (GLuint i = firstMip; i < lastMip; i++)
+    {
+      auto& mip = outImage.mips[i - firstMip];
+      mip.resize(getLevelSize(outImage.format, outImage.width, outImage.height, i));
+      input.read(reinterpret_cast<char*>(mip.data()), mip.size());
+    }
+
+    return static_cast<bool>(input);
+  }
+}
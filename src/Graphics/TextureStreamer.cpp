@@ -0,0 +1,345 @@
+#include "Graphics/TextureStreamer.h"
+
+// Project includes.
+#include "Core/Logs.h"
+#include "Core/ThreadPool.h"
+
+namespace SciRenderer
+{
+  // Levels of this size and smaller are always resident.
+  static const GLuint streamingTailSize = 128;
+
+  // Textures which haven't been requested for this many frames drop back to
+  // their tail.
+  static const GLuint64 streamingIdleFrames = 120;
+
+  TextureStreamer* TextureStreamer::instance = nullptr;
+
+  TextureStreamer::TextureStreamer()
+    : frame(0)
+    , nextRequest(1)
+  { }
+
+  TextureStreamer*
+  TextureStreamer::getInstance()
+  {
+    if (instance == nullptr)
+    {
+      instance = new TextureStreamer();
+      return instance;
+    }
+    else
+      return instance;
+  }
+
+  GLuint
+  TextureStreamer::getTailMip(GLuint width, GLuint height)
+  {
+    GLuint level = 0;
+    while (std::max(width >> level, 1u) > streamingTailSize
+           || std::max(height >> level, 1u) > streamingTailSize)
+      level++;
+
+    return level;
+  }
+
+  void
+  TextureStreamer::addTexture(Texture2D* texture, const std::string &cookedPath,
+                              TextureCompression format, GLuint residentMip)
+  {
+    StreamedTexture state;
+    state.cookedPath = cookedPath;
+    state.format = format;
+    state.width = texture->width;
+    state.height = texture->height;
+    state.numMips = TextureCooker::getNumMips(state.width, state.height);
+    state.residentMip = residentMip;
+    state.tailMip = std::min(getTailMip(state.width, state.height), state.numMips - 1);
+    state.requestedMip = state.numMips;
+    state.wantedMip = state.tailMip;
+    state.lastRequestFrame = this->frame;
+    state.pendingMip = state.numMips;
+    state.pendingRequest = 0;
+
+    this->textures[texture] = state;
+    texture->isStreamed() = true;
+  }
+
+  void
+  TextureStreamer::removeTexture(Texture2D* texture)
+  {
+    // Reads which are still in flight are dropped once they complete.
+    this->textures.erase(texture);
+  }
+
+  StreamedTexture*
+  TextureStreamer::getTexture(Texture2D* texture)
+  {
+    auto loc = this->textures.find(texture);
+    if (loc != this->textures.end())
+      return &loc->second;
+    else
+      return nullptr;
+  }
+
+  void
+  TextureStreamer::requestMip(Texture2D* texture, GLuint mip)
+  {
+    StreamedTexture* state = this->getTexture(texture);
+    if (!state)
+      return;
+
+    state->requestedMip = std::min(state->requestedMip, std::min(mip, state->tailMip));
+    state->lastRequestFrame = this->frame;
+  }
+
+  void
+  TextureStreamer::requestScreenSize(Texture2D* texture, GLfloat screenSize)
+  {
+    StreamedTexture* state = this->getTexture(texture);
+    if (!state)
+      return;
+
+    // Assume the UVs span the surface once, one texel per pixel is then the
+    // level whose size matches the screen size.
+    GLfloat texels = (GLfloat) std::max(state->width, state->height);
+    GLfloat level = std::floor(std::log2(texels / std::max(screenSize, 1.0f)));
+
+    this->requestMip(texture, (GLuint) std::max(level, 0.0f));
+  }
+
+  GLuint64
+  TextureStreamer::getResidentBytes(const StreamedTexture &texture)
+  {
+    GLuint64 bytes = 0;
+    for (GLuint i = texture.residentMip; i < texture.numMips; i++)
+      bytes += TextureCooker::getLevelSize(texture.format, texture.width, texture.height, i);
+    return bytes;
+  }
+
+  GLuint64
+  TextureStreamer::getTotalResidentBytes()
+  {
+    GLuint64 bytes = 0;
+    for (auto& pair : this->textures)
+      bytes += this->getResidentBytes(pair.second);
+    return bytes;
+  }
+
+  GLuint64
+  TextureStreamer::getTotalFullBytes()
+  {
+    GLuint64 bytes = 0;
+    for (auto& pair : this->textures)
+    {
+      for (GLuint i = 0; i < pair.second.numMips; i++)
+      {
+        bytes += TextureCooker::getLevelSize(pair.second.format, pair.second.width,
+                                             pair.second.height, i);
+      }
+    }
+    return bytes;
+  }
+
+  GLuint
+  TextureStreamer::update(GLuint uploadBudget, GLuint64 vramBudget)
+  {
+    Logger* logs = Logger::getInstance();
+
+    // Upload the levels which were read since the last frame. At least one read
+    // is uploaded per frame while there's budget left.
+    GLuint uploadedBytes = 0;
+    {
+      std::lock_guard<std::mutex> readGuard(this->readMutex);
+      while (!this->completedReads.empty())
+      {
+        StreamedMips& read = this->completedReads.front();
+
+        GLuint readBytes = 0;
+        for (auto& mip : read.image.mips)
+          readBytes += mip.size();
+
+        if (uploadBudget == 0 || (uploadedBytes > 0 && uploadedBytes + readBytes > uploadBudget))
+          break;
+
+        StreamedTexture* state = this->getTexture(read.texture);
+        if (state && state->pendingRequest == read.request)
+        {
+          const GLuint lastMip = read.image.firstMip + read.image.mips.size();
+          if (read.image.mips.empty())
+          {
+            // Stop streaming textures whose cooked file can't be read.
+            logs->logMessage(LogMessage("Failed to stream mips from: " + state->cookedPath + ".",
+                                        true, true));
+            state->tailMip = state->residentMip;
+          }
+          else if (read.image.firstMip < state->residentMip && lastMip >= state->residentMip)
+          {
+            this->rebuildTexture(read.texture, *state, read.image.firstMip, &read.image);
+            uploadedBytes += readBytes;
+          }
+          state->pendingMip = state->numMips;
+          state->pendingRequest = 0;
+        }
+
+        this->completedReads.pop();
+      }
+    }
+
+    // Pick the finest level to keep for each texture. Textures which are in
+    // use keep the levels they have, textures which haven't been used in a
+    // while drop back to their tail.
+    std::vector<std::pair<Texture2D*, GLuint>> targets;
+    GLuint64 totalBytes = 0;
+    for (auto& [texture, state] : this->textures)
+    {
+      if (state.lastRequestFrame == this->frame && state.requestedMip < state.numMips)
+        state.wantedMip = state.requestedMip;
+      state.requestedMip = state.numMips;
+
+      GLuint target;
+      if (this->frame - state.lastRequestFrame > streamingIdleFrames)
+        target = state.tailMip;
+      else
+        target = std::min(state.wantedMip, state.residentMip);
+
+      for (GLuint i = target; i < state.numMips; i++)
+        totalBytes += TextureCooker::getLevelSize(state.format, state.width, state.height, i);
+      targets.emplace_back(texture, target);
+    }
+
+    // Drop levels until everything fits. Levels finer than what was asked for
+    // go first, then levels of the textures which were used least recently,
+    // then the finest levels.
+    while (totalBytes > vramBudget)
+    {
+      GLint victim = -1;
+      for (GLuint i = 0; i < targets.size(); i++)
+      {
+        StreamedTexture& state = this->textures[targets[i].first];
+        if (targets[i].second >= state.tailMip)
+          continue;
+
+        if (victim < 0)
+        {
+          victim = i;
+          continue;
+        }
+
+        StreamedTexture& best = this->textures[targets[victim].first];
+        bool isExcess = targets[i].second < state.wantedMip;
+        bool bestIsExcess = targets[victim].second < best.wantedMip;
+        if (isExcess != bestIsExcess)
+        {
+          if (isExcess)
+            victim = i;
+        }
+        else if (state.lastRequestFrame != best.lastRequestFrame)
+        {
+          if (state.lastRequestFrame < best.lastRequestFrame)
+            victim = i;
+        }
+        else if (targets[i].second < targets[victim].second)
+          victim = i;
+      }
+
+      if (victim < 0)
+        break;
+
+      StreamedTexture& state = this->textures[targets[victim].first];
+      totalBytes -= TextureCooker::getLevelSize(state.format, state.width, state.height,
+                                                targets[victim].second);
+      targets[victim].second++;
+    }
+
+    // Evict immediately, load on the workers.
+    auto workerGroup = ThreadPool::getInstance(2);
+    for (auto& [texture, target] : targets)
+    {
+      StreamedTexture& state = this->textures[texture];
+
+      if (target > state.residentMip)
+      {
+        this->rebuildTexture(texture, state, target);
+        state.pendingMip = state.numMips;
+        state.pendingRequest = 0;
+      }
+      else if (target < state.residentMip && state.pendingMip == state.numMips)
+      {
+        state.pendingMip = target;
+        state.pendingRequest = this->nextRequest++;
+
+        auto readerImpl = [this](Texture2D* texture, const std::string &cookedPath,
+                                 GLuint firstMip, GLuint lastMip, GLuint64 request)
+        {
+          StreamedMips read;
+          read.texture = texture;
+          read.request = request;
+          if (!TextureCooker::readDDS(cookedPath, read.image, firstMip, lastMip))
+            read.image.mips.clear();
+
+          std::lock_guard<std::mutex> readGuard(this->readMutex);
+          this->completedReads.push(std::move(read));
+        };
+        workerGroup->push(readerImpl, texture, state.cookedPath, target,
+                          state.residentMip, state.pendingRequest);
+      }
+    }
+
+    this->frame++;
+
+    return uploadedBytes;
+  }
+
+  void
+  TextureStreamer::rebuildTexture(Texture2D* texture, StreamedTexture &state,
+                                  GLuint newResidentMip, const CompressedImage* mips)
+  {
+    const GLenum format = TextureCooker::getGLFormat(state.format);
+
+    GLuint newID;
+    glGenTextures(1, &newID);
+    glBindTexture(GL_TEXTURE_2D, newID);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
+                    static_cast<GLint>(texture->params.sWrap));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+                    static_cast<GLint>(texture->params.tWrap));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    static_cast<GLint>(texture->params.minFilter));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+                    static_cast<GLint>(texture->params.maxFilter));
+
+    // Level 0 of the new texture is newResidentMip of the cooked chain, the
+    // UVs are normalized so the lower resolution doesn't matter to shaders.
+    glTexStorage2D(GL_TEXTURE_2D, state.numMips - newResidentMip, format,
+                   std::max(state.width >> newResidentMip, 1u),
+                   std::max(state.height >> newResidentMip, 1u));
+
+    for (GLuint level = newResidentMip; level < state.numMips; level++)
+    {
+      GLuint levelWidth = std::max(state.width >> level, 1u);
+      GLuint levelHeight = std::max(state.height >> level, 1u);
+
+      if (level < state.residentMip)
+      {
+        auto& mip = mips->mips[level - mips->firstMip];
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level - newResidentMip, 0, 0,
+                                  levelWidth, levelHeight, format, mip.size(),
+                                  mip.data());
+      }
+      else
+      {
+        glCopyImageSubData(texture->getID(), GL_TEXTURE_2D, level - state.residentMip, 0, 0, 0,
+                           newID, GL_TEXTURE_2D, level - newResidentMip, 0, 0, 0,
+                           levelWidth, levelHeight, 1);
+      }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture->getID());
+    texture->getID() = newID;
+
+    state.residentMip = newResidentMip;
+  }
+}
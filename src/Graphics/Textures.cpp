@@ -5,10 +5,14 @@
 #include "stb/stb_image_write.h"
 
 // Project includes.
+#include "Core/AssetCache.h"
 #include "Core/Logs.h"
 #include "Core/Events.h"
 #include "Core/AssetManager.h"
 #include "Core/ThreadPool.h"
+#include "Graphics/MipGenerator.h"
+#include "Graphics/TextureCompression.h"
+#include "Graphics/TextureStreamer.h"
 #include "GuiElements/Styles.h"
 
 namespace SciRenderer
@@ -18,93 +22,274 @@ namespace SciRenderer
   //----------------------------------------------------------------------------
   std::queue<ImageData2D> Texture2D::asyncTexQueue;
   std::mutex Texture2D::asyncTexMutex;
+  Unique<PixelUnpackRing> Texture2D::uploadRing = nullptr;
+
+  // Get the OpenGL formats an image is uploaded with. HDR images with 3
+  // channels are expanded to 4 by the loader, GL_RGB16F isn't renderable.
+  static void
+  getUploadFormats(int n, bool isHDR, GLenum &internalFormat, GLenum &format,
+                   GLenum &type, int &uploadChannels)
+  {
+    const GLenum hdrFormats[4] = { GL_R16F, GL_RG16F, GL_RGBA16F, GL_RGBA16F };
+    const GLenum ldrFormats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    const GLenum pixelFormats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+
+    uploadChannels = (isHDR && n == 3) ? 4 : n;
+    internalFormat = isHDR ? hdrFormats[n - 1] : ldrFormats[n - 1];
+    format = pixelFormats[uploadChannels - 1];
+    type = isHDR ? GL_FLOAT : GL_UNSIGNED_BYTE;
+  }
+
+  // Read a cooked image from the asset cache.
+  static bool
+  readCookedImage(const std::string &cookedPath, CompressedImage &outImage)
+  {
+    if (cookedPath == "" || !TextureCooker::readDDS(cookedPath, outImage))
+      return false;
+
+    AssetCache::getInstance()->touch(cookedPath);
+    return true;
+  }
+
+  // Uncompressed images are cached as their packed mip chain: the size,
+  // channels and level sizes of the image followed by the levels back to back.
+  static const GLuint mipChainMagic = 0x4350494D;
+
+  static bool
+  readCachedMips(const std::string &cookedPath, ImageData2D &outImage,
+                 std::vector<unsigned char> &outBlob, size_t &outPixelOffset)
+  {
+    if (cookedPath == "" || !AssetCache::getInstance()->readBlob(cookedPath, outBlob))
+      return false;
+
+    BlobReader reader(outBlob);
+    GLuint magic, numMips;
+    if (!reader.read(magic) || magic != mipChainMagic || !reader.read(outImage.width)
+        || !reader.read(outImage.height) || !reader.read(outImage.n)
+        || !reader.read(numMips) || outImage.n < 1 || outImage.n > 4)
+      return false;
+
+    outImage.dataSize = 0;
+    for (GLuint i = 0; i < numMips; i++)
+    {
+      GLuint levelSize;
+      if (!reader.read(levelSize))
+        return false;
+
+      outImage.mipOffsets.push_back(outImage.dataSize);
+      outImage.mipSizes.push_back(levelSize);
+      outImage.dataSize += levelSize;
+    }
+
+    outPixelOffset = reader.offset;
+    return numMips > 0 && reader.remaining() == outImage.dataSize;
+  }
+
+  static void
+  writeCachedMips(const std::string &cookedPath, const ImageData2D &image,
+                  const unsigned char* pixels)
+  {
+    BlobWriter writer;
+    writer.write(mipChainMagic);
+    writer.write(image.width);
+    writer.write(image.height);
+    writer.write(image.n);
+    writer.write<GLuint>(image.mipSizes.size());
+    for (auto& levelSize : image.mipSizes)
+      writer.write(levelSize);
+    writer.writeBytes(pixels, image.dataSize);
+
+    AssetCache::getInstance()->writeBlob(cookedPath, writer.bytes);
+  }
+
+  // Decoded HDR images are cached as floats, parsing RGBE is most of the time
+  // spent loading an environment map.
+  static const GLuint decodedHDRMagic = 0x46524448;
+
+  static bool
+  readDecodedHDR(const std::string &decodedPath, std::vector<unsigned char> &outBlob,
+                 int &width, int &height, int &n, float* &outData)
+  {
+    if (decodedPath == "" || !AssetCache::getInstance()->readBlob(decodedPath, outBlob))
+      return false;
+
+    BlobReader reader(outBlob);
+    GLuint magic;
+    if (!reader.read(magic) || magic != decodedHDRMagic || !reader.read(width)
+        || !reader.read(height) || !reader.read(n) || n < 1 || n > 4
+        || reader.remaining() != (size_t) width * height * n * sizeof(float))
+      return false;
+
+    outData = reinterpret_cast<float*>(outBlob.data() + reader.offset);
+    return true;
+  }
+
+  static void
+  writeDecodedHDR(const std::string &decodedPath, int width, int height, int n,
+                  const float* data)
+  {
+    BlobWriter writer;
+    writer.write(decodedHDRMagic);
+    writer.write(width);
+    writer.write(height);
+    writer.write(n);
+    writer.writeBytes(data, (size_t) width * height * n * sizeof(float));
+
+    AssetCache::getInstance()->writeBlob(decodedPath, writer.bytes);
+  }
+
+  // Lay the levels of a cooked image from firstMip down out back to back,
+  // returns the total size in bytes.
+  static GLuint
+  packCookedMips(const CompressedImage &image, GLuint firstMip,
+                 std::vector<GLuint> &outOffsets, std::vector<GLuint> &outSizes)
+  {
+    GLuint totalSize = 0;
+    for (GLuint i = firstMip - image.firstMip; i < image.mips.size(); i++)
+    {
+      outOffsets.push_back(totalSize);
+      outSizes.push_back(image.mips[i].size());
+      totalSize += image.mips[i].size();
+    }
+    return totalSize;
+  }
+
+  // Upload the levels from firstMip down of a cooked image to the bound
+  // texture, firstMip becomes level 0 of the texture. Level firstMip + i is at
+  // base + mipOffsets[i], where base is either a client pointer or an offset
+  // into the bound pixel unpack buffer.
+  static void
+  uploadCompressedMips(TextureCompression compression, GLuint width, GLuint height,
+                       GLuint firstMip, uintptr_t base,
+                       const std::vector<GLuint> &mipOffsets,
+                       const std::vector<GLuint> &mipSizes)
+  {
+    GLenum format = TextureCooker::getGLFormat(compression);
+    width = std::max(width >> firstMip, 1u);
+    height = std::max(height >> firstMip, 1u);
+
+    glTexStorage2D(GL_TEXTURE_2D, mipSizes.size(), format, width, height);
+    for (GLuint i = 0; i < mipSizes.size(); i++)
+    {
+      glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, width, height, format, mipSizes[i],
+                                reinterpret_cast<const void*>(base + mipOffsets[i]));
+      width = std::max(width / 2, 1u);
+      height = std::max(height / 2, 1u);
+    }
+  }
 
   void
-  Texture2D::bulkGenerateTextures()
+  Texture2D::initAsyncUploads(GLuint ringSize)
+  {
+    uploadRing = createUnique<PixelUnpackRing>(ringSize);
+  }
+
+  void
+  Texture2D::shutdownUploads()
+  {
+    std::lock_guard<std::mutex> imageGuard(asyncTexMutex);
+
+    // Images still queued were staged in the ring, they'll never be uploaded.
+    while (!asyncTexQueue.empty())
+    {
+      ImageData2D& image = asyncTexQueue.front();
+      if (!image.isStaged && image.data)
+        free(image.data);
+      asyncTexQueue.pop();
+    }
+
+    uploadRing.reset();
+  }
+
+  GLuint
+  Texture2D::bulkGenerateTextures(GLuint uploadBudget)
   {
     std::lock_guard<std::mutex> imageGuard(asyncTexMutex);
 
     Logger* logs = Logger::getInstance();
     auto textureCache = AssetManager<Texture2D>::getManager();
 
+    // Recycle the staging regions of the copies which have completed.
+    if (uploadRing)
+      uploadRing->retire();
+
+    // Rows of 1-3 channel byte images aren't 4 byte aligned.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // At least one image is uploaded per frame while there's budget left, so
+    // images larger than the budget still load.
+    GLuint uploadedBytes = 0;
     while (!asyncTexQueue.empty())
     {
       ImageData2D& image = asyncTexQueue.front();
 
+      if (uploadBudget == 0 || (uploadedBytes > 0 && uploadedBytes + image.dataSize > uploadBudget))
+        break;
+
       Texture2D* outTex = new Texture2D(image.width, image.height, image.n, image.params);
       outTex->bind();
       outTex->getFilepath() = image.filepath;
 
       // Generate a 2D texture. Currently supports both bytes and floating point
-      // HDR images!
-      if (outTex->n == 1)
+      // HDR images! Staged images are copied out of the ring by the driver.
+      GLenum internalFormat, format, type;
+      int uploadChannels;
+      getUploadFormats(image.n, image.isHDR, internalFormat, format, type, uploadChannels);
+
+      uintptr_t pixels = reinterpret_cast<uintptr_t>(image.data);
+      if (image.isStaged)
       {
-        if (image.isHDR)
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, image.width, image.height, 0,
-                       GL_RED, GL_FLOAT, image.data);
-        else
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, image.width, image.height, 0,
-                       GL_RED, GL_UNSIGNED_BYTE, image.data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        uploadRing->bind();
+        pixels = image.stagingOffset;
       }
-      else if (outTex->n == 2)
+
+      // Cooked images already have their mips, only the tail is uploaded and
+      // the streamer brings in the finer levels as they're needed.
+      if (image.compression != TextureCompression::None)
       {
-        if (image.isHDR)
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, image.width, image.height, 0,
-                       GL_RG, GL_FLOAT, image.data);
-        else
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_RG, image.width, image.height, 0,
-                       GL_RG, GL_UNSIGNED_BYTE, image.data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        uploadCompressedMips(image.compression, image.width, image.height,
+                             image.firstMip, pixels, image.mipOffsets, image.mipSizes);
+        if (image.firstMip > 0)
+        {
+          TextureStreamer::getInstance()->addTexture(outTex, image.cookedPath,
+                                                     image.compression, image.firstMip);
+        }
       }
-      else if (outTex->n == 3)
+      else
       {
-        // If its HDR, needs to be GL_RGBA16F instead of GL_RGB16F. Thanks OpenGL....
-        if (image.isHDR)
+        // The mip chain was built by the loader.
+        GLuint levelWidth = image.width;
+        GLuint levelHeight = image.height;
+        for (GLuint i = 0; i < image.mipSizes.size(); i++)
         {
-          float* dataFNew;
-          dataFNew = new float[image.width * image.height * 4];
-          GLuint offset = 0;
-
-          for (GLuint i = 0; i < (image.width * image.height * 4); i+=4)
-          {
-            // Copy over the data from the image loading.
-            dataFNew[i] = ((float*) image.data)[i - offset];
-            dataFNew[i + 1] = ((float*) image.data)[i + 1 - offset];
-            dataFNew[i + 2] = ((float*) image.data)[i + 2 - offset];
-            // Make the 4th component (alpha) equal to 1.0f. Could make this a param :thinking:.
-            dataFNew[i + 3] = 1.0f;
-            // Increment the offset to we don't segfault. :D
-            offset ++;
-          }
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, image.width, image.height, 0,
-                       GL_RGBA, GL_FLOAT, dataFNew);
-          stbi_image_free(dataFNew);
+          glTexImage2D(GL_TEXTURE_2D, i, internalFormat, levelWidth, levelHeight, 0,
+                       format, type, reinterpret_cast<const void*>(pixels + image.mipOffsets[i]));
+          levelWidth = std::max(levelWidth / 2, 1u);
+          levelHeight = std::max(levelHeight / 2, 1u);
         }
-        else
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0,
-                       GL_RGB, GL_UNSIGNED_BYTE, image.data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.mipSizes.size() - 1);
       }
-      else if (outTex->n == 4)
+
+      if (image.isStaged)
       {
-        if (image.isHDR)
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, image.width, image.height, 0,
-                       GL_RGBA, GL_FLOAT, image.data);
-        else
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0,
-                       GL_RGBA, GL_UNSIGNED_BYTE, image.data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        uploadRing->unbind();
+        uploadRing->fence(image.stagingOffset);
       }
+      else
+        free(image.data);
+      uploadedBytes += image.dataSize;
 
       textureCache->attachAsset(image.name, outTex);
 
       logs->logMessage(LogMessage("Loaded texture: " + image.name + ".",
                                   true, true));
 
-      stbi_image_free(image.data);
       asyncTexQueue.pop();
     }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    return uploadedBytes;
   }
 
   void
@@ -120,21 +305,174 @@ namespace SciRenderer
 
       ImageData2D outImage;
       outImage.isHDR = (filepath.substr(filepath.find_last_of("."), 4) == ".hdr");
+      outImage.isStaged = false;
+      outImage.stagingOffset = 0;
+      outImage.compression = TextureCompression::None;
+      outImage.firstMip = 0;
       outImage.params = params;
       outImage.name = name;
       outImage.filepath = filepath;
-
-      // Load the image.
-      stbi_set_flip_vertically_on_load(true);
-      if (outImage.isHDR)
-        outImage.data = stbi_loadf(filepath.c_str(), &outImage.width, &outImage.height, &outImage.n, 0);
+      outImage.cookedPath = TextureCooker::getCookedPath(filepath, params);
+
+      // Use the cooked image if it's in the asset cache. Otherwise decode the
+      // source and cook it, caching the result for the next load.
+      CompressedImage cooked;
+      std::vector<unsigned char> cachedMips;
+      size_t cachedPixels = 0;
+      bool isCooked = false;
+      bool isCached = false;
+      if (params.compression != TextureCompression::None)
+        isCooked = readCookedImage(outImage.cookedPath, cooked);
       else
-        outImage.data = stbi_load(filepath.c_str(), &outImage.width, &outImage.height, &outImage.n, 0);
+        isCached = readCachedMips(outImage.cookedPath, outImage, cachedMips, cachedPixels);
+
+      if (!isCooked && !isCached)
+      {
+        auto decodeStart = std::chrono::steady_clock::now();
+
+        void* decoded;
+        stbi_set_flip_vertically_on_load(true);
+        if (outImage.isHDR)
+          decoded = stbi_loadf(filepath.c_str(), &outImage.width, &outImage.height, &outImage.n, 0);
+        else
+          decoded = stbi_load(filepath.c_str(), &outImage.width, &outImage.height, &outImage.n, 0);
+
+        if (!decoded)
+        {
+          eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
+          return;
+        }
+
+        auto decodeEnd = std::chrono::steady_clock::now();
+
+        // Build the whole mip chain here instead of on the main thread. Each
+        // level is cooked or packed as soon as it's built, so the float
+        // levels never pile up.
+        MipLevel baseLevel;
+        MipGenerator::expandToRGBA(decoded, outImage.width, outImage.height, outImage.n,
+                                   outImage.isHDR, baseLevel);
+        stbi_image_free(decoded);
+
+        GLuint numMips = TextureCooker::getNumMips(outImage.width, outImage.height);
+        TextureCompression format = TextureCooker::resolveFormat(params.compression,
+                                                                 outImage.n, outImage.isHDR);
+        if (format != TextureCompression::None
+            && TextureCooker::cookImage(std::move(baseLevel), params.mipFilter, params.isSRGB,
+                                        outImage.isHDR, format, cooked))
+        {
+          // Finer levels can only be streamed from a cooked file on disk.
+          if (!TextureCooker::writeDDS(outImage.cookedPath, cooked))
+            outImage.cookedPath = "";
+          isCooked = true;
+        }
+        else
+        {
+          GLenum internalFormat, glFormat, type;
+          int uploadChannels;
+          getUploadFormats(outImage.n, outImage.isHDR, internalFormat, glFormat, type,
+                           uploadChannels);
+
+          // Lay the levels out back to back.
+          outImage.dataSize = 0;
+          GLuint levelWidth = outImage.width;
+          GLuint levelHeight = outImage.height;
+          for (GLuint i = 0; i < numMips; i++)
+          {
+            GLuint levelSize = levelWidth * levelHeight * uploadChannels
+                             * (outImage.isHDR ? sizeof(float) : sizeof(unsigned char));
+            outImage.mipOffsets.push_back(outImage.dataSize);
+            outImage.mipSizes.push_back(levelSize);
+            outImage.dataSize += levelSize;
+            levelWidth = std::max(levelWidth / 2, 1u);
+            levelHeight = std::max(levelHeight / 2, 1u);
+          }
+
+          cachedMips.resize(outImage.dataSize);
+          MipGenerator::generateMips(std::move(baseLevel), params.mipFilter, params.isSRGB,
+                                     outImage.isHDR, [&](GLuint index, const MipLevel &level)
+          {
+            MipGenerator::packLevel(level, uploadChannels, outImage.isHDR,
+                                    cachedMips.data() + outImage.mipOffsets[index]);
+          });
 
-      if (!outImage.data)
+          if (outImage.cookedPath != "")
+            writeCachedMips(outImage.cookedPath, outImage, cachedMips.data());
+        }
+
+        auto mipsEnd = std::chrono::steady_clock::now();
+
+        // Report the decode throughput.
+        GLfloat decodeTime = std::chrono::duration<GLfloat, std::milli>(decodeEnd - decodeStart).count();
+        GLfloat mipTime = std::chrono::duration<GLfloat, std::milli>(mipsEnd - decodeEnd).count();
+        GLfloat decodedMB = (GLfloat) (outImage.width * outImage.height * outImage.n
+                          * (outImage.isHDR ? sizeof(float) : sizeof(unsigned char)))
+                          / (1024.0f * 1024.0f);
+        Logger::getInstance()->logMessage(LogMessage("Decoded " + name + " at "
+          + std::to_string((int) (decodedMB / std::max(decodeTime / 1000.0f, 1e-6f)))
+          + " MB/s (" + std::to_string((int) decodeTime) + " ms), built and packed "
+          + std::to_string(numMips) + " mips in " + std::to_string((int) mipTime)
+          + " ms.", true, true));
+      }
+
+      if (isCooked)
+      {
+        outImage.compression = cooked.format;
+        outImage.width = cooked.width;
+        outImage.height = cooked.height;
+        outImage.n = TextureCooker::getNumChannels(cooked.format);
+        outImage.firstMip = 0;
+        if (outImage.cookedPath != "")
+        {
+          outImage.firstMip = TextureStreamer::getTailMip(cooked.width, cooked.height);
+          outImage.firstMip = std::min<GLuint>(outImage.firstMip, cooked.mips.size() - 1);
+        }
+
+        outImage.dataSize = packCookedMips(cooked, outImage.firstMip, outImage.mipOffsets,
+                                           outImage.mipSizes);
+
+        unsigned char* staging = nullptr;
+        if (uploadRing)
+          staging = static_cast<unsigned char*>(uploadRing->reserve(outImage.dataSize,
+                                                                    outImage.stagingOffset));
+
+        if (staging)
+        {
+          outImage.isStaged = true;
+          outImage.data = nullptr;
+        }
+        else
+        {
+          outImage.data = malloc(outImage.dataSize);
+          staging = static_cast<unsigned char*>(outImage.data);
+        }
+
+        for (GLuint i = 0; i < outImage.mipSizes.size(); i++)
+        {
+          memcpy(staging + outImage.mipOffsets[i], cooked.mips[outImage.firstMip + i].data(),
+                 outImage.mipSizes[i]);
+        }
+      }
+      else
       {
-        stbi_image_free(outImage.data);
-        return;
+        // Copy the pixels straight into the upload ring if there's space,
+        // otherwise keep them in client memory.
+        unsigned char* staging = nullptr;
+        if (uploadRing)
+          staging = static_cast<unsigned char*>(uploadRing->reserve(outImage.dataSize,
+                                                                    outImage.stagingOffset));
+
+        if (staging)
+        {
+          outImage.isStaged = true;
+          outImage.data = nullptr;
+        }
+        else
+        {
+          outImage.data = malloc(outImage.dataSize);
+          staging = static_cast<unsigned char*>(outImage.data);
+        }
+
+        memcpy(staging, cachedMips.data() + cachedPixels, outImage.dataSize);
       }
 
       std::lock_guard<std::mutex> imageGuard(asyncTexMutex);
@@ -246,18 +584,71 @@ namespace SciRenderer
 
     std::string name = filepath.substr(filepath.find_last_of('/') + 1);
 
+    if (cache && textureCache->hasAsset(name))
+    {
+      logs->logMessage(LogMessage("Fetched texture at: " + name + ".",
+                                  true, true));
+      return textureCache->getAsset(name);
+    }
+
+    // Upload the cooked image directly if there is one.
+    auto assetCache = AssetCache::getInstance();
+    CompressedImage cooked;
+    if (params.compression != TextureCompression::None
+        && readCookedImage(TextureCooker::getCookedPath(filepath, params), cooked))
+    {
+      Texture2D* outTex = new Texture2D(cooked.width, cooked.height,
+                                        TextureCooker::getNumChannels(cooked.format),
+                                        params);
+      if (cache)
+        textureCache->attachAsset(name, outTex);
+      outTex->bind();
+
+      std::vector<GLuint> mipOffsets, mipSizes;
+      std::vector<unsigned char> blocks(packCookedMips(cooked, 0, mipOffsets, mipSizes));
+      for (GLuint i = 0; i < cooked.mips.size(); i++)
+        memcpy(blocks.data() + mipOffsets[i], cooked.mips[i].data(), mipSizes[i]);
+
+      uploadCompressedMips(cooked.format, cooked.width, cooked.height, 0,
+                           reinterpret_cast<uintptr_t>(blocks.data()),
+                           mipOffsets, mipSizes);
+
+      logs->logMessage(LogMessage("Loaded cooked texture at: " + filepath + ".",
+                                  true, true));
+
+      outTex->getFilepath() = filepath;
+      return outTex;
+    }
+
     // The data.
     float* dataF;
     unsigned char* dataU;
 
     int width, height, n;
 
-    // Load the texture.
-    stbi_set_flip_vertically_on_load(true);
+    // Load the texture, HDR images come from the asset cache if possible.
+    std::string decodedPath;
     if (isHDR)
-      dataF = stbi_loadf(filepath.c_str(), &width, &height, &n, 0);
-    else
-      dataU = stbi_load(filepath.c_str(), &width, &height, &n, 0);
+    {
+      std::string key = assetCache->getKey(filepath, "DecodedHDR:1");
+      if (key != "")
+        decodedPath = assetCache->getPath(key, ".hdrf");
+    }
+
+    std::vector<unsigned char> decodedBlob;
+    bool isDecodeCached = isHDR && readDecodedHDR(decodedPath, decodedBlob, width,
+                                                  height, n, dataF);
+    if (!isDecodeCached)
+    {
+      stbi_set_flip_vertically_on_load(true);
+      if (isHDR)
+        dataF = stbi_loadf(filepath.c_str(), &width, &height, &n, 0);
+      else
+        dataU = stbi_load(filepath.c_str(), &width, &height, &n, 0);
+
+      if (isHDR && dataF && decodedPath != "")
+        writeDecodedHDR(decodedPath, width, height, n, dataF);
+    }
 
     // Something went wrong while loading, abort.
     if (!dataU && !isHDR)
@@ -356,9 +747,9 @@ namespace SciRenderer
     }
 
     // Free memory.
-    if (isHDR)
+    if (isHDR && !isDecodeCached)
       stbi_image_free(dataF);
-    else
+    else if (!isHDR)
       stbi_image_free(dataU);
 
     logs->logMessage(LogMessage("Loaded texture at: " + filepath + ".",
@@ -370,6 +761,7 @@ namespace SciRenderer
 
   Texture2D::Texture2D()
     : filepath("")
+    , streamed(false)
   {
     glGenTextures(1, &this->textureID);
     glBindTexture(GL_TEXTURE_2D, this->textureID);
@@ -382,6 +774,7 @@ namespace SciRenderer
     , n(n)
     , params(params)
     , filepath("")
+    , streamed(false)
   {
     glGenTextures(1, &this->textureID);
     glBindTexture(GL_TEXTURE_2D, this->textureID);
@@ -398,6 +791,9 @@ namespace SciRenderer
 
   Texture2D::~Texture2D()
   {
+    if (this->streamed)
+      TextureStreamer::getInstance()->removeTexture(this);
+
     glDeleteTextures(1, &this->textureID);
   }
 
@@ -0,0 +1,164 @@
+#include "Graphics/Transparency.h"
+
+// Project includes.
+#include "Graphics/RendererCommands.h"
+
+namespace SciRenderer
+{
+  // Marks the end of a linked list.
+  static const GLuint invalidNode = 0xFFFFFFFF;
+
+  Transparency::Transparency(GLuint width, GLuint height)
+    : width(width)
+    , height(height)
+    , headPointers(0)
+    , maxNodes(0)
+  {
+    // Accumulated premultiplied colour and weights, and the product of the
+    // transmittances.
+    this->oitBuffer = FrameBuffer(width, height);
+    auto cSpec = FBOCommands::getFloatColourSpec(FBOTargetParam::Colour0);
+    cSpec.sWrap = TextureWrapParams::ClampEdges;
+    cSpec.tWrap = TextureWrapParams::ClampEdges;
+    this->oitBuffer.attachTexture2D(cSpec);
+    cSpec = FBOCommands::getFloatColourSpec(FBOTargetParam::Colour1);
+    cSpec.internal = TextureInternalFormats::R16f;
+    cSpec.format = TextureFormats::Red;
+    cSpec.sWrap = TextureWrapParams::ClampEdges;
+    cSpec.tWrap = TextureWrapParams::ClampEdges;
+    this->oitBuffer.attachTexture2D(cSpec);
+    this->oitBuffer.setDrawBuffers();
+    this->oitBuffer.attachRenderBuffer();
+  }
+
+  Transparency::~Transparency()
+  {
+    this->deleteLists();
+  }
+
+  void
+  Transparency::createLists()
+  {
+    glGenTextures(1, &this->headPointers);
+    glBindTexture(GL_TEXTURE_2D, this->headPointers);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, this->width, this->height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // A node count and capacity, followed by the nodes.
+    this->maxNodes = this->width * this->height * OIT_NODES_PER_PIXEL;
+    this->nodeBuffer = createUnique<ShaderStorageBuffer>(4 * sizeof(GLuint)
+                                                         + this->maxNodes * sizeof(glm::uvec4),
+                                                         BufferType::Dynamic);
+  }
+
+  void
+  Transparency::deleteLists()
+  {
+    if (this->headPointers == 0)
+      return;
+
+    glDeleteTextures(1, &this->headPointers);
+    this->headPointers = 0;
+    this->maxNodes = 0;
+    this->nodeBuffer.reset();
+  }
+
+  void
+  Transparency::resize(GLuint width, GLuint height)
+  {
+    if (this->width == width && this->height == height)
+      return;
+
+    this->width = width;
+    this->height = height;
+
+    // The lists are reallocated at the new size the next time they're used.
+    this->oitBuffer.resize(width, height);
+    this->deleteLists();
+  }
+
+  void
+  Transparency::setMode(OITMode mode)
+  {
+    if (mode == OITMode::LinkedList && this->headPointers == 0)
+      this->createLists();
+    else if (mode != OITMode::LinkedList)
+      this->deleteLists();
+  }
+
+  void
+  Transparency::begin(OITMode mode, GeometryBuffer &gBuffer, const glm::uvec2 &renderSize)
+  {
+    gBuffer.blitzToOther(this->oitBuffer, FBOTargetParam::Depth);
+
+    this->oitBuffer.bind();
+    RendererCommands::setViewport(glm::ivec2(renderSize));
+    RendererCommands::enable(RendererFunction::DepthTest);
+    RendererCommands::disableDepthMask();
+
+    if (mode == OITMode::WeightedBlended)
+    {
+      GLfloat accumClear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+      GLfloat revealClear[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+      glClearBufferfv(GL_COLOR, 0, accumClear);
+      glClearBufferfv(GL_COLOR, 1, revealClear);
+
+      // Sum the weighted colours, multiply the transmittances.
+      RendererCommands::enable(RendererFunction::Blending);
+      RendererCommands::blendEquation(BlendEquation::Additive);
+      RendererCommands::blendFunction(0, BlendFunction::One, BlendFunction::One);
+      RendererCommands::blendFunction(1, BlendFunction::Zero, BlendFunction::OneMinusSrcColour);
+    }
+    else
+    {
+      glClearTexImage(this->headPointers, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &invalidNode);
+      GLuint counters[2] = { 0, this->maxNodes };
+      this->nodeBuffer->setData(0, sizeof(counters), counters);
+
+      // The fragments are stored from the shader, nothing is written to the
+      // targets.
+      RendererCommands::disableColourMask();
+      glBindImageTexture(0, this->headPointers, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+      this->nodeBuffer->bindToPoint(8);
+    }
+  }
+
+  void
+  Transparency::end(OITMode mode)
+  {
+    if (mode == OITMode::WeightedBlended)
+      RendererCommands::disable(RendererFunction::Blending);
+    else
+    {
+      RendererCommands::enableColourMask();
+      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    RendererCommands::enableDepthMask();
+    this->oitBuffer.unbind();
+  }
+
+  void
+  Transparency::bindResults(OITMode mode)
+  {
+    if (mode == OITMode::WeightedBlended)
+    {
+      this->oitBuffer.bindTextureID(FBOTargetParam::Colour0, 0);
+      this->oitBuffer.bindTextureID(FBOTargetParam::Colour1, 1);
+    }
+    else
+    {
+      glBindImageTexture(0, this->headPointers, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+      this->nodeBuffer->bindToPoint(8);
+    }
+  }
+
+  void
+  Transparency::setCompositeBlending()
+  {
+    // Colour + scene * transmittance.
+    RendererCommands::enable(RendererFunction::Blending);
+    RendererCommands::blendEquation(BlendEquation::Additive);
+    RendererCommands::blendFunction(BlendFunction::One, BlendFunction::SrcAlpha);
+  }
+}
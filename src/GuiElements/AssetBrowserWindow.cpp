@@ -2,6 +2,7 @@
 
 // Project includes.
 #include "Core/AssetManager.h"
+#include "Graphics/TextureStreamer.h"
 #include "GuiElements/Styles.h"
 #include "Scenes/Entity.h"
 
@@ -54,6 +55,13 @@ namespace SciRenderer
       return;
     }
 
+    // Residency of the streamed textures.
+    auto streamer = TextureStreamer::getInstance();
+    ImGui::Text("Streamed textures: %u, resident: %.1f MB of %.1f MB",
+                (unsigned int) streamer->getTextures().size(),
+                streamer->getTotalResidentBytes() / (1024.0f * 1024.0f),
+                streamer->getTotalFullBytes() / (1024.0f * 1024.0f));
+
     ImGui::BeginChild("DirTree", ImVec2(256.0f, 0.0f));
     this->drawDirectoryTree();
     ImGui::EndChild();
@@ -304,6 +312,9 @@ namespace SciRenderer
 
     ImVec2 textSize, cursorPos;
 
+    auto textureCache = AssetManager<Texture2D>::getManager();
+    auto streamer = TextureStreamer::getInstance();
+
     // Iterate over the directory and find all the files.
     for (const auto& entry : std::filesystem::directory_iterator(this->currentDir))
     {
@@ -322,6 +333,23 @@ namespace SciRenderer
 
         ImGui::Selectable((std::string("##") + filename).c_str(), false, flags, ImVec2(64.0f, 64.0f));
 
+        // Show the residency of loaded textures which are being streamed.
+        if (ImGui::IsItemHovered() && textureCache->hasAsset(filename))
+        {
+          StreamedTexture* streamed = streamer->getTexture(textureCache->getAsset(filename));
+          if (streamed)
+          {
+            ImGui::BeginTooltip();
+            ImGui::Text("Resident mip: %u (%ux%u)", streamed->residentMip,
+                        std::max(streamed->width >> streamed->residentMip, 1u),
+                        std::max(streamed->height >> streamed->residentMip, 1u));
+            ImGui::Text("Requested mip: %u", streamed->wantedMip);
+            ImGui::Text("Resident size: %.2f MB",
+                        streamer->getResidentBytes(*streamed) / (1024.0f * 1024.0f));
+            ImGui::EndTooltip();
+          }
+        }
+
         // Setting up the drag and drop source for the filepath.
         if (ImGui::BeginDragDropSource())
         {
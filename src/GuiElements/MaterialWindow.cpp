@@ -116,6 +116,14 @@ namespace SciRenderer
               }
               this->DNDTarget(material, "normalMap");
               ImGui::PopID();
+
+              ImGui::Checkbox("Transparent", &material->isTransparent());
+              if (material->isTransparent())
+              {
+                auto& uOpacity = material->getFloat("uOpacity");
+                ImGui::Text("Opacity");
+                ImGui::SliderFloat("##Opacity", &uOpacity, 0.0f, 1.0f);
+              }
             }
           }
         }
@@ -153,7 +161,9 @@ namespace SciRenderer
         {
           case FileLoadTargets::TargetTexture:
           {
-            Texture2D::loadImageAsync(path);
+            Texture2DParams params = Texture2DParams();
+            params.isSRGB = this->selectedMatTex.second == "albedoMap";
+            Texture2D::loadImageAsync(path, params);
             this->selectedMatTex.first->attachSampler2D(this->selectedMatTex.second, name);
 
             this->selectedMatTex = std::make_pair(nullptr, "");
@@ -249,7 +259,9 @@ namespace SciRenderer
 
     if (filetype == ".jpg" || filetype == ".tga" || filetype == ".png")
     {
-      Texture2D::loadImageAsync(filepath);
+      Texture2DParams params = Texture2DParams();
+      params.isSRGB = this->selectedMatTex.second == "albedoMap";
+      Texture2D::loadImageAsync(filepath, params);
       this->selectedMatTex.first->attachSampler2D(this->selectedMatTex.second, filename);
     }
 
@@ -33,10 +33,58 @@ namespace SciRenderer
     ImGui::Text("Drawcalls: %u", stats->drawCalls);
     ImGui::Text("Total vertices: %u", stats->numVertices);
     ImGui::Text("Total triangles: %u", stats->numTriangles);
+    ImGui::Text("Instances: %u, uploaded: %u", storage->instances->getNumInstances(),
+                storage->instances->getNumUploaded());
     ImGui::Text("Total lights: D: %u, P: %u, S: %u", stats->numDirLights,
                 stats->numPointLights, stats->numSpotLights);
 
+    ImGui::Checkbox("Forward+", &state->isForward);
+    if (state->isForward)
+    {
+      const char* sampleNames[] = { "1x", "2x", "4x", "8x" };
+      int sampleIndex = (int) std::log2(state->msaaSamples);
+      if (ImGui::Combo("MSAA", &sampleIndex, sampleNames, 4))
+        state->msaaSamples = 1u << sampleIndex;
+      ImGui::Text("Light culling: %.3f ms", storage->forwardPlus->getTime());
+    }
+
     ImGui::Checkbox("Frustum Cull", &state->frustumCull);
+    ImGui::Checkbox("Occlusion Cull", &state->occlusionCull);
+    if (state->occlusionCull)
+      ImGui::Text("Hi-Z and culling: %.3f ms", storage->occlusionCuller->getTime());
+    ImGui::Checkbox("Depth Pre-pass", &state->depthPrePass);
+    ImGui::Text("Geometry pass: %.3f ms", storage->geometryTimer.getTime());
+    ImGui::Checkbox("Temporal AA", &state->temporalAA);
+    if (state->temporalAA)
+      ImGui::Text("TAA resolve: %.3f ms", storage->temporalAA->getTime());
+
+    const char* oitNames[] = { "Weighted Blended", "Linked Lists" };
+    int oitMode = static_cast<int>(state->oitMode);
+    if (ImGui::Combo("Transparency", &oitMode, oitNames, 2))
+      state->oitMode = static_cast<OITMode>(oitMode);
+    ImGui::Text("Transparency pass: %.3f ms", storage->transparencyTimer.getTime());
+
+    if (ImGui::CollapsingHeader("Dynamic Resolution"))
+    {
+      ImGui::Checkbox("Enable", &state->dynamicResolution);
+      ImGui::SliderFloat("Target Frame Time (ms)", &state->targetFrameTime, 4.0f, 50.0f);
+      ImGui::Text("Frame time: %.3f ms", storage->frameTimer.getTime());
+      ImGui::Text("Render size: %u x %u (%.0f%%)", storage->renderWidth,
+                  storage->renderHeight, storage->renderScale * 100.0f);
+      ImGui::PlotLines("Scale", storage->scaleHistory, RENDER_SCALE_HISTORY,
+                       storage->scaleHistoryOffset, nullptr, 0.5f, 1.0f,
+                       ImVec2(0.0f, 64.0f));
+    }
+
+    // Per-frame upload budget for streamed assets, in megabytes.
+    int uploadBudget = state->uploadBudget / (1024 * 1024);
+    if (ImGui::SliderInt("Upload Budget (MB)", &uploadBudget, 1, 256))
+      state->uploadBudget = uploadBudget * 1024 * 1024;
+
+    // Video memory budget for streamed texture mips, in megabytes.
+    int streamingBudget = state->streamingBudget;
+    if (ImGui::SliderInt("Texture Budget (MB)", &streamingBudget, 16, 8192))
+      state->streamingBudget = streamingBudget;
 
     if (ImGui::CollapsingHeader("Shadows"))
     {
@@ -85,6 +133,47 @@ namespace SciRenderer
       }
     }
 
+    if (ImGui::CollapsingHeader("Ambient Occlusion"))
+    {
+      const char* modeNames[] = { "Off", "Full Resolution", "Half Resolution" };
+      int mode = static_cast<int>(state->aoMode);
+      if (ImGui::Combo("AO Mode", &mode, modeNames, 3))
+        state->aoMode = static_cast<AOMode>(mode);
+
+      ImGui::SliderFloat("AO Radius", &state->aoRadius, 0.1f, 5.0f);
+      ImGui::SliderFloat("AO Power", &state->aoPower, 0.5f, 4.0f);
+
+      // The last time measured for each mode, switch between them to compare.
+      ImGui::Text("Full resolution: %.3f ms", storage->ambientOcclusion->getTime(AOMode::Full));
+      ImGui::Text("Half resolution: %.3f ms", storage->ambientOcclusion->getTime(AOMode::Half));
+    }
+
+    if (ImGui::CollapsingHeader("Post Processing"))
+    {
+      ImGui::Checkbox("Auto Exposure", &state->autoExposure);
+      ImGui::SliderFloat("Exposure Compensation (EV)", &state->exposureCompensation, -5.0f, 5.0f);
+      ImGui::SliderFloat("Adaptation Speed", &state->adaptationSpeed, 0.1f, 10.0f);
+      if (state->autoExposure)
+      {
+        // The histogram is read back from the GPU, only while it's shown.
+        static std::vector<GLfloat> histogram;
+        storage->autoExposure->getHistogram(histogram);
+        ImGui::Text("Luminance histogram (log2 %.0f to %.0f):",
+                    storage->autoExposure->getMinLogLuminance(),
+                    storage->autoExposure->getMaxLogLuminance());
+        ImGui::PlotHistogram("##Luminance", histogram.data(), histogram.size(), 0,
+                             nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 80.0f));
+        ImGui::Text("Exposure: %.3f ms", storage->autoExposure->getTime());
+      }
+
+      ImGui::Checkbox("Bloom", &state->bloom);
+      ImGui::SliderFloat("Bloom Intensity", &state->bloomIntensity, 0.0f, 0.5f);
+      if (state->bloom)
+        ImGui::Text("Bloom: %.3f ms", storage->bloom->getTime());
+
+      ImGui::Text("Tone mapping: %.3f ms", storage->toneMapTimer.getTime());
+    }
+
     if (ImGui::CollapsingHeader("Render Passes"))
     {
       auto bufferSize = storage->gBuffer.getSize();
@@ -96,6 +185,16 @@ namespace SciRenderer
       ImGui::Image((ImTextureID) (unsigned long) storage->lightingPass.getAttachID(FBOTargetParam::Colour0),
                    ImVec2(128.0f * ratio, 128.0f), ImVec2(0, 1), ImVec2(1, 0));
       ImGui::Separator();
+      ImGui::Text("Ambient Occlusion:");
+      ImGui::Separator();
+      ImGui::Image((ImTextureID) (unsigned long) storage->ambientOcclusion->getResultID(),
+                   ImVec2(128.0f * ratio, 128.0f), ImVec2(0, 1), ImVec2(1, 0));
+      ImGui::Separator();
+      ImGui::Text("Bloom:");
+      ImGui::Separator();
+      ImGui::Image((ImTextureID) (unsigned long) storage->bloom->getResultID(),
+                   ImVec2(128.0f * ratio, 128.0f), ImVec2(0, 1), ImVec2(1, 0));
+      ImGui::Separator();
       ImGui::Text("GBuffer:");
       ImGui::Separator();
       ImGui::Text("Positions:");
@@ -113,6 +212,9 @@ namespace SciRenderer
       ImGui::Text("Entity Mask:");
       ImGui::Image((ImTextureID) (unsigned long) storage->gBuffer.getAttachmentID(FBOTargetParam::Colour4),
                    ImVec2(128.0f * ratio, 128.0f), ImVec2(0, 1), ImVec2(1, 0));
+      ImGui::Text("Velocity:");
+      ImGui::Image((ImTextureID) (unsigned long) storage->gBuffer.getAttachmentID(FBOTargetParam::Colour5),
+                   ImVec2(128.0f * ratio, 128.0f), ImVec2(0, 1), ImVec2(1, 0));
       ImGui::Text("Depth:");
       ImGui::Image((ImTextureID) (unsigned long) storage->gBuffer.getAttachmentID(FBOTargetParam::Depth),
                    ImVec2(128.0f * ratio, 128.0f), ImVec2(0, 1), ImVec2(1, 0));
@@ -121,9 +223,7 @@ namespace SciRenderer
     if (ImGui::CollapsingHeader("Environment Map"))
     {
       int skyboxWidth = state->skyboxWidth;
-      int irradianceWidth = state->irradianceWidth;
       int prefilterWidth = state->prefilterWidth;
-      int prefilterSamples = state->prefilterSamples;
 
       if (ImGui::Button("Recompute Environment Map"))
       {
@@ -131,8 +231,9 @@ namespace SciRenderer
 
         ambient->unloadComputedMaps();
         ambient->equiToCubeMap(true, state->skyboxWidth, state->skyboxWidth);
-        ambient->precomputeIrradiance(state->irradianceWidth, state->irradianceWidth, true);
-        ambient->precomputeSpecular(state->prefilterWidth, state->prefilterWidth, true);
+        ambient->precomputeIrradiance(true);
+        ambient->precomputeSpecular(state->prefilterWidth, state->prefilterWidth, true,
+                                    state->prefilterSamples);
       }
 
       if (ImGui::InputInt("Skybox Size", &skyboxWidth))
@@ -154,26 +255,7 @@ namespace SciRenderer
         state->skyboxWidth = skyboxWidth;
       }
 
-      if (ImGui::InputInt("Irradiance Map Quality", &irradianceWidth))
-      {
-        irradianceWidth = irradianceWidth > 512 ? 512 : irradianceWidth;
-        irradianceWidth = irradianceWidth < 64 ? 64 : irradianceWidth;
-
-        // Compute the next or previous power of 2 and set the int to that.
-        if (irradianceWidth - (int) state->irradianceWidth < 0)
-        {
-          irradianceWidth = std::pow(2, std::floor(std::log2(irradianceWidth)));
-        }
-        else if (irradianceWidth - (int) state->irradianceWidth > 0)
-        {
-          irradianceWidth = std::pow(2, std::floor(std::log2(irradianceWidth)) + 1);
-        }
-
-        irradianceWidth = std::pow(2, std::floor(std::log2(irradianceWidth)));
-        state->irradianceWidth = irradianceWidth;
-      }
-
-      if (ImGui::InputInt("IBL Prefilter Quality", &prefilterWidth))
+      if (ImGui::InputInt("IBL Prefilter Size", &prefilterWidth))
       {
         prefilterWidth = prefilterWidth > 2048 ? 2048 : prefilterWidth;
         prefilterWidth = prefilterWidth < 512 ? 512 : prefilterWidth;
@@ -192,24 +274,24 @@ namespace SciRenderer
         state->prefilterWidth = prefilterWidth;
       }
 
-      if (ImGui::InputInt("IBL Prefilter Samples", &prefilterSamples))
-      {
-        prefilterSamples = prefilterSamples > 2048 ? 2048 : prefilterSamples;
-        prefilterSamples = prefilterSamples < 512 ? 512 : prefilterSamples;
+      // Quality tiers of the prefilter, by samples per texel.
+      const char* tierNames[] = { "Fast", "Medium", "High" };
+      const GLuint tierSamples[] = { static_cast<GLuint>(PrefilterQuality::Fast),
+                                     static_cast<GLuint>(PrefilterQuality::Medium),
+                                     static_cast<GLuint>(PrefilterQuality::High) };
+      int tier = 0;
+      for (int i = 0; i < 3; i++)
+        if (tierSamples[i] <= state->prefilterSamples)
+          tier = i;
 
-        // Compute the next or previous power of 2 and set the int to that.
-        if (prefilterSamples - (int) state->prefilterSamples < 0)
-        {
-          prefilterSamples = std::pow(2, std::floor(std::log2(prefilterSamples)));
-        }
-        else if (prefilterSamples - (int) state->prefilterSamples > 0)
-        {
-          prefilterSamples = std::pow(2, std::floor(std::log2(prefilterSamples)) + 1);
-        }
+      if (ImGui::Combo("IBL Prefilter Quality", &tier, tierNames, 3))
+        state->prefilterSamples = tierSamples[tier];
 
-        prefilterSamples = std::pow(2, std::floor(std::log2(prefilterSamples)));
-        state->prefilterSamples = prefilterSamples;
-      }
+      if (ImGui::Button("Benchmark Prefilter Quality"))
+        Renderer3D::getStorage()->currentEnvironment->benchmarkPrefilter();
+
+      if (ImGui::Button("Rebake Reflection Probes"))
+        Renderer3D::getStorage()->reflectionProbes->markAllDirty();
     }
 
     ImGui::End();
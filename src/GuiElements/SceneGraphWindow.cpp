@@ -213,6 +213,13 @@ namespace SciRenderer
           light.addComponent<AmbientComponent>();
         }
 
+        if (ImGui::MenuItem("Reflection Probe"))
+        {
+          auto probe = activeScene->createEntity("New Reflection Probe");
+          probe.addComponent<TransformComponent>();
+          probe.addComponent<ReflectionProbeComponent>();
+        }
+
         ImGui::EndMenu();
       }
 
@@ -272,11 +279,16 @@ namespace SciRenderer
             auto modelAssets = AssetManager<Model>::getManager();
 
             // If it already has a mesh component, remove it and add a new one.
+            // Keep the import settings.
+            ModelImportFlags importFlags = ModelImportFlags_Default;
             if (this->selectedEntity.hasComponent<RenderableComponent>())
+            {
+              importFlags = this->selectedEntity.getComponent<RenderableComponent>().importFlags;
               this->selectedEntity.removeComponent<RenderableComponent>();
+            }
 
-            auto& renderable = this->selectedEntity.addComponent<RenderableComponent>(name);
-            Model::asyncLoadModel(path, name, &renderable.materials);
+            auto& renderable = this->selectedEntity.addComponent<RenderableComponent>(name, importFlags);
+            Model::asyncLoadModel(path, name, &renderable.materials, importFlags);
 
             this->fileTargets = FileLoadTargets::TargetNone;
             break;
@@ -291,17 +303,22 @@ namespace SciRenderer
               ambient.ambient->unloadEnvironment();
               ambient.ambient->loadEquirectangularMap(path);
               ambient.ambient->equiToCubeMap(true, 2048, 2048);
-              ambient.ambient->precomputeIrradiance(512, 512, true);
-              ambient.ambient->precomputeSpecular(2048, 2048, true);
+              ambient.ambient->precomputeIrradiance(true);
+              ambient.ambient->precomputeSpecular(2048, 2048, true,
+                                                  Renderer3D::getState()->prefilterSamples);
             }
             else
             {
               ambient.ambient->loadEquirectangularMap(path);
               ambient.ambient->equiToCubeMap(true, 2048, 2048);
-              ambient.ambient->precomputeIrradiance(512, 512, true);
-              ambient.ambient->precomputeSpecular(2048, 2048, true);
+              ambient.ambient->precomputeIrradiance(true);
+              ambient.ambient->precomputeSpecular(2048, 2048, true,
+                                                  Renderer3D::getState()->prefilterSamples);
             }
 
+            // The probes captured the old environment.
+            Renderer3D::getStorage()->reflectionProbes->markAllDirty();
+
             this->fileTargets = FileLoadTargets::TargetNone;
             break;
           }
@@ -378,6 +395,7 @@ namespace SciRenderer
         drawComponentAdd<PointLightComponent>("Point Light Component", entity);
         drawComponentAdd<SpotLightComponent>("Spot Light Component", entity);
         drawComponentAdd<AmbientComponent>("Ambient Light Component", entity);
+        drawComponentAdd<ReflectionProbeComponent>("Reflection Probe Component", entity);
 
         ImGui::EndMenu();
       }
@@ -391,6 +409,7 @@ namespace SciRenderer
         drawComponentRemove<PointLightComponent>("Point Light Component", entity);
         drawComponentRemove<SpotLightComponent>("Spot Light Component", entity);
         drawComponentRemove<AmbientComponent>("Ambient Light Component", entity);
+        drawComponentRemove<ReflectionProbeComponent>("Reflection Probe Component", entity);
 
         ImGui::EndMenu();
       }
@@ -431,6 +450,13 @@ namespace SciRenderer
             light.addComponent<AmbientComponent>();
           }
 
+          if (ImGui::MenuItem("Reflection Probe"))
+          {
+            auto probe = createChildEntity(entity, activeScene, "New Reflection Probe");
+            probe.addComponent<TransformComponent>();
+            probe.addComponent<ReflectionProbeComponent>();
+          }
+
           ImGui::EndMenu();
         }
 
@@ -450,6 +476,7 @@ namespace SciRenderer
         copyComponent<DirectionalLightComponent>(entity, newEntity);
         copyComponent<PointLightComponent>(entity, newEntity);
         copyComponent<SpotLightComponent>(entity, newEntity);
+        copyComponent<ReflectionProbeComponent>(entity, newEntity);
       }
 
       if (ImGui::MenuItem("Register as PreFab"))
@@ -539,6 +566,10 @@ namespace SciRenderer
     {
       ImGui::TreeNodeEx("Ambient Light Componenet", leafFlag);
     }
+    if (entity.hasComponent<ReflectionProbeComponent>())
+    {
+      ImGui::TreeNodeEx("Reflection Probe Componenet", leafFlag);
+    }
   }
 
   // The property panel for an entity.
@@ -617,6 +648,22 @@ namespace SciRenderer
         if (ImGui::Button("Select New Mesh"))
           showMeshWindow = true;
 
+        // Importer settings, applied the next time the model is loaded.
+        if (ImGui::TreeNode("Import Settings"))
+        {
+          ImGui::CheckboxFlags("Generate Normals", &component.importFlags,
+                               ModelImportFlags_GenNormals);
+          ImGui::CheckboxFlags("Generate Tangents", &component.importFlags,
+                               ModelImportFlags_GenTangents);
+          ImGui::CheckboxFlags("Join Identical Vertices", &component.importFlags,
+                               ModelImportFlags_JoinVertices);
+          ImGui::CheckboxFlags("Generate UVs", &component.importFlags,
+                               ModelImportFlags_GenUVs);
+          ImGui::CheckboxFlags("Optimize Meshes", &component.importFlags,
+                               ModelImportFlags_OptimizeMeshes);
+          ImGui::TreePop();
+        }
+
         if (showMeshWindow)
           this->drawMeshWindow(showMeshWindow);
       });
@@ -714,6 +761,30 @@ namespace SciRenderer
           this->fileTargets = FileLoadTargets::TargetEnvironment;
         }
       });
+
+      drawComponentProperties<ReflectionProbeComponent>("Reflection Probe Component",
+        this->selectedEntity, [this](auto& component)
+      {
+        ImGui::PushID("ReflectionProbe");
+        const char* shapeNames[] = { "Box", "Sphere" };
+        int shape = static_cast<int>(component.probe.shape);
+        if (ImGui::Combo("Shape", &shape, shapeNames, 2))
+          component.probe.shape = static_cast<ProbeShape>(shape);
+
+        Styles::drawVec3Controls("Position", glm::vec3(0.0f), component.probe.position);
+        if (component.probe.shape == ProbeShape::Box)
+          Styles::drawVec3Controls("Extents", glm::vec3(5.0f), component.probe.extents,
+                                   0.0f, 0.1f, 0.0f, 100.0f);
+        else
+          Styles::drawFloatControl("Radius", 5.0f, component.probe.extents.x,
+                                   0.0f, 0.1f, 0.0f, 100.0f);
+        Styles::drawFloatControl("Blend Distance", 1.0f, component.probe.blendDistance,
+                                 0.0f, 0.1f, 0.01f, 100.0f);
+
+        if (ImGui::Button("Rebake"))
+          component.probe.dirty = true;
+        ImGui::PopID();
+      });
     }
 
     ImGui::End();
@@ -734,12 +805,16 @@ namespace SciRenderer
     if (filetype == ".obj" || filetype == ".FBX" || filetype == ".fbx")
     {
       // If it already has a mesh component, remove it and add a new one.
-      // Otherwise just add a component.
+      // Otherwise just add a component. Keep the import settings.
+      ModelImportFlags importFlags = ModelImportFlags_Default;
       if (this->selectedEntity.hasComponent<RenderableComponent>())
+      {
+        importFlags = this->selectedEntity.getComponent<RenderableComponent>().importFlags;
         this->selectedEntity.removeComponent<RenderableComponent>();
+      }
 
-      auto& renderable = this->selectedEntity.addComponent<RenderableComponent>(filename);
-      Model::asyncLoadModel(filepath, filename, &renderable.materials);
+      auto& renderable = this->selectedEntity.addComponent<RenderableComponent>(filename, importFlags);
+      Model::asyncLoadModel(filepath, filename, &renderable.materials, importFlags);
     }
   }
 
@@ -105,8 +105,12 @@ namespace SciRenderer
         }
 
         // Display the shader information string.
+        // Don't stall the editor on a rebuild the driver is still working on.
         ImGui::Text("Shader information:");
-        ImGui::Text(this->selectedShader->getInfoString().c_str());
+        if (this->selectedShader->isReady())
+          ImGui::Text(this->selectedShader->getInfoString().c_str());
+        else
+          ImGui::Text("Compiling...");
         ImGui::Unindent();
 
         ImGui::TreePop();
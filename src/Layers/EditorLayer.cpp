@@ -194,7 +194,8 @@ namespace SciRenderer
     this->currentScene->onUpdate(dt);
 
     // Draw the scene.
-    Renderer3D::begin(this->editorSize.x, this->editorSize.y, this->editorCam, false);
+    Renderer3D::begin(this->editorSize.x, this->editorSize.y, this->editorCam,
+                      Renderer3D::getState()->isForward);
     this->currentScene->render(this->editorCam, selectedEntity);
     Renderer3D::end(this->drawBuffer);
 
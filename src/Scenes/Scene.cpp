@@ -65,6 +65,17 @@ namespace SciRenderer
       Renderer3D::submit(spot, transform);
     }
 
+    // Submit the reflection probes. The renderer rebakes them when they move,
+    // or once the dirty flag has been picked up.
+    auto probes = this->sceneECS.view<ReflectionProbeComponent, TransformComponent>();
+    for (auto entity : probes)
+    {
+      auto [probe, transform] = probes.get<ReflectionProbeComponent, TransformComponent>(entity);
+      probe.probe.id = (GLuint) entity;
+      Renderer3D::submit(probe, transform);
+      probe.probe.dirty = false;
+    }
+
     // Group together the transform and renderable components.
     auto drawables = this->sceneECS.group<RenderableComponent>(entt::get<TransformComponent>);
     for (auto entity : drawables)
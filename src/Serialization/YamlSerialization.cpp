@@ -138,6 +138,7 @@ namespace SciRenderer
 
       // Save the submesh which this acts on.
       out << YAML::Key << "AssociatedSubmesh" << YAML::Value << pair.first;
+      out << YAML::Key << "Transparent" << YAML::Value << pair.second.isTransparent();
 
       out << YAML::Key << "Floats";
       out << YAML::BeginSeq;
@@ -262,6 +263,7 @@ namespace SciRenderer
           // Serialize the model path and name.
           out << YAML::Key << "ModelPath" << YAML::Value << model->getFilepath();
           out << YAML::Key << "ModelName" << YAML::Value << component.meshName;
+          out << YAML::Key << "ImportFlags" << YAML::Value << component.importFlags;
 
           // TODO: Serialize materials.
           out << YAML::Key << "Material";
@@ -333,6 +335,20 @@ namespace SciRenderer
         out << YAML::EndMap;
       }
 
+      if (entity.hasComponent<ReflectionProbeComponent>())
+      {
+        out << YAML::Key << "ReflectionProbeComponent";
+        out << YAML::BeginMap;
+
+        auto& component = entity.getComponent<ReflectionProbeComponent>();
+        out << YAML::Key << "Position" << YAML::Value << component.probe.position;
+        out << YAML::Key << "Extents" << YAML::Value << component.probe.extents;
+        out << YAML::Key << "BlendDistance" << YAML::Value << component.probe.blendDistance;
+        out << YAML::Key << "Shape" << YAML::Value << static_cast<GLuint>(component.probe.shape);
+
+        out << YAML::EndMap;
+      }
+
       if (entity.hasComponent<AmbientComponent>())
       {
         out << YAML::Key << "AmbientComponent";
@@ -342,7 +358,6 @@ namespace SciRenderer
         auto state = Renderer3D::getState();
         out << YAML::Key << "IBLPath" << YAML::Value << component.ambient->getFilepath();
         out << YAML::Key << "EnviRes" << YAML::Value << state->skyboxWidth;
-        out << YAML::Key << "IrraRes" << YAML::Value << state->irradianceWidth;
         out << YAML::Key << "FiltRes" << YAML::Value << state->prefilterWidth;
         out << YAML::Key << "FiltSam" << YAML::Value << state->prefilterSamples;
         out << YAML::Key << "IBLRough" << YAML::Value << component.ambient->getRoughness();
@@ -383,7 +398,17 @@ namespace SciRenderer
       out << YAML::BeginMap;
       out << YAML::Key << "BasicSettings";
       out << YAML::BeginMap;
+      out << YAML::Key << "ForwardRendering" << YAML::Value << state->isForward;
+      out << YAML::Key << "MSAASamples" << YAML::Value << state->msaaSamples;
       out << YAML::Key << "FrustumCull" << YAML::Value << state->frustumCull;
+      out << YAML::Key << "OcclusionCull" << YAML::Value << state->occlusionCull;
+      out << YAML::Key << "DepthPrePass" << YAML::Value << state->depthPrePass;
+      out << YAML::Key << "TemporalAA" << YAML::Value << state->temporalAA;
+      out << YAML::Key << "TransparencyMode" << YAML::Value << static_cast<GLuint>(state->oitMode);
+      out << YAML::Key << "DynamicResolution" << YAML::Value << state->dynamicResolution;
+      out << YAML::Key << "TargetFrameTime" << YAML::Value << state->targetFrameTime;
+      out << YAML::Key << "UploadBudget" << YAML::Value << state->uploadBudget;
+      out << YAML::Key << "StreamingBudget" << YAML::Value << state->streamingBudget;
       out << YAML::EndMap;
 
       out << YAML::Key << "ShadowSettings";
@@ -393,6 +418,22 @@ namespace SciRenderer
       out << YAML::Key << "CascadeLightBleed" << YAML::Value << state->bleedReduction;
       out << YAML::EndMap;
 
+      out << YAML::Key << "AOSettings";
+      out << YAML::BeginMap;
+      out << YAML::Key << "Mode" << YAML::Value << static_cast<GLuint>(state->aoMode);
+      out << YAML::Key << "Radius" << YAML::Value << state->aoRadius;
+      out << YAML::Key << "Power" << YAML::Value << state->aoPower;
+      out << YAML::EndMap;
+
+      out << YAML::Key << "PostSettings";
+      out << YAML::BeginMap;
+      out << YAML::Key << "AutoExposure" << YAML::Value << state->autoExposure;
+      out << YAML::Key << "ExposureCompensation" << YAML::Value << state->exposureCompensation;
+      out << YAML::Key << "AdaptationSpeed" << YAML::Value << state->adaptationSpeed;
+      out << YAML::Key << "Bloom" << YAML::Value << state->bloom;
+      out << YAML::Key << "BloomIntensity" << YAML::Value << state->bloomIntensity;
+      out << YAML::EndMap;
+
       out << YAML::EndMap;
 
       out << YAML::EndMap;
@@ -441,6 +482,10 @@ namespace SciRenderer
 
         auto meshMaterial = modelMaterial.getMaterial(submeshName);
 
+        auto transparent = mat["Transparent"];
+        if (transparent)
+          meshMaterial->isTransparent() = transparent.as<bool>();
+
         auto floats = mat["Floats"];
         if (floats)
         {
@@ -485,7 +530,9 @@ namespace SciRenderer
               if (uSampler2D["ImagePath"].as<std::string>() == "")
                 continue;
 
-              Texture2D::loadImageAsync(uSampler2D["ImagePath"].as<std::string>());
+              Texture2DParams params = Texture2DParams();
+              params.isSRGB = uName.as<std::string>() == "albedoMap";
+              Texture2D::loadImageAsync(uSampler2D["ImagePath"].as<std::string>(), params);
               meshMaterial->attachSampler2D(uSampler2D["SamplerName"].as<std::string>(),
                                             uSampler2D["SamplerHandle"].as<std::string>());
             }
@@ -551,7 +598,11 @@ namespace SciRenderer
       {
         std::string modelPath = renderableComponent["ModelPath"].as<std::string>();
         std::string modelName = renderableComponent["ModelName"].as<std::string>();
-        auto& rComponent = newEntity.addComponent<RenderableComponent>(modelName);
+
+        ModelImportFlags importFlags = ModelImportFlags_Default;
+        if (renderableComponent["ImportFlags"])
+          importFlags = renderableComponent["ImportFlags"].as<int>();
+        auto& rComponent = newEntity.addComponent<RenderableComponent>(modelName, importFlags);
 
         // If the path is "None" its an internal model asset.
         // TODO: Handle internals separately.
@@ -561,7 +612,7 @@ namespace SciRenderer
           if (materials)
             for (auto mat : materials)
               deserializeMaterial(mat, newEntity);
-          Model::asyncLoadModel(modelPath, modelName, &rComponent.materials);
+          Model::asyncLoadModel(modelPath, modelName, &rComponent.materials, importFlags);
         }
       }
 
@@ -601,6 +652,16 @@ namespace SciRenderer
         sComponent.light.castShadows = spotComponent["CastShadows"].as<bool>();
       }
 
+      auto probeComponent = entity["ReflectionProbeComponent"];
+      if (probeComponent)
+      {
+        auto& rComponent = newEntity.addComponent<ReflectionProbeComponent>();
+        rComponent.probe.position = probeComponent["Position"].as<glm::vec3>();
+        rComponent.probe.extents = probeComponent["Extents"].as<glm::vec3>();
+        rComponent.probe.blendDistance = probeComponent["BlendDistance"].as<GLfloat>();
+        rComponent.probe.shape = static_cast<ProbeShape>(probeComponent["Shape"].as<GLuint>());
+      }
+
       auto ambientComponent = entity["AmbientComponent"];
       if (ambientComponent)
       {
@@ -609,7 +670,6 @@ namespace SciRenderer
 
         std::string iblImagePath = ambientComponent["IBLPath"].as<std::string>();
         state->skyboxWidth = ambientComponent["EnviRes"].as<GLuint>();
-        state->irradianceWidth = ambientComponent["IrraRes"].as<GLuint>();
         state->prefilterWidth = ambientComponent["FiltRes"].as<GLuint>();
         state->prefilterSamples = ambientComponent["FiltSam"].as<GLuint>();
         storage->currentEnvironment->unloadEnvironment();
@@ -646,6 +706,26 @@ namespace SciRenderer
         if (basicSettings)
         {
           state->frustumCull = basicSettings["FrustumCull"].as<bool>();
+          if (basicSettings["ForwardRendering"])
+            state->isForward = basicSettings["ForwardRendering"].as<bool>();
+          if (basicSettings["MSAASamples"])
+            state->msaaSamples = basicSettings["MSAASamples"].as<GLuint>();
+          if (basicSettings["OcclusionCull"])
+            state->occlusionCull = basicSettings["OcclusionCull"].as<bool>();
+          if (basicSettings["DepthPrePass"])
+            state->depthPrePass = basicSettings["DepthPrePass"].as<bool>();
+          if (basicSettings["TemporalAA"])
+            state->temporalAA = basicSettings["TemporalAA"].as<bool>();
+          if (basicSettings["TransparencyMode"])
+            state->oitMode = static_cast<OITMode>(basicSettings["TransparencyMode"].as<GLuint>());
+          if (basicSettings["DynamicResolution"])
+            state->dynamicResolution = basicSettings["DynamicResolution"].as<bool>();
+          if (basicSettings["TargetFrameTime"])
+            state->targetFrameTime = basicSettings["TargetFrameTime"].as<GLfloat>();
+          if (basicSettings["UploadBudget"])
+            state->uploadBudget = basicSettings["UploadBudget"].as<GLuint>();
+          if (basicSettings["StreamingBudget"])
+            state->streamingBudget = basicSettings["StreamingBudget"].as<GLuint>();
         }
 
         auto shadowSettings = rendererSettings["ShadowSettings"];
@@ -655,6 +735,24 @@ namespace SciRenderer
           state->cascadeSize = shadowSettings["CascadeSize"].as<GLuint>();
           state->bleedReduction = shadowSettings["CascadeLightBleed"].as<GLfloat>();
         }
+
+        auto aoSettings = rendererSettings["AOSettings"];
+        if (aoSettings)
+        {
+          state->aoMode = static_cast<AOMode>(aoSettings["Mode"].as<GLuint>());
+          state->aoRadius = aoSettings["Radius"].as<GLfloat>();
+          state->aoPower = aoSettings["Power"].as<GLfloat>();
+        }
+
+        auto postSettings = rendererSettings["PostSettings"];
+        if (postSettings)
+        {
+          state->autoExposure = postSettings["AutoExposure"].as<bool>();
+          state->exposureCompensation = postSettings["ExposureCompensation"].as<GLfloat>();
+          state->adaptationSpeed = postSettings["AdaptationSpeed"].as<GLfloat>();
+          state->bloom = postSettings["Bloom"].as<bool>();
+          state->bloomIntensity = postSettings["BloomIntensity"].as<GLfloat>();
+        }
       }
 
       return true;